@@ -0,0 +1,79 @@
+// Micro-benchmark for rate-limit detection over large CLI outputs.
+// Compares the compiled single-pass ExhaustionMatcher with the previous check, which
+// built a pattern vector and ran one find() per pattern over the whole output.
+// Not part of the test suite; run ./GemStackBenchExhaustion [megabytes].
+#include <ExhaustionMatcher.h>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+// The previous isModelExhausted()
+static bool findEachPattern(const std::string& output) {
+    const std::vector<std::string> exhaustionPatterns = {
+        "rate limit", "Rate limit", "RATE_LIMIT", "quota exceeded", "Quota exceeded", "QUOTA_EXCEEDED",
+        "resource exhausted", "Resource exhausted", "RESOURCE_EXHAUSTED", "too many requests",
+        "Too many requests", "429", "limit reached", "exhausted"
+    };
+    for (const auto& pattern : exhaustionPatterns) {
+        if (output.find(pattern) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void report(const std::string& name, size_t bytes, int runs, std::chrono::steady_clock::duration elapsed,
+                   bool matched) {
+    double seconds = std::chrono::duration<double>(elapsed).count() / runs;
+    double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    std::cerr << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << megabytes << " MB " << std::setw(10) << (seconds * 1000.0) << " ms "
+              << std::setw(10) << (megabytes / seconds) << " MB/s   " << (matched ? "exhausted" : "clean")
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int megabytes = argc > 1 ? std::atoi(argv[1]) : 16;
+    if (megabytes <= 0) {
+        megabytes = 16;
+    }
+
+    // Agent output with none of the patterns: the worst case for both, since nothing stops early
+    const std::vector<std::string> lines = {
+        "Reading src/GemStackCore.cpp to understand the queue loader...\n",
+        "Applying edit to include/TaskGraph.h (12 lines changed)\n",
+        "$ cmake --build build -j8\n",
+        "[ 42%] Building CXX object CMakeFiles/GemStackCore.dir/src/ProcessReactor.cpp.o\n",
+        "All 216 tests passed in 5.7 seconds\n",
+    };
+    std::string clean;
+    size_t target = static_cast<size_t>(megabytes) * 1024 * 1024;
+    for (size_t i = 0; clean.size() < target; i++) {
+        clean += lines[i % lines.size()];
+    }
+    // The same output with a real error at the very end, as a failed CLI run prints it
+    std::string failed = clean + "Error: [429 Too Many Requests] Resource has been exhausted (e.g. check quota).\n";
+
+    const ExhaustionMatcher& matcher = exhaustionMatcher();
+    const int runs = 5;
+    using Clock = std::chrono::steady_clock;
+
+    for (const std::string* output : {&clean, &failed}) {
+        bool matched = false;
+        auto start = Clock::now();
+        for (int i = 0; i < runs; i++) {
+            matched = findEachPattern(*output);
+        }
+        report("find() per pattern", output->size(), runs, Clock::now() - start, matched);
+
+        start = Clock::now();
+        for (int i = 0; i < runs; i++) {
+            matched = matcher.classify(*output) != ExhaustionKind::None;
+        }
+        report("ExhaustionMatcher", output->size(), runs, Clock::now() - start, matched);
+    }
+    return 0;
+}
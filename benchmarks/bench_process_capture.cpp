@@ -0,0 +1,106 @@
+// Micro-benchmark for ProcessExecutor and ProcessReactor output capture throughput.
+// Spawns a child that writes a fixed number of bytes and reports the MB/s each capture
+// path sustains, and how often it flushed the console echo. Not part of the test suite;
+// run ./GemStackBenchCapture [megabytes].
+#include <ProcessExecutor.h>
+#include <ProcessReactor.h>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+// Discards everything written to it, so echo cost is measured without a terminal.
+// Counts flushes, each of which would be a write() to a real console.
+class NullBuffer : public std::streambuf {
+public:
+    size_t flushes = 0;
+
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+    int sync() override {
+        flushes++;
+        return 0;
+    }
+};
+
+// The previous capture loop: fgets into a 256-byte buffer, one std::string and cout call per chunk
+static size_t captureWithFgets(const std::string& command) {
+    std::string output;
+    std::array<char, 256> buffer;
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        return 0;
+    }
+    while (fgets(buffer.data(), buffer.size(), pipe) != nullptr) {
+        std::string chunk = buffer.data();
+        output += chunk;
+        std::cout << chunk;
+    }
+    pclose(pipe);
+    return output.size();
+}
+
+static void report(const std::string& name, size_t bytes, std::chrono::steady_clock::duration elapsed,
+                   size_t flushes) {
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    std::cerr << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << megabytes << " MB " << std::setw(10) << (seconds * 1000.0) << " ms "
+              << std::setw(10) << (megabytes / seconds) << " MB/s " << std::setw(8) << flushes << " flushes"
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    int megabytes = argc > 1 ? std::atoi(argv[1]) : 256;
+    if (megabytes <= 0) {
+        megabytes = 256;
+    }
+
+    // Line-oriented output, like verbose agent/tool logs. Written to a file first so the
+    // child is just 'cat' and the numbers reflect the capture side, not the producer.
+    std::string dataFile = "GemStackBenchCapture.tmp";
+    std::string prepare = "yes 'GemStack benchmark line of tool output ..............................' | head -c " +
+                          std::to_string(static_cast<long long>(megabytes) * 1024 * 1024) + " > " + dataFile;
+    if (std::system(prepare.c_str()) != 0) {
+        std::cerr << "Failed to create " << dataFile << std::endl;
+        return 1;
+    }
+    std::string generator = "cat " + dataFile;
+
+    NullBuffer nullBuffer;
+    std::streambuf* original = std::cout.rdbuf(&nullBuffer);
+
+    std::vector<std::string> argvCommand = {"sh", "-c", generator};
+    using Clock = std::chrono::steady_clock;
+
+    // Time one capture and count the echo flushes it caused
+    auto measure = [&](const std::string& name, const std::function<size_t()>& capture) {
+        nullBuffer.flushes = 0;
+        auto start = Clock::now();
+        size_t bytes = capture();
+        report(name, bytes, Clock::now() - start, nullBuffer.flushes);
+    };
+
+    measure("fgets 256B (previous)", [&]() { return captureWithFgets(generator + " 2>&1"); });
+    measure("execute(string), echo", [&]() { return ProcessExecutor::execute(generator).second.size(); });
+    measure("execute(argv), echo", [&]() { return ProcessExecutor::execute(argvCommand).output.size(); });
+
+    ProcessOptions quiet;
+    quiet.echoOutput = false;
+    measure("execute(argv), no echo", [&]() { return ProcessExecutor::execute(argvCommand, quiet).output.size(); });
+
+    // The path prompts take: one reactor thread draining every child
+    ProcessReactor reactor;
+    measure("reactor, echo", [&]() { return reactor.start(argvCommand).wait().output.size(); });
+    measure("reactor, no echo", [&]() { return reactor.start(argvCommand, quiet).wait().output.size(); });
+
+    std::cout.rdbuf(original);
+    std::remove(dataFile.c_str());
+    return 0;
+}
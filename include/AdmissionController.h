@@ -0,0 +1,120 @@
+#ifndef ADMISSION_CONTROLLER_H
+#define ADMISSION_CONTROLLER_H
+
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+// When the host counts as saturated. Zero disables a check.
+struct AdmissionLimits {
+    double maxLoadPerCpu = 0;    // 1-minute load average divided by the number of CPUs
+    int minFreeMemoryMB = 0;     // Memory the kernel reports as available
+    int maxRunningChildren = 0;  // Prompts (Gemini CLI children) running at once
+};
+
+// A snapshot of how busy the host is
+struct HostLoad {
+    double loadAverage = -1;           // 1-minute load average (-1 = unknown)
+    int cpuCount = 1;
+    long long availableMemoryMB = -1;  // MemAvailable (-1 = unknown)
+};
+
+using HostProbe = std::function<HostLoad()>;
+
+// Read the current load: /proc/loadavg and /proc/meminfo on Linux, getloadavg() on other
+// Unix systems. Whatever can't be read is reported as unknown and never holds launches back.
+HostLoad readHostLoad();
+
+// Gates new CLI launches on host headroom. Each Gemini child can run builds, tests and
+// package installs through its tool calls, so a burst of them can swamp a shared machine;
+// workers call acquire() before starting a prompt and release() once it is done.
+// One prompt is always admitted when none is running, so the queue keeps moving however
+// busy other users keep the host.
+//
+// Optionally the number of prompts in flight also follows an adaptive limit driven by
+// rate-limit feedback (AIMD): it grows by one after a full window of successes and is cut
+// by decreaseFactor when a prompt is rate limited, finding what the quota sustains.
+class AdmissionController {
+public:
+    using LimitListener = std::function<void(int limit)>;
+
+    explicit AdmissionController(AdmissionLimits limits = {}, HostProbe probe = readHostLoad);
+
+    // Prevent copying
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+
+    void setLimits(const AdmissionLimits& limits);
+    AdmissionLimits getLimits() const;
+
+    // True if any limit is set
+    bool enabled() const;
+
+    // Start adapting the in-flight limit, from initial up to at most maximum
+    void enableAdaptiveLimit(int initial, int maximum, double decreaseFactor = 0.5);
+
+    // Block until there is headroom for another child, then count it as running.
+    // Returns the admission window to pass to recordRateLimit() for this child, or
+    // nothing (and admits nothing) once cancel() has been called.
+    std::optional<uint64_t> acquire();
+
+    // A child admitted by acquire() has finished
+    void release();
+
+    // Children admitted and not yet released
+    int running() const;
+
+    // Rate-limit feedback for the adaptive limit (ignored unless it is enabled).
+    // A success raises the limit by 1/limit. A rate limit cuts it, once per window: children
+    // admitted before the last cut were launched under the old limit, so their 429s are
+    // the same congestion event and don't cut again. Returns true if the limit was cut.
+    void recordSuccess();
+    bool recordRateLimit(uint64_t window);
+
+    int adaptiveLimit() const;  // Current adaptive limit (0 = not adaptive)
+    int peakAdaptiveLimit() const;
+    int adaptiveCuts() const;   // Times the limit was cut
+
+    // Called with the new limit whenever the adaptive limit changes
+    void setLimitListener(LimitListener listener);
+
+    // Why a launch would be held back under this load ("" if it would be admitted)
+    std::string saturationReason(const HostLoad& load) const;
+
+    // How often a waiting acquire() re-reads the host load (default 1s)
+    void setPollInterval(std::chrono::milliseconds interval);
+
+    // Shut down: end waiting acquire() calls and make later ones return nothing
+    void cancel();
+    bool cancelled() const;
+
+    // Admit again (tests, or a new run in the same process)
+    void reset();
+
+private:
+    std::string saturationReasonLocked(const HostLoad& load) const;
+    void limitChanged(int limit, bool raised);
+
+    AdmissionLimits limits;
+    HostProbe probe;
+    std::chrono::milliseconds pollInterval{1000};
+    int runningChildren = 0;
+
+    bool adaptive = false;
+    double currentLimit = 0;  // Fractional so increases can accumulate over a window
+    int maximumLimit = 0;
+    int peakLimit = 0;
+    double decreaseFactor = 0.5;
+    uint64_t cuts = 0;
+    LimitListener listener;
+    bool stopped = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable released;
+};
+
+#endif // ADMISSION_CONTROLLER_H
@@ -11,11 +11,19 @@ public:
     // Get the path to the CLI executable/script
     static std::string getGeminiCliPath();
 
+    // Get the path to the warm worker wrapper written next to the CLI ("" if unavailable)
+    static std::string getWorkerScriptPath();
+
+    // Write the warm worker wrapper to path (left alone if it is already up to date).
+    // It runs the gemini.js in its own directory.
+    static bool writeWorkerScript(const std::string& path);
+
 private:
     static bool extractEmbeddedCli(const std::string& targetDir);
     static std::string getHomeDirectory();
     
     static std::string s_geminiCliPath;
+    static std::string s_workerScriptPath;
 };
 
 #endif // CLI_MANAGER_H
@@ -0,0 +1,90 @@
+#ifndef CLI_WORKER_POOL_H
+#define CLI_WORKER_POOL_H
+
+#include <ProcessExecutor.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+// Keeps long-lived Gemini CLI processes ("warm workers") around so a prompt doesn't pay
+// for Node startup every time (the CLI bundle itself is still evaluated per request).
+// Each worker serves one model, handles one request at a time, and is retired after
+// maxUses requests, or sooner once its resident memory passes maxMemoryMB.
+//
+// Workers speak a small framed protocol over stdin/stdout:
+//   worker -> @@GEMSTACK_READY@@\n                          once, when it can take requests
+//   pool   -> GEMSTACK_REQUEST <cwdBytes> <inputBytes>\n<cwd><input>
+//   worker -> <CLI output>\n@@GEMSTACK_DONE <exitCode> [<rssBytes>]@@\n  per request
+// The newline before the terminator is part of the framing and is not returned as output.
+// Workers get a stderr pipe of their own; what arrives on it during a request belongs to it.
+// A worker exits when its stdin is closed.
+class CliWorkerPool {
+public:
+    // Builds the argv that starts a worker for a model
+    using WorkerCommand = std::function<std::vector<std::string>(const std::string& model)>;
+
+    // maxMemoryMB = 0: no memory limit
+    explicit CliWorkerPool(WorkerCommand command, int maxUses = 20, int maxMemoryMB = 0);
+    ~CliWorkerPool();  // Shuts down every idle worker
+
+    // Prevent copying
+    CliWorkerPool(const CliWorkerPool&) = delete;
+    CliWorkerPool& operator=(const CliWorkerPool&) = delete;
+
+    // Run one request on an idle worker for model, starting one if none is idle.
+    // options.stdinData is the request input and options.workingDir its directory; echoOutput,
+    // mergeStderr, the line observers and the timeouts behave as for ProcessExecutor::execute. A worker that
+    // times out or is stopped by the observer is killed rather than reused.
+    // Returns std::nullopt if no worker could be started, or one died without producing any
+    // output; the caller should then run a one-shot CLI process instead. After a failed
+    // start the model's workers are not tried again for a while, twice as long after each
+    // failure in a row, so a transient failure doesn't disable them for good.
+    std::optional<ProcessResult> run(const std::string& model, const ProcessOptions& options);
+
+    // Number of workers waiting for a request
+    size_t idleCount(const std::string& model) const;
+    size_t idleCount() const;
+
+    // How long a new worker may take to report ready (default 60s)
+    void setStartupTimeout(std::chrono::milliseconds timeout) { startupTimeout = timeout; }
+
+    // How long to wait after a model's worker first fails to start (default 30s); doubles
+    // with each failure in a row, up to 30 minutes
+    void setStartRetryDelay(std::chrono::milliseconds delay) { startRetryDelay = delay; }
+
+    // Stop all idle workers
+    void shutdown();
+
+private:
+    struct Worker;
+
+    // Failed starts in a row for one model, and when to try again
+    struct StartFailures {
+        int count = 0;
+        std::chrono::steady_clock::time_point retryAt{};
+    };
+
+    std::unique_ptr<Worker> checkout(const std::string& model);
+    std::unique_ptr<Worker> startWorker(const std::string& model);
+    void checkin(const std::string& model, std::unique_ptr<Worker> worker);
+    static void retire(std::unique_ptr<Worker> worker);
+    static void discardPending(int fd);  // Drop anything waiting on a non-blocking pipe
+
+    WorkerCommand command;
+    int maxUses;
+    uint64_t maxMemoryBytes;
+    std::chrono::milliseconds startupTimeout{60000};
+    std::chrono::milliseconds startRetryDelay{30000};
+
+    mutable std::mutex mutex;
+    std::map<std::string, std::vector<std::unique_ptr<Worker>>> idle;
+    std::map<std::string, StartFailures> startFailures;
+};
+
+#endif // CLI_WORKER_POOL_H
@@ -4,6 +4,8 @@
 #include <string>
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <vector>
 
 class ConsoleUI {
 public:
@@ -16,9 +18,18 @@ public:
 
     // Task progress management
     void setTotalTasks(int total);
-    void incrementTaskProgress();
+    int incrementTaskProgress();  // Returns the new task number
     void resetProgress();
 
+    // Per-worker progress slots (used when several workers run in parallel)
+    // The animation runs while at least one slot is active.
+    void setWorkerSlots(int count);
+    void beginSlot(int slot, int taskNum);
+    void endSlot(int slot);
+
+    // Show the adaptive parallel limit in the status line (0 = hide)
+    void setConcurrencyLimit(int limit);
+
     // Animation control
     void startAnimation();
     void stopAnimation();
@@ -26,12 +37,21 @@ public:
 private:
     void statusAnimation(); // Worker function for thread
     void writeStatusLine(const std::string& text, bool clear = false);
+    std::string buildProgressPrefix();
+    void syncAnimationWithSlots();
 
     std::atomic<bool> animationRunning;
     std::thread animationThread;
     
     std::atomic<int> totalTasks;
     std::atomic<int> currentTaskNum;
+    std::atomic<int> concurrencyLimit;
+
+    // Task number per worker slot (0 = idle), guarded by slotMutex
+    std::mutex slotMutex;
+    std::vector<int> slotTasks;
+    int activeSlots;
+    std::mutex animationControlMutex;
 };
 
 #endif // CONSOLE_UI_H
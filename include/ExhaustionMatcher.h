@@ -0,0 +1,46 @@
+#ifndef EXHAUSTION_MATCHER_H
+#define EXHAUSTION_MATCHER_H
+
+#include <string_view>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+// What a rate-limit error says, beyond the fact that it is one
+enum class ExhaustionKind {
+    None,
+    RateLimit,   // Short-term limit (requests per minute, 429 bursts)
+    DailyQuota   // Quota for the day is used up; retrying soon won't help
+};
+
+// Recognizes rate-limit and quota errors in CLI output in a single pass.
+// All patterns are compiled once into an Aho-Corasick automaton that matches
+// case-insensitively. Unambiguous phrases ("quota exceeded", "RESOURCE_EXHAUSTED",
+// "too many requests") count wherever they appear. Loose ones only count with context
+// on the same line:
+//   - "429" must be a number of its own within a few characters of "error", "status",
+//     "code" or "HTTP", and not a line number ("foo.cpp:429:", "line 429")
+//   - "rate limit" needs an error ("error", "status", "exceeded", "retry", ...) or quota
+//     on its line, so "Added rate limit middleware" is not a rate-limit error
+//   - "exhausted" and "limit reached" need a line about quota, resources, capacity,
+//     usage or requests
+// A daily quota is told apart by "per day" or "daily" anywhere in the text.
+class ExhaustionMatcher {
+public:
+    ExhaustionMatcher();
+
+    ExhaustionKind classify(std::string_view text) const;
+
+private:
+    static constexpr int MAX_ALPHABET = 32;  // Distinct pattern characters + 1; the patterns use 28
+
+    std::array<uint8_t, 256> alphabet{};   // Byte -> symbol (0 = not in any pattern)
+    int symbols = 1;
+    std::vector<std::array<int32_t, MAX_ALPHABET>> transitions;  // Complete DFA
+    std::vector<uint32_t> outputs;        // Per state: bit i set = pattern i ends here
+};
+
+// The compiled matcher behind isModelExhausted() and classifyExhaustion(), built on first use
+const ExhaustionMatcher& exhaustionMatcher();
+
+#endif // EXHAUSTION_MATCHER_H
@@ -5,16 +5,25 @@
 #include <queue>
 #include <vector>
 #include <mutex>
-#include <condition_variable>
 #include <atomic>
 #include <functional>
 #include <optional>
+#include <map>
+#include <chrono>
+
+#include <cstdint>
+
+#include <RateLimiter.h>
+#include <ExhaustionMatcher.h>
+
+// Declared in TaskGraph.h and ModelRouter.h; include those where the types are used
+struct TaskSpec;
+struct ModelStats;
+enum class ModelTier;
+enum class PromptWeight;
 
 extern std::queue<std::string> commandQueue;
 extern std::mutex queueMutex;
-extern std::condition_variable queueCV;
-extern bool running;
-extern std::atomic<bool> isBusy;
 
 // Configuration structure
 struct GemStackConfig {
@@ -26,6 +35,65 @@ struct GemStackConfig {
     // Cooldown settings
     bool cooldownEnabled = false;
     int cooldownSeconds = 60;  // Default delay between prompts when cooldown is enabled
+
+    // Per-model request budget (token bucket). When set it replaces the flat cooldown.
+    double requestsPerMinute = 0;  // 0 = no rate limit
+    int rateLimitBurst = 1;        // Requests allowed back to back after an idle spell
+    std::map<std::string, RateLimit> modelRateLimits;  // "requestsPerMinute.<model>" overrides
+
+    // Rate-limited prompts back off and retry the same model before downgrading
+    int rateLimitRetries = 2;             // Retries on the same model (0 = downgrade at once)
+    int rateLimitBackoffSeconds = 10;     // Delay before the first retry; doubles each time
+    int rateLimitBackoffMaxSeconds = 300; // Cap on a single delay
+
+    // After a downgrade, try the model above again once this long has passed (0 = never)
+    int modelRepromoteSeconds = 900;
+
+    // Circuit breaker: this many rate limits in a row open a model's breaker, and it is
+    // skipped (also by later runs) for modelBreakerOpenSeconds before one probe request
+    int modelBreakerFailures = 3;
+    int modelBreakerOpenSeconds = 1800;
+
+    // Models and routing. The model list is the fallback order, best first (empty = built-in list).
+    // With routing on (opt-in), light prompts (meta-queries, short prompts) start on a flash-tier model.
+    std::vector<std::string> models;              // "models=a,b,c"
+    std::map<std::string, ModelTier> modelTiers;  // "modelTier.<model>=flash|pro" (default: from the name)
+    bool modelRouting = false;
+    int routeShortPromptChars = 200;  // Tasks shorter than this are light (0 = length never makes one light)
+
+    // Session context: the last sessionRecentEntries log entries go into each prompt verbatim,
+    // older ones as a digest of one short line each (at most sessionDigestChars)
+    bool sessionDigest = true;
+    int sessionRecentEntries = 20;
+    int sessionDigestChars = 2000;
+
+    // Parallelism settings
+    int jobs = 1;  // Number of worker threads pulling from the command queue
+
+    // Worktree isolation: each PromptBlock runs in its own git worktree and branch
+    bool worktreeIsolation = false;
+    std::string worktreeMergeStrategy = "merge";  // "merge" or "rebase"
+
+    // Per-prompt limits (0 = none). A prompt that hits one has its CLI process group killed.
+    int promptTimeoutSeconds = 0;      // Wall-clock limit for one CLI run
+    int promptIdleTimeoutSeconds = 0;  // Longest the CLI may go without printing anything
+    int timeoutRetries = 0;            // Extra attempts for a prompt that timed out
+
+    // Warm workers: long-lived CLI processes reused across prompts instead of a Node start per prompt
+    bool warmWorkersEnabled = false;
+    int warmWorkerMaxUses = 20;  // Requests a worker serves before it is replaced
+    int warmWorkerMaxMemoryMB = 1024;  // Replaced sooner once its resident memory exceeds this (0 = no limit)
+
+    // Output beyond this is spilled to a temp file; only its first and last halves stay in memory
+    int outputMemoryLimitMB = 16;
+
+    // Admission control: new prompts wait while the host is saturated (0 = no limit)
+    double maxLoadPerCpu = 0;    // 1-minute load average per CPU
+    int minFreeMemoryMB = 0;     // Available memory floor
+    int maxRunningChildren = 0;  // Gemini CLI children running at once
+
+    // Adaptive concurrency: start at half of 'jobs', grow while prompts succeed, halve on rate limits
+    bool adaptiveConcurrency = false;
 };
 
 extern GemStackConfig g_config;
@@ -38,26 +106,95 @@ GemStackConfig getDefaultConfig();
 extern std::vector<std::string> modelFallbackList;
 extern std::atomic<size_t> currentModelIndex;
 
+// Model routing
+// Load the model list and tiers from g_config; a CLI flag overrides whether routing is on
+void configureModelRouting(std::optional<bool> cliRouting = std::nullopt);
+
+bool isModelRoutingEnabled();
+
+// How much model a prompt needs. Meta-queries (GemStack asking what to do next) are always light.
+PromptWeight getPromptWeight(const std::string& promptContent, bool metaQuery = false);
+
+// Index into modelFallbackList where a prompt of this weight starts
+size_t routeModel(PromptWeight weight);
+
+// Feed a run's outcome and duration into the routing history
+void recordModelOutcome(const std::string& model, bool success, double latencySeconds);
+
+// The routing history for one model
+ModelStats getModelStats(const std::string& model);
+
 // File parsing
+// loadCommandsFromFile flattens the file into commandQueue; loadTasksFromFile keeps the
+// 'id'/'after' labels and block membership needed to build a TaskGraph.
 bool loadCommandsFromFile(const std::string& filename);
+bool loadTasksFromFile(const std::string& filename, std::vector<TaskSpec>& tasks);
 
 // Model management
 std::string getCurrentModel();
 bool downgradeModel();
 void resetModelToTop();
 
+// Per-worker model management (operates on a caller-owned index into modelFallbackList)
+std::string getModelAt(size_t modelIndex);
+bool downgradeModel(size_t& modelIndex);
+
+// Model re-promotion. A downgraded worker tries the model above again once its
+// promoteAt time passes (modelRepromoteSeconds after the downgrade, or a known quota
+// reset time). If the probe is rate limited the worker drops back and waits another window.
+struct ModelPromotionState {
+    std::chrono::steady_clock::time_point promoteAt{};
+    bool probing = false;  // The current model is being tried again after a downgrade
+};
+
+// Move one tier up if the window has passed; returns true when a probe starts
+bool maybePromoteModel(size_t& modelIndex, ModelPromotionState& state, std::chrono::steady_clock::time_point now);
+
+// Record a downgrade (including a failed probe) and schedule the next attempt
+void noteModelDowngraded(ModelPromotionState& state, std::chrono::steady_clock::time_point now);
+
+// Record a success on modelIndex; ends a probe and schedules the next step up
+void noteModelSucceeded(size_t modelIndex, ModelPromotionState& state, std::chrono::steady_clock::time_point now);
+
 // Security utilities
 std::string escapeForShell(const std::string& input);
 
-// Rate limit detection
+// Split a command line into arguments on whitespace. Double or single quotes group
+// words and are removed; a backslash escapes the next character inside double quotes.
+std::vector<std::string> splitCommandArguments(const std::string& commandLine);
+
+// Rate limit detection (one pass of the compiled ExhaustionMatcher)
 bool isModelExhausted(const std::string& output);
 
+struct ExhaustionInfo {
+    ExhaustionKind kind = ExhaustionKind::None;
+    int retryAfterSeconds = -1;  // Delay the error suggests (-1 = none given)
+    std::string model;           // Model from modelFallbackList named in the error ("" = none)
+
+    bool exhausted() const { return kind != ExhaustionKind::None; }
+};
+
+// Classify an error text: the error class, the suggested retry delay ("retryDelay": "37s",
+// "try again in 1m30s", "Retry-After: 20", "quota will reset after 2h5m") and the model
+ExhaustionInfo classifyExhaustion(const std::string& errorOutput);
+
+// classifyExhaustion() for a finished run. A run only counts as rate limited if it exited
+// non-zero and said so on stderr; stdout is the model's answer, which may well mention quotas.
+ExhaustionInfo classifyExhaustedRun(int exitCode, const std::string& errorOutput);
+
+// Delay suggested by an error text in seconds, rounded up (-1 if there is none)
+int parseRetryAfterSeconds(const std::string& text);
+
 // String utilities
 std::string trim(const std::string& str);
 
 // Directive parsing utilities
 std::string extractDirectiveContent(const std::string& line, const std::string& directive);
 bool startsWithDirective(const std::string& trimmedLine, const std::string& directive);
+std::string extractQuotedAttribute(const std::string& line, const std::string& key);
+
+// Parse "90", "90s", "15m" or "2h" into seconds (-1 if invalid)
+int parseDurationSeconds(const std::string& value);
 
 // Path utilities
 std::string normalizePath(const std::string& path);
@@ -74,11 +211,19 @@ void appendToSessionLog(const std::string& promptSummary, bool success, const st
 void clearSessionLog();
 std::string buildSessionContext();
 
+// What bounding the session context saved so far this run
+struct SessionContextStats {
+    int prompts = 0;
+    uint64_t logBytes = 0;   // Session log size summed over prompts
+    uint64_t sentBytes = 0;  // Digest plus recent entries actually sent
+};
+SessionContextStats getSessionContextStats();
+
 // Cooldown management
 // Injectable sleeper function type for testing (seconds -> void)
 using SleeperFunction = std::function<void(int)>;
 
-// Default sleeper implementation using std::this_thread::sleep_for
+// Default sleeper: blocks on the central WaitController, so shutdown ends it early
 void defaultSleeper(int seconds);
 
 // Set a custom sleeper function (for testing)
@@ -87,10 +232,18 @@ void setCooldownSleeper(SleeperFunction sleeper);
 // Reset to default sleeper
 void resetCooldownSleeper();
 
-// Perform cooldown delay if enabled
-// Returns true if cooldown was performed, false if skipped
+// Perform cooldown delay if enabled. The cooldown is an idle pause: wakeIdleWaits() ends it.
+// Returns true if cooldown was performed, false if skipped (disabled or shutting down)
 bool performCooldown();
 
+// Shutdown and urgent work. requestShutdown() ends every wait (cooldowns, rate-limit budgets,
+// backoffs) at once, and later waits return immediately. wakeIdleWaits() ends cooldowns only;
+// waits that keep a model within its quota run their course.
+void requestShutdown();
+bool isShutdownRequested();
+void resetShutdown();
+void wakeIdleWaits();
+
 // Get the effective cooldown seconds (accounting for CLI overrides)
 int getEffectiveCooldownSeconds();
 
@@ -100,4 +253,28 @@ bool isCooldownEnabled();
 // Apply CLI overrides for cooldown settings
 void applyCooldownCliOverrides(std::optional<bool> enabled, std::optional<int> seconds);
 
+// Per-model rate limiting
+// Load the token buckets from g_config; a CLI requests-per-minute replaces the default rate
+void configureRateLimits(std::optional<double> cliRequestsPerMinute = std::nullopt);
+
+// True if any model has a requests-per-minute limit (the flat cooldown is then skipped)
+bool isRateLimitEnabled();
+
+// Take a request from the model's bucket, sleeping (via the cooldown sleeper) as long as
+// the bucket requires. Returns true if it had to wait.
+bool waitForModelBudget(const std::string& model);
+
+// Rate-limit backoff
+// Delay before retry 'attempt' (0-based) of a rate-limited model: baseSeconds doubled per
+// attempt and capped at maxSeconds, of which the upper half is scaled by unitRandom in
+// [0, 1) so parallel workers don't retry in lockstep ("equal jitter")
+int rateLimitBackoffSeconds(int attempt, int baseSeconds, int maxSeconds, double unitRandom);
+
+// Sleep (via the cooldown sleeper) before retry 'attempt' with a random jitter.
+// Returns the seconds waited.
+int performRateLimitBackoff(int attempt);
+
+// Sleep (via the cooldown sleeper) for the delay a rate-limit error asked for
+void performRetryAfterWait(const std::string& model, int seconds);
+
 #endif // GEMSTACK_CORE_H
@@ -31,19 +31,29 @@ public:
         std::optional<bool> includePromptOverride
     );
 
-    // Check if current directory is inside a git repository
-    static bool isGitRepository();
+    // Check if the directory (default: current) is inside a git repository
+    static bool isGitRepository(const std::string& workingDir = "");
 
-    // Initialize a new git repository in the current directory
-    static bool initializeRepository();
+    // Initialize a new git repository in the directory (default: current)
+    static bool initializeRepository(const std::string& workingDir = "");
 
     // Check if there are uncommitted changes (staged, unstaged, or untracked)
-    static bool hasUncommittedChanges();
+    static bool hasUncommittedChanges(const std::string& workingDir = "");
+
+    // Stage and commit everything in the directory regardless of the enabled flag
+    // Returns true if a commit was created
+    static bool commitAllChanges(const std::string& message, const std::string& workingDir = "");
+
+    // Build a git command line that runs in workingDir ("" or "." means current directory)
+    static std::string gitCommand(const std::string& args, const std::string& workingDir = "");
 
     // Attempt to create an auto-commit if conditions are met
     // Returns true if commit was created, false otherwise
     bool maybeCommit(const std::string& promptSummary);
 
+    // Same, but commits inside workingDir (e.g. a per-block git worktree)
+    bool maybeCommit(const std::string& promptSummary, const std::string& workingDir);
+
     // Get the effective enabled state (after CLI overrides)
     bool isEnabled() const;
 
@@ -65,8 +75,8 @@ private:
     static std::string escapeForGitMessage(const std::string& input);
 
     // Execute git commands
-    static bool stageAllChanges();
-    static bool createCommit(const std::string& message);
+    static bool stageAllChanges(const std::string& workingDir = "");
+    static bool createCommit(const std::string& message, const std::string& workingDir = "");
 };
 
 #endif // GIT_AUTO_COMMIT_H
@@ -0,0 +1,82 @@
+#ifndef MODEL_HEALTH_H
+#define MODEL_HEALTH_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <functional>
+
+// Where the health table is kept between runs (current directory)
+const std::string MODEL_HEALTH_FILENAME = "GemStackModelHealth.txt";
+
+// Circuit breaker states. Closed: the model is used normally. Open: it has been
+// exhausted repeatedly and is skipped until openUntil. HalfOpen: the open period
+// has passed and one probe request may find out whether the quota is back.
+enum class BreakerState { Closed, Open, HalfOpen };
+
+std::string breakerStateName(BreakerState state);
+
+// What GemStack remembers about one model. Times are wall-clock seconds since the
+// epoch so they stay meaningful across restarts (0 = never).
+struct ModelHealthRecord {
+    BreakerState state = BreakerState::Closed;
+    int recentFailures = 0;         // Rate limits within the failure window
+    long long lastExhausted = 0;
+    long long openUntil = 0;
+    bool probeInFlight = false;     // Not persisted
+};
+
+// Per-model health with a circuit breaker. Thread-safe; shared by all workers.
+// With a state file set, every breaker change is written through so a restarted
+// GemStack does not go straight back to a model it knows is out of quota.
+class ModelHealthTable {
+public:
+    using Clock = std::chrono::system_clock;
+    using ClockFunction = std::function<Clock::time_point()>;
+
+    // failureThreshold rate limits within openSeconds open the breaker for openSeconds
+    explicit ModelHealthTable(int failureThreshold = 3, int openSeconds = 1800,
+                              ClockFunction clock = Clock::now);
+
+    void setPolicy(int failureThreshold, int openSeconds);
+
+    // Load a saved table (missing file = all closed) and write changes back to it
+    bool load(const std::string& path);
+    void setStateFile(const std::string& path);
+    bool save(const std::string& path) const;
+
+    // Whether a request may go to this model now. An open breaker whose time is up
+    // turns half-open and lets exactly one caller through as the probe.
+    bool allows(const std::string& model);
+
+    // The first model at or after fromIndex whose breaker allows a request
+    // (the last model if none does, so work never stops entirely)
+    size_t selectModel(const std::vector<std::string>& models, size_t fromIndex);
+
+    // Request outcomes. A success closes the breaker; a rate limit counts toward
+    // opening it (and reopens a half-open one at once). Other failures say nothing
+    // about the quota and only end a probe.
+    void recordSuccess(const std::string& model);
+    void recordExhausted(const std::string& model);
+    void recordOtherFailure(const std::string& model);
+
+    // A rate limit that said when to retry (epoch seconds): the breaker opens until exactly then
+    void recordExhaustedUntil(const std::string& model, long long retryAt);
+
+    ModelHealthRecord record(const std::string& model) const;
+
+private:
+    long long nowSeconds() const;
+    void changed();  // Caller holds mutex
+
+    int failureThreshold;
+    int openSeconds;
+    ClockFunction clock;
+    std::map<std::string, ModelHealthRecord> records;
+    std::string stateFile;
+    mutable std::mutex mutex;
+};
+
+#endif // MODEL_HEALTH_H
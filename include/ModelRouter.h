@@ -0,0 +1,74 @@
+#ifndef MODEL_ROUTER_H
+#define MODEL_ROUTER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+// Model tiers. Pro models are slower, scarcer and better; flash models are fast and
+// cheap enough for prompts that don't need the best model.
+enum class ModelTier { Pro, Flash };
+
+std::string modelTierName(ModelTier tier);
+
+// Parse "pro" or "flash" (also "lite"); false if the name is neither
+bool parseModelTier(const std::string& name, ModelTier& tier);
+
+// The tier a model belongs to unless configured: flash if its name says flash or lite
+ModelTier defaultModelTier(const std::string& model);
+
+// How much model a prompt needs
+enum class PromptWeight {
+    Light,  // Meta-queries, short prompts, checkpoint-only prompts
+    Heavy   // Implementation work
+};
+
+// Classify prompt text (without the session context). Preambles added for a block's
+// goal, styles and specify checkpoints don't count toward the length; the task does.
+// A checkpoint whose task is shorter than shortPromptChars is light, as is any such task.
+PromptWeight classifyPromptWeight(const std::string& promptContent, size_t shortPromptChars);
+
+// What the router has seen of one model
+struct ModelStats {
+    int successes = 0;
+    int failures = 0;
+    double meanLatencySeconds = 0;  // Moving average over successful runs (0 = none yet)
+
+    // Success rate with one success and one failure assumed up front, so a single
+    // early failure doesn't write a model off
+    double successRate() const;
+};
+
+// Picks the model a prompt starts on. Heavy prompts start on the first pro-tier model
+// of the fallback list. Light prompts start on the first flash-tier model, unless
+// history shows a later flash model is clearly faster per success, or the first one
+// mostly fails. Thread-safe; shared by all workers.
+class ModelRouter {
+public:
+    // Tiers for models not listed come from defaultModelTier()
+    void configure(std::vector<std::string> models, std::map<std::string, ModelTier> tiers = {});
+
+    ModelTier tierOf(const std::string& model) const;
+
+    // Index into the model list where a prompt of this weight starts
+    size_t route(PromptWeight weight) const;
+
+    // Outcome of one run; latency counts only for successes
+    void recordOutcome(const std::string& model, bool success, double latencySeconds);
+
+    ModelStats stats(const std::string& model) const;
+
+    // Runs needed before a model's history can move light prompts to it
+    static constexpr int MIN_SAMPLES = 3;
+
+private:
+    ModelTier tierOfLocked(const std::string& model) const;
+
+    std::vector<std::string> models;
+    std::map<std::string, ModelTier> tiers;
+    std::map<std::string, ModelStats> history;
+    mutable std::mutex mutex;
+};
+
+#endif // MODEL_ROUTER_H
@@ -0,0 +1,65 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <string>
+#include <fstream>
+#include <cstddef>
+
+// Captured child output with bounded memory. Up to memoryLimit bytes are kept as they are.
+// Past that only the first and last memoryLimit / 2 bytes stay in memory, and the whole
+// stream goes to a temporary file instead, so RSS stays flat however much a child prints.
+class OutputBuffer {
+public:
+    explicit OutputBuffer(size_t memoryLimit = 0);  // 0 = keep everything in memory
+    ~OutputBuffer();  // Deletes the spill file unless keepSpillFile() was called
+
+    OutputBuffer(OutputBuffer&& other) noexcept;
+    OutputBuffer& operator=(OutputBuffer&& other) noexcept;
+
+    // Prevent copying
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void append(const char* data, size_t length);
+    void append(const std::string& text) { append(text.data(), text.size()); }
+
+    size_t size() const { return totalBytes; }  // Everything appended, retained or not
+    bool empty() const { return totalBytes == 0; }
+    bool spilled() const { return spilling; }
+
+    // File holding the complete output once spilled ("" if it couldn't be created)
+    const std::string& spillPath() const { return path; }
+
+    // Everything, if it fit in memory; otherwise the head, a note saying where the rest
+    // went, and the tail
+    std::string str() const;
+
+    // str(), moving the contents out instead of copying when nothing was dropped
+    std::string take();
+
+    std::string head() const { return headBytes; }  // All of it until spilled
+    std::string tail() const;                       // "" until spilled
+
+    // Leave the spill file in place for whoever was handed spillPath(), and flush it so
+    // it is complete up to here
+    void keepSpillFile();
+
+private:
+    void startSpilling();
+    void appendTail(const char* data, size_t length);
+    void removeSpillFile();
+
+    size_t memoryLimit;
+    size_t headLimit = 0;
+    size_t tailLimit = 0;
+    size_t totalBytes = 0;
+    std::string headBytes;
+    std::string ring;      // The tail, as a circular buffer of tailLimit bytes
+    size_t ringStart = 0;  // Oldest byte in ring once it is full
+    bool spilling = false;
+    std::string path;
+    std::ofstream file;
+    bool keepFile = false;
+};
+
+#endif // OUTPUT_BUFFER_H
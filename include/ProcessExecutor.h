@@ -1,13 +1,163 @@
 #ifndef PROCESS_EXECUTOR_H
 #define PROCESS_EXECUTOR_H
 
+#include <OutputBuffer.h>
 #include <string>
+#include <chrono>
+#include <functional>
+#include <optional>
 #include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+// Sees each complete line of child output (without the line terminator) as it arrives.
+// Return false to stop the child immediately.
+using LineObserver = std::function<bool(const std::string& line)>;
+
+// Options for launching a process directly from an argv vector (no shell involved)
+struct ProcessOptions {
+    std::string workingDir;                // Directory to run in ("" = inherit)
+    std::vector<std::string> environment;  // "KEY=VALUE" entries (empty = inherit parent environment)
+    std::string stdinFile;                 // File to connect to the child's stdin ("" = inherit)
+    std::optional<std::string> stdinData;  // Streamed to the child's stdin over a pipe (overrides stdinFile)
+    bool holdInput = false;                // ProcessReactor only: keep stdin open and unwritten, and the
+                                           // limits below unarmed, until ProcessHandle::release()
+    bool echoOutput = true;                // Mirror the child's output to std::cout as it arrives
+                                           // (stderr to std::cerr when it is kept separate)
+    size_t outputMemoryLimit = 0;          // Most output bytes kept in memory (0 = unlimited); beyond
+                                           // it ProcessResult::output is the head and tail only
+    bool mergeStderr = true;               // false: capture stderr into ProcessResult::errorOutput
+                                           // instead of interleaving it with stdout in output
+    LineObserver lineObserver;             // Optional; runs on the thread reading the output. Sees
+                                           // stdout lines only when stderr is kept separate.
+    LineObserver errorLineObserver;        // Optional; sees stderr lines when stderr is kept separate
+
+    // Limits (zero = none). When one is hit the child gets SIGTERM, then SIGKILL after
+    // killGracePeriod; with newProcessGroup the signals go to its whole process group.
+    std::chrono::milliseconds timeout{0};          // Wall-clock limit
+    std::chrono::milliseconds idleTimeout{0};      // Longest allowed gap between output chunks
+    std::chrono::milliseconds killGracePeriod{3000};
+    bool newProcessGroup = false;          // Run the child in its own process group (job object on Windows)
+};
+
+struct ProcessResult {
+    int exitCode = -1;      // Exit status (127 if not found), 128 + signal number if killed, -1 on failure
+    std::string output;     // Combined stdout and stderr (stdout only without mergeStderr)
+    std::string errorOutput; // stderr without mergeStderr; bounded like output (no spill file is kept)
+    size_t outputSize = 0;  // Bytes the child printed; more than output.size() once spilled
+    std::string spillPath;  // Complete output if it outgrew outputMemoryLimit (the caller removes it)
+    bool cancelled = false; // Killed on request before it finished
+    bool timedOut = false;  // Killed because ProcessOptions::timeout or idleTimeout expired
+    bool idleTimedOut = false; // ...specifically because it went quiet for idleTimeout
+    bool stoppedByObserver = false; // Killed because the line observer returned false
+};
+
+// Splits captured output into lines for a LineObserver as chunks arrive. Only the current
+// unfinished line is buffered (up to MAX_LINE_LENGTH bytes; the rest of a longer line is
+// dropped), so it never needs the output captured so far.
+class LineDispatcher {
+public:
+    static constexpr size_t MAX_LINE_LENGTH = 64 * 1024;
+
+    explicit LineDispatcher(LineObserver observer) : observer(std::move(observer)) {}
+
+    // Pass every line this chunk completes to the observer.
+    // Returns false once the observer has asked to stop; later calls do nothing.
+    bool dispatch(const char* data, size_t length);
+    bool dispatch(const std::string& chunk) { return dispatch(chunk.data(), chunk.size()); }
+
+    // At EOF: pass a final line that has no terminator
+    bool finish();
+
+    bool stopped() const { return stopRequested; }
+
+private:
+    void deliver();
+
+    LineObserver observer;
+    std::string line;
+    bool stopRequested = false;
+};
+
+#ifndef _WIN32
+// A child started by ProcessExecutor::spawn: its pid and our ends of its pipes
+struct SpawnedProcess {
+    pid_t pid = -1;
+    int outputFd = -1;  // Read end of the child's stdout (and stderr, when merged)
+    int errorFd = -1;   // Read end of the child's stderr (-1 when merged into outputFd)
+    int inputFd = -1;   // Write end of the child's stdin (-1 unless stdinData was given)
+    bool processGroup = false;  // Leads its own process group (pgid == pid)
+};
+
+// Enforces ProcessOptions::timeout and idleTimeout for one spawned child
+class ProcessWatchdog {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ProcessWatchdog(const ProcessOptions& options, const SpawnedProcess& process);
+
+    // Reset the idle timer
+    void outputReceived();
+
+    // Send whatever signal is due. Returns milliseconds until the next deadline, or -1 if none.
+    int check();
+
+    bool timedOut() const { return stage != Stage::Running; }
+    bool idleTimedOut() const { return idleExpired; }
+
+    // SIGKILL was sent a grace period ago and the output pipe is still open: something that
+    // escaped the process group is holding it, so stop waiting for EOF
+    bool shouldAbandonOutput() const { return stage == Stage::Abandoned; }
+
+private:
+    enum class Stage { Running, Terminating, Killed, Abandoned };
+
+    SpawnedProcess process;
+    std::chrono::milliseconds timeout;
+    std::chrono::milliseconds idleTimeout;
+    std::chrono::milliseconds gracePeriod;
+    Clock::time_point started;
+    Clock::time_point lastOutput;
+    Clock::time_point stageStarted;
+    Stage stage = Stage::Running;
+    bool idleExpired = false;
+};
+#endif
 
 class ProcessExecutor {
 public:
+    // Move captured output into result, handing any spill file over to the caller
+    static void collectOutput(OutputBuffer& output, ProcessResult& result);
+
     // Execute a shell command and return {exit_code, output}
     static std::pair<int, std::string> execute(const std::string& command, const std::string& workingDir = "");
+
+    // Launch argv[0] (looked up on PATH) with the given arguments, without a shell.
+    // Arguments are passed through verbatim, so no escaping is needed.
+    static ProcessResult execute(const std::vector<std::string>& argv, const ProcessOptions& options = {});
+
+#ifndef _WIN32
+    // Start a child without waiting for it; the caller owns the pipes and must reap the pid.
+    // On failure returns false with the exit code and message filled into failure.
+    static bool spawn(const std::vector<std::string>& argv, const ProcessOptions& options,
+                      SpawnedProcess& process, ProcessResult& failure);
+
+    // Translate a waitpid() status into a shell-style exit code
+    static int exitCodeFromWaitStatus(int status);
+
+    // Signal the child, or its whole process group if it leads one
+    static void signalProcess(const SpawnedProcess& process, int signal);
+
+    // Forget a finished child's process group (call once it is reaped and its output drained)
+    static void releaseProcess(const SpawnedProcess& process);
+
+    // Send signal to every live process group started with newProcessGroup.
+    // Async-signal-safe, so a SIGINT/SIGTERM handler can take the children down with us.
+    static void signalAllProcessGroups(int signal);
+#endif
 };
 
 #endif // PROCESS_EXECUTOR_H
@@ -0,0 +1,109 @@
+#ifndef PROCESS_REACTOR_H
+#define PROCESS_REACTOR_H
+
+#include <ProcessExecutor.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <future>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+class ProcessReactor;
+
+// Handle to a child started by ProcessReactor::start
+class ProcessHandle {
+public:
+    ProcessHandle() = default;
+
+    uint64_t id() const { return processId; }
+    bool valid() const { return result.valid(); }
+
+    // Block until the child has exited and its output is drained
+    ProcessResult wait() const;
+
+    // True once the result is available
+    bool finished() const;
+
+    // Kill the child; its result is reported with cancelled = true.
+    // Returns false if it had already finished.
+    bool cancel() const;
+
+    // Hand input to a child started with holdInput and arm its timeouts.
+    // Returns false if it has already finished or was not started with holdInput.
+    bool release(const std::string& input) const;
+
+    std::shared_future<ProcessResult> future() const { return result; }
+
+private:
+    friend class ProcessReactor;
+
+    ProcessReactor* reactor = nullptr;
+    uint64_t processId = 0;
+    std::shared_future<ProcessResult> result;
+};
+
+// Runs many children concurrently from a single event-loop thread.
+// On Linux one epoll instance watches every child's output and stdin pipes plus a pidfd
+// for its exit, so concurrency costs file descriptors rather than an OS thread per child.
+// Elsewhere each child is run on its own thread through ProcessExecutor::execute.
+class ProcessReactor {
+public:
+    using CompletionCallback = std::function<void(const ProcessResult&)>;
+
+    ProcessReactor();
+    ~ProcessReactor();  // Kills any children still running
+
+    // Prevent copying
+    ProcessReactor(const ProcessReactor&) = delete;
+    ProcessReactor& operator=(const ProcessReactor&) = delete;
+
+    // Launch argv without waiting. onComplete runs on the reactor thread once the child has
+    // exited and all of its output is collected, before the handle's future is ready. A
+    // launch that fails is reported the same way, never from inside start(). The exception
+    // is a reactor whose loop could not be created (epoll unavailable): then onComplete runs
+    // on the caller's thread before start() returns.
+    // A lineObserver in options also runs on the reactor thread, so it must not block.
+    ProcessHandle start(const std::vector<std::string>& argv, const ProcessOptions& options = {},
+                        CompletionCallback onComplete = nullptr);
+
+    // Kill a running child (SIGKILL, to its whole process group if it has one).
+    // Returns false if it is unknown or already finished.
+    bool cancel(uint64_t processId);
+
+    // Deliver stdin to a child started with ProcessOptions::holdInput (see ProcessHandle::release)
+    bool release(uint64_t processId, const std::string& input);
+
+    // Number of children that have not completed yet
+    size_t activeCount() const;
+
+private:
+    struct Job;
+
+    void run();
+    void wake();
+    void finishJob(std::unique_ptr<Job> job, std::vector<std::unique_ptr<Job>>& completed);
+    void joinFinishedRunners();
+    void handleOutput(Job& job, bool errorStream);
+    void handleInput(Job& job);
+    bool reap(Job& job);
+
+    mutable std::mutex mutex;
+    std::map<uint64_t, std::unique_ptr<Job>> jobs;
+    uint64_t nextId = 1;
+    std::atomic<bool> stopping{false};
+
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::thread loopThread;
+    // Per-child threads where epoll is unavailable, by job id. A runner adds its id to
+    // finishedRunners as its last step; the next start() or release() joins those.
+    std::map<uint64_t, std::thread> runners;
+    std::vector<uint64_t> finishedRunners;
+};
+
+#endif // PROCESS_REACTOR_H
@@ -0,0 +1,72 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <functional>
+
+// Request budget for one model. Zero leaves a field to the default limit.
+struct RateLimit {
+    double requestsPerMinute = 0;  // Sustained rate (0 = unlimited)
+    int burst = 0;                 // Requests that may go out back to back after an idle spell
+};
+
+// A token bucket: holds up to 'burst' tokens and refills at requestsPerMinute.
+// Each request takes one token. Tokens are reserved, so the balance can go negative
+// and callers queue up in order; the deficit is how long a caller must wait.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket(RateLimit limit, Clock::time_point now);
+
+    // Take a token and return how long to wait before using it (zero if one was available)
+    std::chrono::milliseconds reserve(Clock::time_point now);
+
+    // Tokens available now (negative while requests are queued)
+    double available(Clock::time_point now);
+
+private:
+    void refill(Clock::time_point now);
+
+    double tokensPerSecond;
+    double capacity;
+    double tokens;
+    Clock::time_point lastRefill;
+};
+
+// One token bucket per model, created on first use. Time spent not calling a model
+// (long prompts, other models, idle queues) refills its bucket, so a model that has
+// been quiet gets its burst straight away instead of a fixed cooldown.
+class ModelRateLimiter {
+public:
+    using ClockFunction = std::function<TokenBucket::Clock::time_point()>;
+
+    explicit ModelRateLimiter(ClockFunction clock = TokenBucket::Clock::now);
+
+    // Set the limit for models without their own, and per-model overrides.
+    // Drops existing buckets so the new limits apply from a full bucket.
+    void configure(RateLimit defaults, std::map<std::string, RateLimit> perModel = {});
+
+    // The limit that applies to a model (requestsPerMinute 0 = unlimited)
+    RateLimit limitFor(const std::string& model) const;
+
+    // True if any model is limited
+    bool enabled() const;
+
+    // Reserve one request for the model; returns how long to wait before sending it
+    std::chrono::milliseconds reserve(const std::string& model);
+
+private:
+    RateLimit limitForLocked(const std::string& model) const;
+
+    ClockFunction clock;
+    RateLimit defaults;
+    std::map<std::string, RateLimit> perModel;
+    std::map<std::string, TokenBucket> buckets;
+    mutable std::mutex mutex;
+};
+
+#endif // RATE_LIMITER_H
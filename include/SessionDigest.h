@@ -0,0 +1,83 @@
+#ifndef SESSION_DIGEST_H
+#define SESSION_DIGEST_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdint>
+
+// Where the digest of older session log entries is kept (next to the session log)
+const std::string SESSION_DIGEST_FILENAME = "GemStackSessionLog.digest.txt";
+
+// Splits a session log into entries: a line plus any indented lines after it (a
+// multi-line note). Entries keep their newlines, so joined they give back the log.
+std::vector<std::string> splitSessionEntries(const std::string& log);
+
+// One-line form of an entry for the digest: "+ summary" for a success, "! summary | Notes: ..."
+// for a failure, "* text" for anything the agent wrote itself. Timestamps are dropped.
+std::string compactSessionEntry(const std::string& entry, size_t maxChars = 120);
+
+// Rough token count of text sent to the model (about four bytes a token)
+uint64_t estimateTokens(uint64_t bytes);
+
+// Older session log entries folded into counts and one short line each. The lines are
+// capped at maxChars; the oldest go first but stay in the counts. Folding is incremental:
+// the digest remembers how many bytes of the log it covers and a running hash of them, so
+// a cleared or edited log is noticed and the digest rebuilt from scratch.
+class SessionDigest {
+public:
+    explicit SessionDigest(size_t maxChars = 2000);
+
+    void setMaxChars(size_t maxChars);
+
+    // Whether the log still starts with the bytes this digest was built from
+    bool covers(const std::string& log) const;
+
+    // Add the next entry of the log (the bytes right after foldedBytes())
+    void fold(const std::string& entry);
+    void clear();
+
+    size_t foldedEntries() const { return entries; }
+    size_t foldedBytes() const { return bytes; }
+
+    // Text for the prompt ("" while nothing is folded)
+    std::string render() const;
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+private:
+    void trimLines();
+
+    size_t maxChars;
+    size_t entries = 0;
+    size_t bytes = 0;
+    uint64_t prefixHash;
+    int succeeded = 0;
+    int failed = 0;
+    int notes = 0;
+    int dropped = 0;
+    std::deque<std::string> lines;
+    size_t lineChars = 0;
+};
+
+// The session log cut down for one prompt: older entries as the digest, the last
+// recentEntries verbatim
+struct BoundedSessionLog {
+    std::string digest;
+    std::string recent;
+    size_t logBytes = 0;
+    bool digestChanged = false;  // The digest folded new entries or was rebuilt
+
+    size_t keptBytes() const { return digest.size() + recent.size(); }
+};
+
+// Folds everything but the last recentEntries (at least 1) into the digest. Only the bytes
+// after foldedBytes() are split into entries. With verifyPrefix false the caller vouches
+// that the log has only grown since the digest was last checked against it (the
+// SessionLogCache generation is unchanged), so the folded prefix is not hashed again and
+// a prompt costs time in the new and recent entries rather than in the whole log.
+BoundedSessionLog boundSessionLog(const std::string& log, size_t recentEntries, SessionDigest& digest,
+                                  bool verifyPrefix = true);
+
+#endif // SESSION_DIGEST_H
@@ -0,0 +1,47 @@
+#ifndef SESSION_LOG_CACHE_H
+#define SESSION_LOG_CACHE_H
+
+#include <string>
+#include <mutex>
+#include <cstdint>
+
+// In-memory copy of an append-only log file such as the session log. Each read only
+// loads the bytes appended since the last one, whoever wrote them (GemStack itself or
+// the agent appending notes), so a long session does not reread the whole file per prompt.
+// The file is reread from the start if it shrank (clearSessionLog(), manual truncation)
+// or if the bytes just before the cached end no longer match (rewritten by an editor).
+class SessionLogCache {
+public:
+    explicit SessionLogCache(std::string path);
+
+    // Current file contents ("" if the file doesn't exist)
+    std::string contents();
+
+    // The same, plus a counter that changes whenever the cached contents were thrown away
+    // (rewrite, truncation, removal, invalidate()). While it stays the same, the file has
+    // only grown since the previous read.
+    std::string contents(uint64_t& generation);
+
+    // Forget the cached contents; the next read loads the whole file
+    void invalidate();
+
+    // Bytes read from disk so far, and how many reads started from scratch
+    uint64_t bytesRead() const;
+    int fullReads() const;
+
+    // Bytes before the cached end compared on each read to detect a rewritten file
+    static constexpr size_t CHECK_BYTES = 64;
+
+private:
+    void refresh();  // Caller holds mutex
+    void discard();  // Caller holds mutex
+
+    std::string path;
+    std::string cached;
+    uint64_t generationCount = 0;
+    uint64_t totalBytesRead = 0;
+    int fullReadCount = 0;
+    mutable std::mutex mutex;
+};
+
+#endif // SESSION_LOG_CACHE_H
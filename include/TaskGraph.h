@@ -0,0 +1,138 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <chrono>
+
+// A queued command plus the labels used to schedule it
+struct TaskSpec {
+    std::string command;
+    std::string id;                  // Label from an 'id' directive (optional)
+    std::vector<std::string> after;  // Labels of prompts/blocks this task waits for
+    int block = 0;                   // PromptBlock number (0 = outside any block)
+    std::string blockId;             // Label of the enclosing PromptBlock (optional)
+    int timeoutSeconds = -1;         // From a 'timeout' directive (-1 = use GemStackConfig)
+    int idleTimeoutSeconds = -1;     // From an 'idletimeout' directive (-1 = use GemStackConfig)
+};
+
+enum class TaskState {
+    Pending,    // Waiting on dependencies
+    Ready,      // Dependencies met, waiting for a worker
+    Running,
+    Succeeded,
+    Failed,
+    Skipped     // Never run because something upstream failed
+};
+
+struct TaskNode {
+    TaskSpec spec;
+    TaskState state = TaskState::Pending;
+    std::vector<size_t> dependencies;
+    std::vector<size_t> dependents;
+    size_t unmetDependencies = 0;
+    int parkCount = 0;  // Times the task was handed back with park()
+};
+
+// Dependency graph of queued tasks.
+// Prompts inside a PromptBlock run in order; blocks and top-level prompts are independent
+// unless linked with 'after'. Workers acquire ready tasks lowest-index first, so a single
+// worker still runs the file top to bottom.
+class TaskGraph {
+public:
+    TaskGraph() = default;
+
+    // Prevent copying
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // Add a batch of tasks, resolving labels against this batch and earlier ones.
+    // Unknown labels are reported and ignored; tasks caught in a cycle are skipped.
+    void addTasks(const std::vector<TaskSpec>& specs);
+
+    // Add a standalone task with no dependencies (e.g. typed in interactive mode)
+    size_t addTask(const std::string& command);
+
+    // Block until a task is ready and mark it running.
+    // Returns nullopt once the graph is closed and nothing is left to run.
+    std::optional<size_t> acquire();
+
+    // Hand a running task back to run again no earlier than notBefore (e.g. when its
+    // model asked to be retried at a given time). Workers take other ready tasks meanwhile.
+    void park(size_t index, std::chrono::steady_clock::time_point notBefore);
+
+    // Times a task has been parked
+    int parkCount(size_t index) const;
+
+    // Report a finished task. On failure every task downstream of it is skipped;
+    // the indices of newly skipped tasks are returned.
+    std::vector<size_t> complete(size_t index, bool success);
+
+    // Worktree isolation: a block's work only reaches the main checkout when the block is
+    // merged, so tasks outside a block that wait on it are held until releaseBlock()
+    void holdBlockDependents(bool hold);
+
+    // The block has been merged (or failed to): release the tasks held on it, or skip them
+    // if it could not be merged. Returns the indices of newly skipped tasks.
+    std::vector<size_t> releaseBlock(int block, bool merged);
+
+    // No more tasks will be added; acquire() returns nullopt when drained
+    void close();
+
+    std::string command(size_t index) const;
+    TaskSpec task(size_t index) const;  // Block numbers are graph-wide, not per file
+    TaskState state(size_t index) const;
+    std::vector<size_t> dependencies(size_t index) const;
+    size_t size() const;
+
+    // Tasks that are waiting or ready (not yet started or finished)
+    size_t remaining() const;
+
+    // Block until no task is ready, parked, running or held back for its block's merge
+    void waitUntilIdle();
+
+    // Stop: skip every task not yet started (including parked ones) and close the graph.
+    // Running tasks finish. Returns the number of tasks skipped.
+    size_t cancelPending();
+
+    // PromptBlock numbers present in the graph, ascending
+    std::vector<int> blocks() const;
+
+    // PromptBlock numbers with every block after the blocks it waits for (directly or
+    // through other tasks), otherwise ascending. Merging in this order never deadlocks.
+    std::vector<int> blockOrder() const;
+
+    // nullopt while any task of the block is unfinished; otherwise whether all succeeded
+    std::optional<bool> blockOutcome(int block) const;
+
+private:
+    std::vector<size_t> skipDownstream(size_t index);
+    void markReady(size_t index);
+    bool isHeld(size_t dependency, size_t dependent) const;
+
+    mutable std::mutex mutex;
+    std::condition_variable readyCV;
+    std::vector<TaskNode> nodes;
+    std::vector<size_t> readyTasks;       // Min-heap of ready indices
+    // Parked tasks (state Ready) and when they may run again
+    std::vector<std::pair<std::chrono::steady_clock::time_point, size_t>> parkedTasks;
+    std::map<std::string, size_t> labels; // Task id -> index
+    std::map<std::string, int> blockLabels;
+    std::map<int, size_t> lastTaskInBlock;
+    int nextBlock = 1;                    // Block numbers are renumbered per batch
+    size_t runningCount = 0;
+    bool closed = false;
+    bool holdForMerge = false;
+    std::set<int> releasedBlocks;
+    std::set<int> heldBlocks;             // Finished blocks with tasks held on them
+};
+
+// Split an 'after' value such as "setup, schema" into labels
+std::vector<std::string> parseLabelList(const std::string& value);
+
+#endif // TASK_GRAPH_H
@@ -0,0 +1,49 @@
+#ifndef WAIT_CONTROLLER_H
+#define WAIT_CONTROLLER_H
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+
+// How a wait ended
+enum class WaitOutcome {
+    Elapsed,    // The full time passed
+    Woken,      // Cut short because urgent work arrived (interruptible waits only)
+    Cancelled   // Cut short by shutdown
+};
+
+// The one place GemStack's timed waits (cooldowns, rate-limit budgets, backoffs) block,
+// so they can be ended early instead of sleeping out their full time.
+// Waits block on a condition variable against the steady clock. wake() ends the
+// interruptible ones: idle pauses such as the cooldown, which urgent work may skip.
+// Waits that protect a quota are only ended by cancel(). After cancel() every wait,
+// current or later, returns at once until reset().
+class WaitController {
+public:
+    WaitController() = default;
+
+    // Prevent copying
+    WaitController(const WaitController&) = delete;
+    WaitController& operator=(const WaitController&) = delete;
+
+    WaitOutcome waitFor(std::chrono::milliseconds duration, bool interruptible = false);
+
+    // End current interruptible waits
+    void wake();
+
+    // Shut down: end all waits now and make later ones return immediately
+    void cancel();
+    bool cancelled() const;
+
+    // Allow waiting again (tests, or a new run in the same process)
+    void reset();
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable changedCV;
+    uint64_t wakeGeneration = 0;  // Bumped by every wake()
+    bool stopped = false;
+};
+
+#endif // WAIT_CONTROLLER_H
@@ -0,0 +1,80 @@
+#ifndef WORKTREE_MANAGER_H
+#define WORKTREE_MANAGER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <optional>
+
+// How a finished block's branch is brought back into the main checkout
+enum class WorktreeMergeStrategy {
+    Merge,   // git merge --no-ff <branch>
+    Rebase   // rebase the branch onto the base branch, then fast-forward
+};
+
+// Outcome of bringing one block back into the main checkout
+struct WorktreeMergeResult {
+    int block = 0;
+    std::string branch;
+    bool merged = false;
+    bool conflict = false;
+    std::string message;
+};
+
+// Gives each PromptBlock its own git worktree and branch so blocks can run in parallel
+// without sharing a working tree or index. Finished blocks are merged back strictly in
+// block order; a later block that finishes first waits for the earlier ones.
+class WorktreeManager {
+public:
+    explicit WorktreeManager(const std::string& repoDir = ".",
+                             WorktreeMergeStrategy strategy = WorktreeMergeStrategy::Merge);
+
+    // Prevent copying
+    WorktreeManager(const WorktreeManager&) = delete;
+    WorktreeManager& operator=(const WorktreeManager&) = delete;
+
+    // Verify the repository can host worktrees (needs at least one commit) and record
+    // the branch that blocks are merged into. Returns false if isolation is unavailable.
+    bool initialize();
+
+    // Blocks that will be merged, in merge order (typically TaskGraph::blockOrder())
+    void setBlocks(const std::vector<int>& blockOrder);
+
+    // Path of the block's worktree, creating the worktree and branch on first use
+    std::optional<std::string> acquire(int block, const std::string& label = "");
+
+    // Record that every task in the block has finished. Merges this block and any
+    // following blocks that were waiting on it; returns a result for each block brought
+    // back (including blocks that never got a worktree and had nothing to merge).
+    std::vector<WorktreeMergeResult> finishBlock(int block, bool success);
+
+    std::string getBaseBranch() const;
+    std::string getWorktreeRoot() const;
+
+private:
+    struct BlockRecord {
+        std::string branch;
+        std::string path;
+        bool finished = false;
+        bool success = false;
+    };
+
+    WorktreeMergeResult mergeBlock(int block, BlockRecord& record);
+    void removeWorktree(const BlockRecord& record);
+
+    std::string repoDir;
+    std::string worktreeRoot;
+    std::string baseBranch;
+    WorktreeMergeStrategy strategy;
+
+    std::mutex mutex;
+    std::vector<int> mergeOrder;
+    size_t nextToMerge = 0;
+    std::map<int, BlockRecord> records;
+};
+
+// Parse "merge" / "rebase" (anything else falls back to merge)
+WorktreeMergeStrategy parseWorktreeMergeStrategy(const std::string& value);
+
+#endif // WORKTREE_MANAGER_H
@@ -0,0 +1,239 @@
+#include <AdmissionController.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <algorithm>
+#include <cmath>
+
+#ifndef _WIN32
+#include <cstdlib>
+#endif
+
+HostLoad readHostLoad() {
+    HostLoad load;
+    load.cpuCount = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+#ifdef __linux__
+    std::ifstream loadavg("/proc/loadavg");
+    double oneMinute = 0;
+    if (loadavg >> oneMinute) {
+        load.loadAverage = oneMinute;
+    }
+
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+    while (std::getline(meminfo, line)) {
+        // "MemAvailable:   12345678 kB"
+        if (line.compare(0, 13, "MemAvailable:") == 0) {
+            std::istringstream fields(line.substr(13));
+            long long kilobytes = 0;
+            if (fields >> kilobytes) {
+                load.availableMemoryMB = kilobytes / 1024;
+            }
+            break;
+        }
+    }
+#elif !defined(_WIN32)
+    double averages[1];
+    if (getloadavg(averages, 1) == 1) {
+        load.loadAverage = averages[0];
+    }
+#endif
+    return load;
+}
+
+AdmissionController::AdmissionController(AdmissionLimits limits, HostProbe probe)
+    : limits(limits), probe(std::move(probe)) {}
+
+void AdmissionController::setLimits(const AdmissionLimits& newLimits) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        limits = newLimits;
+    }
+    released.notify_all();
+}
+
+AdmissionLimits AdmissionController::getLimits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return limits;
+}
+
+bool AdmissionController::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return adaptive || limits.maxLoadPerCpu > 0 || limits.minFreeMemoryMB > 0 || limits.maxRunningChildren > 0;
+}
+
+void AdmissionController::enableAdaptiveLimit(int initial, int maximum, double factor) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        adaptive = true;
+        maximumLimit = std::max(maximum, 1);
+        currentLimit = std::clamp(initial, 1, maximumLimit);
+        peakLimit = static_cast<int>(currentLimit);
+        decreaseFactor = (factor > 0 && factor < 1) ? factor : 0.5;
+    }
+    released.notify_all();
+}
+
+int AdmissionController::adaptiveLimit() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return adaptive ? static_cast<int>(currentLimit) : 0;
+}
+
+int AdmissionController::peakAdaptiveLimit() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return peakLimit;
+}
+
+int AdmissionController::adaptiveCuts() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int>(cuts);
+}
+
+void AdmissionController::setLimitListener(LimitListener newListener) {
+    std::lock_guard<std::mutex> lock(mutex);
+    listener = std::move(newListener);
+}
+
+void AdmissionController::recordSuccess() {
+    int raisedTo = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!adaptive) {
+            return;
+        }
+        int before = static_cast<int>(currentLimit);
+        currentLimit = std::min(currentLimit + 1.0 / before, static_cast<double>(maximumLimit));
+        if (static_cast<int>(currentLimit) > before) {
+            raisedTo = static_cast<int>(currentLimit);
+            peakLimit = std::max(peakLimit, raisedTo);
+        }
+    }
+    if (raisedTo > 0) {
+        released.notify_all();
+        limitChanged(raisedTo, true);
+    }
+}
+
+bool AdmissionController::recordRateLimit(uint64_t window) {
+    int cutTo = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!adaptive || window != cuts) {
+            return false;
+        }
+        cuts++;
+        currentLimit = std::max(1.0, std::floor(currentLimit * decreaseFactor));
+        cutTo = static_cast<int>(currentLimit);
+    }
+    limitChanged(cutTo, false);
+    return true;
+}
+
+void AdmissionController::limitChanged(int limit, bool raised) {
+    LimitListener notify;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        notify = listener;
+    }
+    std::cout << "[GemStack] " << (raised ? "Prompts succeeding; parallel limit raised to "
+                                          : "Rate limited; parallel limit cut to ")
+              << limit << std::endl;
+    if (notify) {
+        notify(limit);
+    }
+}
+
+int AdmissionController::running() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return runningChildren;
+}
+
+void AdmissionController::setPollInterval(std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pollInterval = interval;
+}
+
+std::string AdmissionController::saturationReason(const HostLoad& load) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return saturationReasonLocked(load);
+}
+
+std::string AdmissionController::saturationReasonLocked(const HostLoad& load) const {
+    if (runningChildren == 0) {
+        return "";
+    }
+    if (limits.maxRunningChildren > 0 && runningChildren >= limits.maxRunningChildren) {
+        return std::to_string(runningChildren) + " prompts already running";
+    }
+    if (adaptive && runningChildren >= static_cast<int>(currentLimit)) {
+        return "adaptive limit of " + std::to_string(static_cast<int>(currentLimit)) + " prompts reached";
+    }
+    if (limits.maxLoadPerCpu > 0 && load.loadAverage >= 0 &&
+        load.loadAverage / std::max(load.cpuCount, 1) > limits.maxLoadPerCpu) {
+        std::ostringstream reason;
+        reason << "load average " << std::fixed << std::setprecision(1) << load.loadAverage << " on "
+               << load.cpuCount << " CPUs";
+        return reason.str();
+    }
+    if (limits.minFreeMemoryMB > 0 && load.availableMemoryMB >= 0 && load.availableMemoryMB < limits.minFreeMemoryMB) {
+        return std::to_string(load.availableMemoryMB) + " MB of memory available";
+    }
+    return "";
+}
+
+std::optional<uint64_t> AdmissionController::acquire() {
+    std::string heldBecause;
+    while (true) {
+        // Probe outside the lock; reading /proc must not stall release()
+        HostLoad load = probe ? probe() : HostLoad();
+        std::unique_lock<std::mutex> lock(mutex);
+        if (stopped) {
+            return std::nullopt;
+        }
+        std::string reason = saturationReasonLocked(load);
+        if (reason.empty()) {
+            runningChildren++;
+            if (!heldBecause.empty() && !adaptive) {
+                std::cout << "[GemStack] Host has headroom again; starting the next prompt." << std::endl;
+            }
+            return cuts;
+        }
+        // Waiting on the adaptive limit is routine; only a saturated host is worth reporting
+        if (heldBecause.empty() && reason.compare(0, 8, "adaptive") != 0) {
+            std::cout << "[GemStack] Host saturated (" << reason << "); holding back the next prompt." << std::endl;
+        }
+        heldBecause = reason;
+        released.wait_for(lock, pollInterval);
+    }
+}
+
+void AdmissionController::release() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (runningChildren > 0) {
+            runningChildren--;
+        }
+    }
+    released.notify_one();
+}
+
+void AdmissionController::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+    }
+    released.notify_all();
+}
+
+bool AdmissionController::cancelled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stopped;
+}
+
+void AdmissionController::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = false;
+}
@@ -5,15 +5,206 @@
 #include <fstream>
 #include <filesystem>
 #include <cstdlib>
+#include <iterator>
 
 namespace fs = std::filesystem;
 
 std::string CliManager::s_geminiCliPath;
+std::string CliManager::s_workerScriptPath;
+
+// Wrapper that keeps one Node process alive across prompts (see CliWorkerPool.h for the
+// protocol). Each request re-evaluates gemini.js in-process with process.exit, stdin, argv
+// and cwd swapped out, so no prompt pays for Node startup. The bundle exports no entry point,
+// so it is still parsed and evaluated per request, and each run's module instance (with its
+// listeners and timers) stays loaded until the worker is retired; the worker reports its
+// resident memory after every request so the pool can retire it early. A request ends when
+// its run calls process.exit, or once nothing it started keeps the event loop alive (where
+// a one-shot CLI would have exited). Each run has its own async context, so exits, errors
+// and output from earlier runs' leftover timers and handlers are ignored.
+static const char* WORKER_SCRIPT = R"JS(// GemStack warm worker - generated by GemStack, do not edit.
+// Arguments after this script are passed to gemini.js on every run. Exits when stdin closes.
+import { Readable } from 'node:stream';
+import { fileURLToPath, pathToFileURL } from 'node:url';
+import { AsyncLocalStorage, createHook } from 'node:async_hooks';
+import path from 'node:path';
+
+const nodePath = process.argv[0];
+const cliPath = path.join(path.dirname(fileURLToPath(import.meta.url)), 'gemini.js');
+const cliArgs = process.argv.slice(2);
+const requests = process.stdin;
+const exitProcess = process.exit.bind(process);
+const writeOutput = process.stdout.write.bind(process.stdout);
+const writeErrors = process.stderr.write.bind(process.stderr);
+
+class CliExit extends Error {
+  constructor(code) {
+    super('CLI exited');
+    this.code = code;
+  }
+}
+
+// Every run of the CLI executes inside its own context, which its timers, callbacks and
+// promises inherit. Module instances from earlier runs stay loaded, so anything they do
+// later (exit, write, throw) is recognized by its context and kept out of the current run.
+const runContext = new AsyncLocalStorage();
+let current = null;
+const isStale = () => {
+  const run = runContext.getStore();
+  return run !== undefined && run !== current;
+};
+
+// Resources (timers, sockets, file requests) each run has open; once its import has
+// settled and none of them keeps the event loop alive, a one-shot CLI would have exited
+const owners = new Map();
+createHook({
+  init(asyncId, type, triggerAsyncId, resource) {
+    const run = runContext.getStore();
+    if (run && type !== 'PROMISE') {
+      run.resources.set(asyncId, resource);
+      owners.set(asyncId, run);
+    }
+  },
+  destroy(asyncId) {
+    const run = owners.get(asyncId);
+    if (run) {
+      run.resources.delete(asyncId);
+      owners.delete(asyncId);
+    }
+  },
+}).enable();
+const keepsAlive = (run) => {
+  for (const resource of run.resources.values()) {
+    if (typeof resource?.hasRef !== 'function' || resource.hasRef()) return true;
+  }
+  return false;
+};
+setInterval(() => {
+  if (current && current.settled && !keepsAlive(current)) current.finish(process.exitCode ?? 0);
+}, 100).unref();
+
+const exitCodeOf = (code) => (typeof code === 'number' ? code : Number.parseInt(code, 10) || (code ? 1 : 0));
+
+// The CLI ends a run by calling process.exit; that becomes the end of the request instead
+process.exit = (code) => {
+  const exitCode = code ?? process.exitCode ?? 0;
+  if (current && !isStale()) current.finish(exitCode);
+  throw new CliExit(exitCode);
+};
+const handleError = (error) => {
+  if (error instanceof CliExit || isStale()) return;
+  writeErrors(`${error?.stack ?? error}\n`);
+  if (current) current.finish(1);
+};
+process.on('uncaughtException', handleError);
+process.on('unhandledRejection', handleError);
+
+// Late output from an earlier run must not end up in the current request
+const guardWrites = (write) => (chunk, ...rest) => {
+  if (!isStale()) return write(chunk, ...rest);
+  const callback = rest.find((arg) => typeof arg === 'function');
+  if (callback) process.nextTick(callback);
+  return true;
+};
+process.stdout.write = guardWrites(writeOutput);
+process.stderr.write = guardWrites(writeErrors);
+
+let pending = Buffer.alloc(0);
+let ended = false;
+let wake = null;
+requests.on('data', (chunk) => {
+  pending = pending.length ? Buffer.concat([pending, chunk]) : chunk;
+  if (wake) wake();
+});
+requests.on('end', () => {
+  ended = true;
+  if (wake) wake();
+});
+
+async function waitFor(ready) {
+  while (!ready()) {
+    if (ended) return false;
+    await new Promise((resolve) => { wake = resolve; });
+    wake = null;
+  }
+  return true;
+}
+
+async function readLine() {
+  if (!await waitFor(() => pending.indexOf(10) >= 0)) return null;
+  const newline = pending.indexOf(10);
+  const line = pending.subarray(0, newline).toString();
+  pending = pending.subarray(newline + 1);
+  return line;
+}
+
+async function readBytes(length) {
+  if (!await waitFor(() => pending.length >= length)) return null;
+  const bytes = pending.subarray(0, length);
+  pending = pending.subarray(length);
+  return bytes;
+}
+
+let runs = 0;
+function runCli(cwd, input) {
+  const run = { resources: new Map(), settled: false };
+  const done = new Promise((resolve) => {
+    run.finish = (code) => {
+      if (current !== run) return;
+      current = null;
+      resolve(exitCodeOf(code));
+    };
+  });
+  current = run;
+  process.chdir(cwd);
+  process.exitCode = undefined;
+  process.argv = [nodePath, cliPath, ...cliArgs];
+  const stdin = new Readable({
+    read() {
+      this.push(input);
+      this.push(null);
+    },
+  });
+  Object.defineProperty(process, 'stdin', { value: stdin, configurable: true, writable: true });
+  // A fresh query string makes Node evaluate the bundle again in this process (gemini.js
+  // runs itself on import and exports nothing to call instead)
+  runs++;
+  runContext.run(run, () => {
+    import(`${pathToFileURL(cliPath).href}?run=${runs}`).then(
+      () => { run.settled = true; },
+      (error) => {
+        run.settled = true;
+        handleError(error);
+      });
+  });
+  return done;
+}
+
+writeOutput('@@GEMSTACK_READY@@\n');
+for (;;) {
+  const header = await readLine();
+  if (header === null) break;
+  const [tag, cwdLength, inputLength] = header.split(' ');
+  if (tag !== 'GEMSTACK_REQUEST') {
+    writeErrors(`Unexpected request: ${header}\n`);
+    break;
+  }
+  const cwd = await readBytes(Number(cwdLength));
+  const input = cwd && await readBytes(Number(inputLength));
+  if (!input) break;
+  const code = await runCli(cwd.toString(), input);
+  writeOutput(`\n@@GEMSTACK_DONE ${code} ${process.memoryUsage().rss}@@\n`);
+}
+exitProcess(0);
+)JS";
 
 std::string CliManager::getGeminiCliPath() {
     return s_geminiCliPath;
 }
 
+std::string CliManager::getWorkerScriptPath() {
+    return s_workerScriptPath;
+}
+
 std::string CliManager::getHomeDirectory() {
 #ifdef _WIN32
     const char* home = getenv("USERPROFILE");
@@ -84,6 +275,25 @@ bool CliManager::extractEmbeddedCli(const std::string& targetDir) {
     return true;
 }
 
+bool CliManager::writeWorkerScript(const std::string& path) {
+    // Leave an up-to-date script alone so concurrent GemStack runs don't race on it
+    std::ifstream existing(path, std::ios::binary);
+    if (existing) {
+        std::string contents((std::istreambuf_iterator<char>(existing)), std::istreambuf_iterator<char>());
+        if (contents == WORKER_SCRIPT) {
+            return true;
+        }
+    }
+    existing.close();
+
+    std::ofstream script(path, std::ios::binary | std::ios::trunc);
+    if (!script) {
+        return false;
+    }
+    script << WORKER_SCRIPT;
+    return static_cast<bool>(script);
+}
+
 bool CliManager::initialize() {
     std::string home = getHomeDirectory();
     std::string cliDir = joinPath(home, ".gemstack/gemini-cli");
@@ -93,5 +303,12 @@ bool CliManager::initialize() {
     }
     
     s_geminiCliPath = joinPath(cliDir, "gemini.js");
+
+    std::string workerScriptPath = joinPath(cliDir, "gemstack-worker.mjs");
+    if (writeWorkerScript(workerScriptPath)) {
+        s_workerScriptPath = workerScriptPath;
+    } else {
+        std::cerr << "[GemStack] Warning: Could not write " << workerScriptPath << "; warm workers disabled." << std::endl;
+    }
     return true;
 }
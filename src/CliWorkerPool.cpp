@@ -0,0 +1,512 @@
+#include <CliWorkerPool.h>
+#include <GemStackCore.h>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+namespace fs = std::filesystem;
+
+struct CliWorkerPool::Worker {
+#ifndef _WIN32
+    SpawnedProcess process;
+    bool reaped = false;
+#endif
+    int uses = 0;
+    uint64_t memoryBytes = 0;  // Resident memory it reported after its last request
+};
+
+// Longest a model's warm workers stay off after failed starts
+static constexpr std::chrono::milliseconds START_RETRY_MAX = std::chrono::minutes(30);
+
+CliWorkerPool::CliWorkerPool(WorkerCommand command, int maxUses, int maxMemoryMB)
+    : command(std::move(command)), maxUses(std::max(maxUses, 1)),
+      maxMemoryBytes(static_cast<uint64_t>(std::max(maxMemoryMB, 0)) * 1024 * 1024) {}
+
+CliWorkerPool::~CliWorkerPool() {
+    shutdown();
+}
+
+size_t CliWorkerPool::idleCount(const std::string& model) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = idle.find(model);
+    return it == idle.end() ? 0 : it->second.size();
+}
+
+size_t CliWorkerPool::idleCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& [model, workers] : idle) {
+        count += workers.size();
+    }
+    return count;
+}
+
+void CliWorkerPool::shutdown() {
+    std::vector<std::unique_ptr<Worker>> stopping;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& [model, workers] : idle) {
+            for (auto& worker : workers) {
+                stopping.push_back(std::move(worker));
+            }
+        }
+        idle.clear();
+    }
+    for (auto& worker : stopping) {
+        retire(std::move(worker));
+    }
+}
+
+std::unique_ptr<CliWorkerPool::Worker> CliWorkerPool::checkout(const std::string& model) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto failures = startFailures.find(model);
+        if (failures != startFailures.end() && std::chrono::steady_clock::now() < failures->second.retryAt) {
+            return nullptr;
+        }
+        auto& workers = idle[model];
+        while (!workers.empty()) {
+            std::unique_ptr<Worker> worker = std::move(workers.back());
+            workers.pop_back();
+#ifndef _WIN32
+            // A worker that died while idle (crash, OOM kill) is replaced
+            int status = 0;
+            if (waitpid(worker->process.pid, &status, WNOHANG) == worker->process.pid) {
+                worker->reaped = true;
+                retire(std::move(worker));
+                continue;
+            }
+            // Printed while idle; belongs to no request
+            discardPending(worker->process.outputFd);
+            discardPending(worker->process.errorFd);
+#endif
+            return worker;
+        }
+    }
+
+    std::unique_ptr<Worker> worker = startWorker(model);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (worker) {
+        startFailures.erase(model);
+        return worker;
+    }
+    StartFailures& failures = startFailures[model];
+    failures.count++;
+    std::chrono::milliseconds wait = startRetryDelay;
+    for (int i = 1; i < failures.count && wait < START_RETRY_MAX; i++) {
+        wait *= 2;
+    }
+    wait = std::min(wait, START_RETRY_MAX);
+    failures.retryAt = std::chrono::steady_clock::now() + wait;
+    std::cerr << "[GemStack] Not using warm workers for " << model << " for the next "
+              << std::chrono::duration_cast<std::chrono::seconds>(wait).count()
+              << "s; prompts run in new processes." << std::endl;
+    return nullptr;
+}
+
+void CliWorkerPool::checkin(const std::string& model, std::unique_ptr<Worker> worker) {
+    // Recycle periodically so state leaked by the CLI between requests can't pile up
+    if (worker->uses >= maxUses) {
+        retire(std::move(worker));
+        return;
+    }
+    if (maxMemoryBytes > 0 && worker->memoryBytes > maxMemoryBytes) {
+        std::cout << "[GemStack] Warm worker for " << model << " uses " << worker->memoryBytes / (1024 * 1024)
+                  << " MB after " << worker->uses << " prompts; replacing it." << std::endl;
+        retire(std::move(worker));
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    idle[model].push_back(std::move(worker));
+}
+
+#ifdef _WIN32
+// Warm workers rely on the POSIX pipe plumbing in ProcessExecutor::spawn; on Windows every
+// prompt runs as a one-shot CLI process
+void CliWorkerPool::discardPending(int) {}
+
+std::unique_ptr<CliWorkerPool::Worker> CliWorkerPool::startWorker(const std::string&) {
+    return nullptr;
+}
+
+void CliWorkerPool::retire(std::unique_ptr<Worker>) {}
+
+std::optional<ProcessResult> CliWorkerPool::run(const std::string&, const ProcessOptions&) {
+    return std::nullopt;
+}
+
+#else
+using Clock = std::chrono::steady_clock;
+
+static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+static constexpr size_t ECHO_BATCH_SIZE = 16 * 1024;
+
+static const std::string READY_LINE = "@@GEMSTACK_READY@@\n";
+static const std::string DONE_MARKER = "\n@@GEMSTACK_DONE ";
+
+static void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+static int millisecondsUntil(Clock::time_point deadline) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+    return static_cast<int>(std::max<long long>(remaining.count(), 0));
+}
+
+// Length of the longest tail of output that could be the start of DONE_MARKER
+static size_t partialMarkerLength(const std::string& output) {
+    size_t longest = std::min(output.size(), DONE_MARKER.size() - 1);
+    for (size_t length = longest; length > 0; length--) {
+        if (output.compare(output.size() - length, length, DONE_MARKER, 0, length) == 0) {
+            return length;
+        }
+    }
+    return 0;
+}
+
+// Exit code from the rest of a terminator line ("<code>@@")
+// "<exitCode> [<rssBytes>]@@" -> exit code; memoryBytes is left alone if not reported
+static int parseDoneLine(const std::string& text, uint64_t& memoryBytes) {
+    std::string fields = trim(text);
+    if (fields.size() >= 2 && fields.compare(fields.size() - 2, 2, "@@") == 0) {
+        fields.resize(fields.size() - 2);
+    }
+    size_t space = fields.find(' ');
+    if (space != std::string::npos) {
+        try {
+            memoryBytes = std::stoull(fields.substr(space + 1));
+        } catch (...) {
+        }
+        fields.resize(space);
+    }
+    try {
+        return std::stoi(fields);
+    } catch (...) {
+        return 1;
+    }
+}
+
+void CliWorkerPool::discardPending(int fd) {
+    char buffer[4096];
+    while (fd >= 0) {
+        ssize_t bytesRead = read(fd, buffer, sizeof(buffer));
+        if (bytesRead <= 0 && !(bytesRead < 0 && errno == EINTR)) {
+            return;
+        }
+    }
+}
+
+// Kill a worker (and anything its CLI started), close its pipes and reap it.
+// Returns its exit code.
+static int destroyWorker(SpawnedProcess& process, bool reaped) {
+    int status = 0;
+    if (!reaped) {
+        ProcessExecutor::signalProcess(process, SIGKILL);
+    }
+    close(process.outputFd);
+    if (process.errorFd >= 0) {
+        close(process.errorFd);
+    }
+    close(process.inputFd);
+    if (!reaped) {
+        while (waitpid(process.pid, &status, 0) < 0 && errno == EINTR) {
+        }
+    }
+    ProcessExecutor::releaseProcess(process);
+    return reaped ? -1 : ProcessExecutor::exitCodeFromWaitStatus(status);
+}
+
+std::unique_ptr<CliWorkerPool::Worker> CliWorkerPool::startWorker(const std::string& model) {
+    ProcessOptions options;
+    options.stdinData = std::string();  // Requests are written to a pipe kept open between them
+    options.newProcessGroup = true;     // Timeouts also take down the agent's shell tool calls
+    options.mergeStderr = false;        // Each request decides whether its stderr is kept apart
+
+    auto worker = std::make_unique<Worker>();
+    ProcessResult failure;
+    if (!ProcessExecutor::spawn(command(model), options, worker->process, failure)) {
+        std::cerr << "[GemStack] Could not start warm worker for " << model << ": " << failure.output << std::endl;
+        return nullptr;
+    }
+    setNonBlocking(worker->process.outputFd);
+    setNonBlocking(worker->process.errorFd);
+    setNonBlocking(worker->process.inputFd);
+
+    // Wait for the ready line, discarding anything printed before it (e.g. Node warnings)
+    Clock::time_point deadline = Clock::now() + startupTimeout;
+    std::string banner;
+    std::string startupErrors;
+    char buffer[4096];
+    while (banner.find(READY_LINE) == std::string::npos) {
+        ssize_t errorRead = read(worker->process.errorFd, buffer, sizeof(buffer));
+        if (errorRead > 0 && startupErrors.size() < READ_CHUNK_SIZE) {
+            startupErrors.append(buffer, static_cast<size_t>(errorRead));
+        }
+        ssize_t bytesRead = read(worker->process.outputFd, buffer, sizeof(buffer));
+        if (bytesRead > 0) {
+            banner.append(buffer, static_cast<size_t>(bytesRead));
+            continue;
+        }
+        if (bytesRead == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+            break;
+        }
+        int waitMs = millisecondsUntil(deadline);
+        if (waitMs == 0) {
+            break;
+        }
+        pollfd fds[2] = {{worker->process.outputFd, POLLIN, 0}, {worker->process.errorFd, POLLIN, 0}};
+        poll(fds, 2, waitMs);
+    }
+
+    if (banner.find(READY_LINE) == std::string::npos) {
+        std::string detail = extractFirstMeaningfulLine(startupErrors);
+        if (detail.empty()) {
+            detail = extractFirstMeaningfulLine(banner);
+        }
+        std::cerr << "[GemStack] Warm worker for " << model << " did not become ready"
+                  << (detail.empty() ? "" : ": " + detail) << std::endl;
+        destroyWorker(worker->process, false);
+        return nullptr;
+    }
+    return worker;
+}
+
+void CliWorkerPool::retire(std::unique_ptr<Worker> worker) {
+    if (!worker->reaped) {
+        // Closing stdin asks the worker to exit; give it a moment before killing it
+        close(worker->process.inputFd);
+        worker->process.inputFd = -1;
+        Clock::time_point deadline = Clock::now() + std::chrono::seconds(1);
+        int status = 0;
+        while (Clock::now() < deadline) {
+            if (waitpid(worker->process.pid, &status, WNOHANG) == worker->process.pid) {
+                worker->reaped = true;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    destroyWorker(worker->process, worker->reaped);
+}
+
+std::optional<ProcessResult> CliWorkerPool::run(const std::string& model, const ProcessOptions& options) {
+    std::unique_ptr<Worker> worker = checkout(model);
+    if (!worker) {
+        return std::nullopt;
+    }
+    SpawnedProcess& process = worker->process;
+
+    // Workers outlive any one directory, so send an absolute path
+    std::error_code error;
+    fs::path directory = fs::absolute(options.workingDir.empty() ? "." : options.workingDir, error);
+    std::string cwd = error ? options.workingDir : directory.lexically_normal().string();
+    while (cwd.size() > 1 && cwd.back() == '/') {
+        cwd.pop_back();  // "/repo/." normalizes to "/repo/"
+    }
+    static const std::string noInput;
+    const std::string& input = options.stdinData ? *options.stdinData : noInput;
+    std::string request = "GEMSTACK_REQUEST " + std::to_string(cwd.size()) + " " +
+                          std::to_string(input.size()) + "\n" + cwd + input;
+
+    ProcessResult result;
+    OutputBuffer output(options.outputMemoryLimit);
+    OutputBuffer errors(options.outputMemoryLimit);
+    ProcessWatchdog watchdog(options, process);
+    std::optional<LineDispatcher> lines;
+    std::optional<LineDispatcher> errorLines;
+    if (options.lineObserver) {
+        lines.emplace(options.lineObserver);
+    }
+    // The worker's stderr has its own pipe; with mergeStderr it is folded into the output
+    const LineObserver& errorObserver = options.mergeStderr ? options.lineObserver : options.errorLineObserver;
+    if (errorObserver) {
+        errorLines.emplace(errorObserver);
+    }
+    OutputBuffer& errorSink = options.mergeStderr ? output : errors;
+
+    std::vector<char> buffer(READ_CHUNK_SIZE);
+    size_t written = 0;
+    std::string unconfirmed;  // Trailing bytes that may be the start of the terminator
+    std::string pendingEcho;
+    bool answered = false;
+    bool exited = false;
+    int answerCode = 0;
+    auto flushEcho = [&]() {
+        if (!pendingEcho.empty()) {
+            std::cout.write(pendingEcho.data(), static_cast<std::streamsize>(pendingEcho.size()));
+            std::cout.flush();
+            pendingEcho.clear();
+        }
+    };
+    bool newlineDispatched = false;  // The held-back newline at the front of unconfirmed was sent to lines
+    // Pass the first length bytes of unconfirmed on as real output
+    auto accept = [&](size_t length) {
+        output.append(unconfirmed.data(), length);
+        if (options.echoOutput) {
+            pendingEcho.append(unconfirmed, 0, length);
+            if (pendingEcho.size() >= ECHO_BATCH_SIZE) {
+                flushEcho();
+            }
+        }
+        if (lines && !lines->stopped()) {
+            size_t skip = (newlineDispatched && length > 0) ? 1 : 0;
+            if (length > 0) {
+                newlineDispatched = false;
+            }
+            bool keepGoing = lines->dispatch(unconfirmed.data() + skip, length - skip);
+            // A held-back newline ends the current line whether it is output or framing
+            if (keepGoing && !newlineDispatched && unconfirmed.size() > length && unconfirmed[length] == '\n') {
+                keepGoing = lines->dispatch("\n", 1);
+                newlineDispatched = true;
+            }
+            if (!keepGoing) {
+                ProcessExecutor::signalProcess(process, SIGKILL);
+            }
+        }
+        unconfirmed.erase(0, length);
+    };
+    // Take whatever the worker has written to stderr so far
+    auto readErrors = [&]() {
+        bool progressed = false;
+        while (process.errorFd >= 0) {
+            ssize_t bytesRead = read(process.errorFd, buffer.data(), buffer.size());
+            if (bytesRead > 0) {
+                size_t length = static_cast<size_t>(bytesRead);
+                errorSink.append(buffer.data(), length);
+                watchdog.outputReceived();
+                if (options.echoOutput) {
+                    flushEcho();
+                    std::cerr.write(buffer.data(), bytesRead);
+                    std::cerr.flush();
+                }
+                if (errorLines && !errorLines->stopped() && !errorLines->dispatch(buffer.data(), length)) {
+                    ProcessExecutor::signalProcess(process, SIGKILL);
+                }
+                progressed = true;
+                continue;
+            }
+            if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytesRead == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                close(process.errorFd);
+                process.errorFd = -1;
+            }
+            break;
+        }
+        return progressed;
+    };
+
+    while (!answered) {
+        bool progressed = false;
+
+        if (written < request.size()) {
+            size_t toWrite = std::min(request.size() - written, READ_CHUNK_SIZE);
+            ssize_t bytesWritten = write(process.inputFd, request.data() + written, toWrite);
+            if (bytesWritten > 0) {
+                written += static_cast<size_t>(bytesWritten);
+                progressed = true;
+            } else if (bytesWritten < 0 && errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
+                // EPIPE: the worker is gone; collect whatever it printed
+                written = request.size();
+            }
+        }
+
+        // stderr first, so what the CLI printed there before finishing is in by the terminator
+        progressed = readErrors() || progressed;
+
+        ssize_t bytesRead = read(process.outputFd, buffer.data(), buffer.size());
+        if (bytesRead > 0) {
+            unconfirmed.append(buffer.data(), static_cast<size_t>(bytesRead));
+            watchdog.outputReceived();
+
+            size_t markerPos = unconfirmed.find(DONE_MARKER);
+            if (markerPos == std::string::npos) {
+                accept(unconfirmed.size() - partialMarkerLength(unconfirmed));
+            } else {
+                accept(markerPos);
+                size_t lineEnd = unconfirmed.find('\n', DONE_MARKER.size());
+                if (lineEnd != std::string::npos) {
+                    answerCode = parseDoneLine(unconfirmed.substr(DONE_MARKER.size(), lineEnd - DONE_MARKER.size()),
+                                               worker->memoryBytes);
+                    unconfirmed.clear();
+                    answered = true;
+                    if (lines && !lines->stopped() && !lines->finish()) {
+                        ProcessExecutor::signalProcess(process, SIGKILL);
+                    }
+                }
+            }
+            progressed = true;
+        } else if (bytesRead == 0) {
+            exited = true;
+            break;
+        } else if (errno == EINTR) {
+            progressed = true;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            exited = true;
+            break;
+        }
+
+        int waitMs = watchdog.check();
+        if (watchdog.shouldAbandonOutput()) {
+            break;
+        }
+        if (progressed || answered) {
+            continue;
+        }
+
+        flushEcho();
+        pollfd fds[3] = {{process.outputFd, POLLIN, 0}, {process.errorFd, POLLIN, 0}, {process.inputFd, POLLOUT, 0}};
+        while (poll(fds, written < request.size() ? 3 : 2, waitMs) < 0 && errno == EINTR) {
+        }
+    }
+
+    readErrors();
+    if (!answered) {
+        accept(unconfirmed.size());
+        if (lines && !lines->stopped()) {
+            lines->finish();
+        }
+    }
+    if (errorLines && !errorLines->stopped()) {
+        errorLines->finish();
+    }
+    flushEcho();
+    result.timedOut = watchdog.timedOut();
+    result.idleTimedOut = watchdog.idleTimedOut();
+    result.stoppedByObserver = (lines && lines->stopped()) || (errorLines && errorLines->stopped());
+    ProcessExecutor::collectOutput(output, result);
+    result.errorOutput = errors.take();
+
+    if (answered && written == request.size() && !result.timedOut && !result.stoppedByObserver) {
+        result.exitCode = answerCode;
+        worker->uses++;
+        checkin(model, std::move(worker));
+        return result;
+    }
+
+    // Dead, killed, or out of step with the protocol: don't hand it another request
+    int exitCode = destroyWorker(process, false);
+    if (exited && result.outputSize == 0 && result.errorOutput.empty() && !result.timedOut &&
+        !result.stoppedByObserver) {
+        std::cerr << "[GemStack] Warm worker for " << model
+                  << " exited without answering; running the prompt in a new process." << std::endl;
+        return std::nullopt;
+    }
+    result.exitCode = exitCode;
+    return result;
+}
+#endif
@@ -12,7 +12,7 @@
 #include <cstdio>
 #endif
 
-ConsoleUI::ConsoleUI() : animationRunning(false), totalTasks(0), currentTaskNum(0) {}
+ConsoleUI::ConsoleUI() : animationRunning(false), totalTasks(0), currentTaskNum(0), concurrencyLimit(0), activeSlots(0) {}
 
 ConsoleUI::~ConsoleUI() {
     stopAnimation();
@@ -22,8 +22,8 @@ void ConsoleUI::setTotalTasks(int total) {
     totalTasks.store(total);
 }
 
-void ConsoleUI::incrementTaskProgress() {
-    currentTaskNum.fetch_add(1);
+int ConsoleUI::incrementTaskProgress() {
+    return currentTaskNum.fetch_add(1) + 1;
 }
 
 void ConsoleUI::resetProgress() {
@@ -31,6 +31,89 @@ void ConsoleUI::resetProgress() {
     currentTaskNum.store(0);
 }
 
+void ConsoleUI::setConcurrencyLimit(int limit) {
+    concurrencyLimit.store(limit);
+}
+
+void ConsoleUI::setWorkerSlots(int count) {
+    std::lock_guard<std::mutex> lock(slotMutex);
+    slotTasks.assign(count > 0 ? count : 0, 0);
+    activeSlots = 0;
+}
+
+void ConsoleUI::beginSlot(int slot, int taskNum) {
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        if (slot < 0 || slot >= static_cast<int>(slotTasks.size())) return;
+        if (slotTasks[slot] == 0) {
+            activeSlots++;
+        }
+        slotTasks[slot] = taskNum;
+    }
+    syncAnimationWithSlots();
+}
+
+void ConsoleUI::endSlot(int slot) {
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        if (slot < 0 || slot >= static_cast<int>(slotTasks.size())) return;
+        if (slotTasks[slot] != 0) {
+            slotTasks[slot] = 0;
+            activeSlots--;
+        }
+    }
+    syncAnimationWithSlots();
+}
+
+// Run the shared animation while any slot is active. slotMutex must not be held here:
+// stopAnimation() joins the animation thread, which locks slotMutex to render.
+void ConsoleUI::syncAnimationWithSlots() {
+    std::lock_guard<std::mutex> lock(animationControlMutex);
+    bool anyActive;
+    {
+        std::lock_guard<std::mutex> slotLock(slotMutex);
+        anyActive = activeSlots > 0;
+    }
+    if (anyActive) {
+        startAnimation();
+    } else {
+        stopAnimation();
+    }
+}
+
+// Build "[current/total] " for a single worker, or "[W1:3 W2:4 of 10] " for several
+std::string ConsoleUI::buildProgressPrefix() {
+    int total = totalTasks.load();
+
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        if (slotTasks.size() > 1) {
+            std::string slots;
+            for (size_t i = 0; i < slotTasks.size(); i++) {
+                if (slotTasks[i] == 0) continue;
+                if (!slots.empty()) slots += " ";
+                slots += "W" + std::to_string(i + 1) + ":" + std::to_string(slotTasks[i]);
+            }
+            if (slots.empty()) {
+                return "";
+            }
+            if (total > 0) {
+                slots += " of " + std::to_string(total);
+            }
+            if (int limit = concurrencyLimit.load(); limit > 0) {
+                slots += ", limit " + std::to_string(limit) + "/" + std::to_string(slotTasks.size());
+            }
+            return "[" + slots + "] ";
+        }
+    }
+
+    int current = currentTaskNum.load();
+    if (total > 0 && current > 0) {
+        return "[" + std::to_string(current) + "/" + std::to_string(total) + "] ";
+    }
+    return "";
+}
+
 void ConsoleUI::startAnimation() {
     if (animationRunning.load()) return;
     animationRunning.store(true);
@@ -85,12 +168,7 @@ void ConsoleUI::statusAnimation() {
 
     while (animationRunning.load()) {
         // Build progress prefix if we have task info
-        std::string progressPrefix;
-        int current = currentTaskNum.load();
-        int total = totalTasks.load();
-        if (total > 0 && current > 0) {
-            progressPrefix = "[" + std::to_string(current) + "/" + std::to_string(total) + "] ";
-        }
+        std::string progressPrefix = buildProgressPrefix();
 
         std::string dots(dotCount + 1, '.');
         std::string padding(3 - dotCount, ' ');
@@ -120,12 +198,7 @@ void ConsoleUI::statusAnimation() {
 
     while (animationRunning.load()) {
         // Build progress prefix if we have task info
-        std::string progressPrefix;
-        int current = currentTaskNum.load();
-        int total = totalTasks.load();
-        if (total > 0 && current > 0) {
-            progressPrefix = "[" + std::to_string(current) + "/" + std::to_string(total) + "] ";
-        }
+        std::string progressPrefix = buildProgressPrefix();
 
         std::string dots(dotCount + 1, '.');
         std::string padding(3 - dotCount, ' ');
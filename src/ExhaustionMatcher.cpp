@@ -0,0 +1,255 @@
+#include <ExhaustionMatcher.h>
+#include <cctype>
+#include <queue>
+#include <string>
+
+namespace {
+
+// What a pattern tells the classifier when it matches
+enum class Signal : uint8_t {
+    Exhausted,     // Unambiguous on its own
+    Status429,     // HTTP status, if an error or status word is right next to it
+    LooseWord,     // "exhausted", "limit reached": needs quota context
+    RateLimitWord, // "rate limit": needs an error or quota context
+    StatusContext, // An error or HTTP status is being reported
+    LimitContext,  // A limit was hit ("exceeded", "retry", "backing off")
+    QuotaContext,  // The line is about quota or capacity
+    Daily          // The quota is per day
+};
+
+struct Pattern {
+    const char* text;  // Lowercase; input is matched case-insensitively
+    Signal signal;
+};
+
+const Pattern PATTERNS[] = {
+    {"rate limit", Signal::RateLimitWord},
+    {"rate_limit", Signal::RateLimitWord},
+    {"rate-limit", Signal::RateLimitWord},
+    {"quota exceeded", Signal::Exhausted},
+    {"quota_exceeded", Signal::Exhausted},
+    {"exceeded your current quota", Signal::Exhausted},
+    {"resource exhausted", Signal::Exhausted},
+    {"resource_exhausted", Signal::Exhausted},
+    {"too many requests", Signal::Exhausted},
+    {"429", Signal::Status429},
+    {"exhausted", Signal::LooseWord},
+    {"limit reached", Signal::LooseWord},
+    {"error", Signal::StatusContext},
+    {"status", Signal::StatusContext},
+    {"code", Signal::StatusContext},
+    {"http", Signal::StatusContext},
+    {"exceeded", Signal::LimitContext},
+    {"reached", Signal::LimitContext},
+    {"limit hit", Signal::LimitContext},
+    {"retry", Signal::LimitContext},
+    {"back off", Signal::LimitContext},
+    {"backing off", Signal::LimitContext},
+    {"quota", Signal::QuotaContext},
+    {"resource", Signal::QuotaContext},
+    {"capacity", Signal::QuotaContext},
+    {"usage", Signal::QuotaContext},
+    {"request", Signal::QuotaContext},
+    {"per day", Signal::Daily},
+    {"perday", Signal::Daily},
+    {"daily", Signal::Daily},
+};
+
+constexpr size_t PATTERN_COUNT = sizeof(PATTERNS) / sizeof(PATTERNS[0]);
+static_assert(PATTERN_COUNT <= 32, "pattern set must fit the 32-bit output masks");
+
+// Per-line findings for the context rules
+constexpr uint32_t LINE_LOOSE = 1;
+constexpr uint32_t LINE_QUOTA = 2;
+constexpr uint32_t LINE_RATE_LIMIT = 4;
+constexpr uint32_t LINE_ERROR = 8;  // Status words and limit-hit phrases
+
+bool lineIsExhausted(uint32_t line) {
+    return ((line & LINE_LOOSE) && (line & LINE_QUOTA)) ||
+           ((line & LINE_RATE_LIMIT) && (line & (LINE_ERROR | LINE_QUOTA)));
+}
+
+// Most characters between "429" and the status word that qualifies it ("Error code: 429")
+constexpr size_t STATUS_WINDOW = 16;
+constexpr size_t NONE = static_cast<size_t>(-1);
+
+bool isWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isDigit(char c) {
+    return std::isdigit(static_cast<unsigned char>(c)) != 0;
+}
+
+// "429" ending at 'end' (exclusive) is a status code rather than part of a number,
+// an identifier, or a source location like "main.cpp:429:" or "line 429"
+bool isStatusNumber(std::string_view text, size_t end) {
+    size_t start = end - 3;
+    if (end < text.size() && (isWordChar(text[end]) || text[end] == '-')) {
+        return false;
+    }
+    // A '.' is part of the number only between digits ("429.5", "4.429"), not a full stop
+    if (end + 1 < text.size() && text[end] == '.' && isDigit(text[end + 1])) {
+        return false;
+    }
+    if (start == 0) {
+        return true;
+    }
+    char before = text[start - 1];
+    if (isWordChar(before) || before == '-') {
+        return false;
+    }
+    if (before == '.' && start >= 2 && isWordChar(text[start - 2])) {
+        return false;
+    }
+    // "file.cpp:429" but not JSON's "code":429
+    if (before == ':' && start >= 2 && isWordChar(text[start - 2])) {
+        return false;
+    }
+    if (start >= 5) {
+        std::string_view word = text.substr(start - 5, 5);
+        if ((word[0] == 'l' || word[0] == 'L') && (word[1] == 'i' || word[1] == 'I') &&
+            (word[2] == 'n' || word[2] == 'N') && (word[3] == 'e' || word[3] == 'E') && word[4] == ' ') {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+ExhaustionMatcher::ExhaustionMatcher() {
+    // Compact alphabet: only bytes that occur in a pattern get a symbol, both cases alike
+    for (const Pattern& pattern : PATTERNS) {
+        for (const char* p = pattern.text; *p; p++) {
+            unsigned char c = static_cast<unsigned char>(*p);
+            if (alphabet[c] == 0) {
+                alphabet[c] = static_cast<uint8_t>(symbols);
+                alphabet[static_cast<unsigned char>(std::toupper(c))] = static_cast<uint8_t>(symbols);
+                symbols++;
+            }
+        }
+    }
+
+    // Trie of the patterns
+    std::array<int32_t, MAX_ALPHABET> empty;
+    empty.fill(-1);
+    transitions.push_back(empty);
+    outputs.push_back(0);
+    for (size_t i = 0; i < PATTERN_COUNT; i++) {
+        int32_t state = 0;
+        const char* text = PATTERNS[i].text;
+        for (const char* p = text; *p; p++) {
+            uint8_t symbol = alphabet[static_cast<unsigned char>(*p)];
+            if (transitions[state][symbol] < 0) {
+                transitions[state][symbol] = static_cast<int32_t>(transitions.size());
+                transitions.push_back(empty);
+                outputs.push_back(0);
+            }
+            state = transitions[state][symbol];
+        }
+        outputs[state] |= 1u << i;
+    }
+
+    // Failure links, folded into a complete transition table in breadth-first order
+    std::vector<int32_t> failure(transitions.size(), 0);
+    std::queue<int32_t> pending;
+    for (int symbol = 0; symbol < symbols; symbol++) {
+        int32_t child = transitions[0][symbol];
+        if (child < 0) {
+            transitions[0][symbol] = 0;
+        } else {
+            pending.push(child);
+        }
+    }
+    while (!pending.empty()) {
+        int32_t state = pending.front();
+        pending.pop();
+        outputs[state] |= outputs[failure[state]];
+        for (int symbol = 0; symbol < symbols; symbol++) {
+            int32_t child = transitions[state][symbol];
+            int32_t fallback = transitions[failure[state]][symbol];
+            if (child < 0) {
+                transitions[state][symbol] = fallback;
+            } else {
+                failure[child] = fallback;
+                pending.push(child);
+            }
+        }
+    }
+}
+
+ExhaustionKind ExhaustionMatcher::classify(std::string_view text) const {
+    int32_t state = 0;
+    uint32_t line = 0;
+    size_t statusEnd = NONE;  // Where the line's last status word and "429" ended
+    size_t status429End = NONE;
+    bool exhausted = false;
+    bool daily = false;
+
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c == '\n') {
+            exhausted = exhausted || lineIsExhausted(line);
+            if (exhausted && daily) {
+                return ExhaustionKind::DailyQuota;
+            }
+            line = 0;
+            statusEnd = NONE;
+            status429End = NONE;
+            state = 0;
+            continue;
+        }
+        state = transitions[state][alphabet[c]];
+        uint32_t hits = outputs[state];
+        for (size_t pattern = 0; hits != 0; pattern++, hits >>= 1) {
+            if ((hits & 1) == 0) {
+                continue;
+            }
+            switch (PATTERNS[pattern].signal) {
+                case Signal::Exhausted:
+                    exhausted = true;
+                    break;
+                case Signal::Status429:
+                    if (isStatusNumber(text, i + 1)) {
+                        status429End = i + 1;
+                        exhausted = exhausted || (statusEnd != NONE && i - 2 - statusEnd <= STATUS_WINDOW);
+                    }
+                    break;
+                case Signal::LooseWord:
+                    line |= LINE_LOOSE;
+                    break;
+                case Signal::RateLimitWord:
+                    line |= LINE_RATE_LIMIT;
+                    break;
+                case Signal::LimitContext:
+                    line |= LINE_ERROR;
+                    break;
+                case Signal::StatusContext: {
+                    line |= LINE_ERROR;
+                    statusEnd = i + 1;
+                    size_t start = statusEnd - std::char_traits<char>::length(PATTERNS[pattern].text);
+                    exhausted = exhausted || (status429End != NONE && start - status429End <= STATUS_WINDOW);
+                    break;
+                }
+                case Signal::QuotaContext:
+                    line |= LINE_QUOTA;
+                    break;
+                case Signal::Daily:
+                    daily = true;
+                    break;
+            }
+        }
+    }
+    exhausted = exhausted || lineIsExhausted(line);
+
+    if (!exhausted) {
+        return ExhaustionKind::None;
+    }
+    return daily ? ExhaustionKind::DailyQuota : ExhaustionKind::RateLimit;
+}
+
+const ExhaustionMatcher& exhaustionMatcher() {
+    static const ExhaustionMatcher matcher;
+    return matcher;
+}
@@ -1,4 +1,9 @@
 #include <GemStackCore.h>
+#include <TaskGraph.h>
+#include <ModelRouter.h>
+#include <WaitController.h>
+#include <SessionLogCache.h>
+#include <SessionDigest.h>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -7,13 +12,14 @@
 #include <array>
 #include <chrono>
 #include <ctime>
-#include <thread>
+#include <cctype>
+#include <climits>
+#include <random>
+#include <cmath>
+#include <cstdio>
 
 std::queue<std::string> commandQueue;
 std::mutex queueMutex;
-std::condition_variable queueCV;
-bool running = true;
-std::atomic<bool> isBusy{false};
 
 // Global config instance
 GemStackConfig g_config;
@@ -23,6 +29,27 @@ static SleeperFunction g_cooldownSleeper = nullptr;
 static std::optional<bool> g_cliCooldownEnabled;
 static std::optional<int> g_cliCooldownSeconds;
 
+// Every timed wait blocks here, so shutdown (and urgent work, for cooldowns) can end it
+static WaitController g_waits;
+
+// One token bucket per model, filled from the requestsPerMinute settings
+static ModelRateLimiter g_rateLimiter;
+
+// Picks the starting model for each prompt from its weight and the models' history
+static ModelRouter g_modelRouter;
+static std::optional<bool> g_cliModelRouting;
+
+// Serializes session log access between parallel workers
+static std::mutex g_sessionLogMutex;
+static SessionLogCache g_sessionLogCache(SESSION_LOG_FILENAME);
+
+// Older session log entries, summarized; loaded from SESSION_DIGEST_FILENAME on first use
+static std::mutex g_sessionDigestMutex;
+static SessionDigest g_sessionDigest;
+static bool g_sessionDigestLoaded = false;
+static std::optional<uint64_t> g_sessionDigestLogGeneration;  // Cache generation the digest was last checked against
+static SessionContextStats g_sessionContextStats;
+
 GemStackConfig getDefaultConfig() {
     return GemStackConfig();
 }
@@ -78,6 +105,183 @@ bool loadConfig(const std::string& filename) {
                 // Invalid value, keep default
                 g_config.cooldownSeconds = 60;
             }
+        } else if (key == "jobs") {
+            try {
+                int jobs = std::stoi(value);
+                // Fall back to a single worker if non-positive
+                g_config.jobs = (jobs > 0) ? jobs : 1;
+            } catch (...) {
+                g_config.jobs = 1;
+            }
+        } else if (key == "worktreeIsolation" || key == "worktree_isolation") {
+            g_config.worktreeIsolation = (value == "true" || value == "1" || value == "yes");
+        } else if (key == "worktreeMergeStrategy" || key == "worktree_merge_strategy") {
+            // Only "merge" and "rebase" are supported
+            g_config.worktreeMergeStrategy = (value == "rebase") ? "rebase" : "merge";
+        } else if (key == "promptTimeoutSeconds" || key == "prompt_timeout_seconds") {
+            int seconds = parseDurationSeconds(value);
+            // Invalid values disable the limit
+            g_config.promptTimeoutSeconds = (seconds > 0) ? seconds : 0;
+        } else if (key == "promptIdleTimeoutSeconds" || key == "prompt_idle_timeout_seconds") {
+            int seconds = parseDurationSeconds(value);
+            g_config.promptIdleTimeoutSeconds = (seconds > 0) ? seconds : 0;
+        } else if (key == "timeoutRetries" || key == "timeout_retries") {
+            try {
+                int retries = std::stoi(value);
+                g_config.timeoutRetries = (retries > 0) ? retries : 0;
+            } catch (...) {
+                g_config.timeoutRetries = 0;
+            }
+        } else if (key == "warmWorkersEnabled" || key == "warm_workers_enabled") {
+            g_config.warmWorkersEnabled = (value == "true" || value == "1" || value == "yes");
+        } else if (key == "warmWorkerMaxUses" || key == "warm_worker_max_uses") {
+            try {
+                int uses = std::stoi(value);
+                g_config.warmWorkerMaxUses = (uses > 0) ? uses : 20;
+            } catch (...) {
+                g_config.warmWorkerMaxUses = 20;
+            }
+        } else if (key == "warmWorkerMaxMemoryMB" || key == "warm_worker_max_memory_mb") {
+            try {
+                int megabytes = std::stoi(value);
+                g_config.warmWorkerMaxMemoryMB = (megabytes >= 0) ? megabytes : 1024;
+            } catch (...) {
+                g_config.warmWorkerMaxMemoryMB = 1024;
+            }
+        } else if (key == "outputMemoryLimitMB" || key == "output_memory_limit_mb") {
+            try {
+                int megabytes = std::stoi(value);
+                g_config.outputMemoryLimitMB = (megabytes > 0) ? megabytes : 16;
+            } catch (...) {
+                g_config.outputMemoryLimitMB = 16;
+            }
+        } else if (key == "maxLoadPerCpu" || key == "max_load_per_cpu") {
+            try {
+                double load = std::stod(value);
+                g_config.maxLoadPerCpu = (load > 0) ? load : 0;
+            } catch (...) {
+                g_config.maxLoadPerCpu = 0;
+            }
+        } else if (key == "minFreeMemoryMB" || key == "min_free_memory_mb") {
+            try {
+                int megabytes = std::stoi(value);
+                g_config.minFreeMemoryMB = (megabytes > 0) ? megabytes : 0;
+            } catch (...) {
+                g_config.minFreeMemoryMB = 0;
+            }
+        } else if (key == "maxRunningChildren" || key == "max_running_children") {
+            try {
+                int children = std::stoi(value);
+                g_config.maxRunningChildren = (children > 0) ? children : 0;
+            } catch (...) {
+                g_config.maxRunningChildren = 0;
+            }
+        } else if (key == "adaptiveConcurrency" || key == "adaptive_concurrency") {
+            g_config.adaptiveConcurrency = (value == "true" || value == "1" || value == "yes");
+        } else if (key == "requestsPerMinute" || key == "requests_per_minute") {
+            try {
+                double rate = std::stod(value);
+                g_config.requestsPerMinute = (rate > 0) ? rate : 0;
+            } catch (...) {
+                g_config.requestsPerMinute = 0;
+            }
+        } else if (key == "rateLimitBurst" || key == "rate_limit_burst") {
+            try {
+                int burst = std::stoi(value);
+                g_config.rateLimitBurst = (burst > 0) ? burst : 1;
+            } catch (...) {
+                g_config.rateLimitBurst = 1;
+            }
+        } else if (key == "rateLimitRetries" || key == "rate_limit_retries") {
+            try {
+                int retries = std::stoi(value);
+                g_config.rateLimitRetries = (retries > 0) ? retries : 0;
+            } catch (...) {
+                g_config.rateLimitRetries = 2;
+            }
+        } else if (key == "rateLimitBackoffSeconds" || key == "rate_limit_backoff_seconds") {
+            try {
+                int seconds = std::stoi(value);
+                g_config.rateLimitBackoffSeconds = (seconds > 0) ? seconds : 10;
+            } catch (...) {
+                g_config.rateLimitBackoffSeconds = 10;
+            }
+        } else if (key == "rateLimitBackoffMaxSeconds" || key == "rate_limit_backoff_max_seconds") {
+            try {
+                int seconds = std::stoi(value);
+                g_config.rateLimitBackoffMaxSeconds = (seconds > 0) ? seconds : 300;
+            } catch (...) {
+                g_config.rateLimitBackoffMaxSeconds = 300;
+            }
+        } else if (key == "modelRepromoteSeconds" || key == "model_repromote_seconds") {
+            int seconds = parseDurationSeconds(value);
+            g_config.modelRepromoteSeconds = (seconds >= 0) ? seconds : 900;
+        } else if (key == "modelBreakerFailures" || key == "model_breaker_failures") {
+            try {
+                int failures = std::stoi(value);
+                g_config.modelBreakerFailures = (failures > 0) ? failures : 3;
+            } catch (...) {
+                g_config.modelBreakerFailures = 3;
+            }
+        } else if (key == "modelBreakerOpenSeconds" || key == "model_breaker_open_seconds") {
+            int seconds = parseDurationSeconds(value);
+            g_config.modelBreakerOpenSeconds = (seconds > 0) ? seconds : 1800;
+        } else if (key == "models") {
+            // Fallback order, best first: "models=gemini-2.5-pro, gemini-2.5-flash"
+            std::vector<std::string> models;
+            std::stringstream list(value);
+            std::string model;
+            while (std::getline(list, model, ',')) {
+                model = trim(model);
+                if (!model.empty()) {
+                    models.push_back(model);
+                }
+            }
+            g_config.models = models;
+        } else if (key == "modelRouting" || key == "model_routing") {
+            g_config.modelRouting = (value == "true" || value == "1" || value == "yes");
+        } else if (key == "routeShortPromptChars" || key == "route_short_prompt_chars") {
+            try {
+                int chars = std::stoi(value);
+                g_config.routeShortPromptChars = (chars > 0) ? chars : 0;
+            } catch (...) {
+                g_config.routeShortPromptChars = 200;
+            }
+        } else if (key == "sessionDigest" || key == "session_digest") {
+            g_config.sessionDigest = (value == "true" || value == "1" || value == "yes");
+        } else if (key == "sessionRecentEntries" || key == "session_recent_entries") {
+            try {
+                int entries = std::stoi(value);
+                g_config.sessionRecentEntries = (entries > 0) ? entries : 20;
+            } catch (...) {
+                g_config.sessionRecentEntries = 20;
+            }
+        } else if (key == "sessionDigestChars" || key == "session_digest_chars") {
+            try {
+                int chars = std::stoi(value);
+                g_config.sessionDigestChars = (chars >= 0) ? chars : 2000;
+            } catch (...) {
+                g_config.sessionDigestChars = 2000;
+            }
+        } else if (key.find('.') != std::string::npos) {
+            // Per-model overrides: "requestsPerMinute.gemini-2.5-pro=5", "rateLimitBurst.gemini-2.5-pro=2",
+            // "modelTier.gemini-2.5-flash-lite=flash"
+            std::string setting = key.substr(0, key.find('.'));
+            std::string model = key.substr(key.find('.') + 1);
+            try {
+                ModelTier tier;
+                if ((setting == "modelTier" || setting == "model_tier") && parseModelTier(value, tier)) {
+                    g_config.modelTiers[model] = tier;
+                } else if (setting == "requestsPerMinute" || setting == "requests_per_minute") {
+                    double rate = std::stod(value);
+                    g_config.modelRateLimits[model].requestsPerMinute = (rate > 0) ? rate : 0;
+                } else if (setting == "rateLimitBurst" || setting == "rate_limit_burst") {
+                    int burst = std::stoi(value);
+                    g_config.modelRateLimits[model].burst = (burst > 0) ? burst : 0;
+                }
+            } catch (...) {
+                // Ignore malformed per-model values; the default limit applies
+            }
         }
     }
 
@@ -89,11 +293,26 @@ bool loadConfig(const std::string& filename) {
         std::cout << "[GemStack] Cooldown enabled: " << g_config.cooldownSeconds << " seconds between prompts" << std::endl;
     }
 
+    if (g_config.requestsPerMinute > 0) {
+        std::cout << "[GemStack] Rate limit: " << g_config.requestsPerMinute << " requests per minute per model, burst "
+                  << g_config.rateLimitBurst << std::endl;
+    }
+
+    if (g_config.jobs > 1) {
+        std::cout << "[GemStack] Parallel jobs: " << g_config.jobs << std::endl;
+    }
+
+    if (g_config.promptTimeoutSeconds > 0 || g_config.promptIdleTimeoutSeconds > 0) {
+        std::cout << "[GemStack] Prompt timeouts: " << g_config.promptTimeoutSeconds << "s total, "
+                  << g_config.promptIdleTimeoutSeconds << "s without output (0 = none)" << std::endl;
+    }
+
     return true;
 }
 
 // Model fallback list - ordered from best to least-best
-std::vector<std::string> modelFallbackList = {
+// Built-in fallback order, used unless the config lists models
+static const std::vector<std::string> DEFAULT_MODELS = {
     "gemini-3-pro-preview",
     "gemini-3-flash-preview",
     "gemini-2.5-pro",
@@ -101,31 +320,100 @@ std::vector<std::string> modelFallbackList = {
     "gemini-1.5-pro",
     "gemini-1.5-flash"
 };
+
+std::vector<std::string> modelFallbackList = DEFAULT_MODELS;
 std::atomic<size_t> currentModelIndex{0};
 
-std::string getCurrentModel() {
-    size_t idx = currentModelIndex.load();
-    if (idx < modelFallbackList.size()) {
-        return modelFallbackList[idx];
+void configureModelRouting(std::optional<bool> cliRouting) {
+    modelFallbackList = g_config.models.empty() ? DEFAULT_MODELS : g_config.models;
+    currentModelIndex = 0;
+    g_cliModelRouting = cliRouting;
+    g_modelRouter.configure(modelFallbackList, g_config.modelTiers);
+}
+
+bool isModelRoutingEnabled() {
+    return g_cliModelRouting.value_or(g_config.modelRouting);
+}
+
+PromptWeight getPromptWeight(const std::string& promptContent, bool metaQuery) {
+    if (metaQuery) {
+        return PromptWeight::Light;
+    }
+    return classifyPromptWeight(promptContent, static_cast<size_t>(g_config.routeShortPromptChars));
+}
+
+size_t routeModel(PromptWeight weight) {
+    return g_modelRouter.route(weight);
+}
+
+void recordModelOutcome(const std::string& model, bool success, double latencySeconds) {
+    g_modelRouter.recordOutcome(model, success, latencySeconds);
+}
+
+ModelStats getModelStats(const std::string& model) {
+    return g_modelRouter.stats(model);
+}
+
+std::string getModelAt(size_t modelIndex) {
+    if (modelIndex < modelFallbackList.size()) {
+        return modelFallbackList[modelIndex];
     }
     return modelFallbackList.back();
 }
 
-bool downgradeModel() {
-    size_t idx = currentModelIndex.load();
-    if (idx + 1 < modelFallbackList.size()) {
-        currentModelIndex.store(idx + 1);
-        std::cout << "[GemStack] Model exhausted. Downgrading to: " << getCurrentModel() << std::endl;
+bool downgradeModel(size_t& modelIndex) {
+    if (modelIndex + 1 < modelFallbackList.size()) {
+        modelIndex++;
+        std::cout << "[GemStack] Model exhausted. Downgrading to: " << getModelAt(modelIndex) << std::endl;
         return true;
     }
     std::cerr << "[GemStack] All models exhausted. No fallback available." << std::endl;
     return false;
 }
 
+std::string getCurrentModel() {
+    return getModelAt(currentModelIndex.load());
+}
+
+bool downgradeModel() {
+    size_t idx = currentModelIndex.load();
+    if (!downgradeModel(idx)) {
+        return false;
+    }
+    currentModelIndex.store(idx);
+    return true;
+}
+
 void resetModelToTop() {
     currentModelIndex.store(0);
 }
 
+bool maybePromoteModel(size_t& modelIndex, ModelPromotionState& state, std::chrono::steady_clock::time_point now) {
+    // One probe at a time: a probe that ended without a verdict (timeout, other error) continues
+    if (modelIndex == 0 || state.probing || g_config.modelRepromoteSeconds <= 0 || now < state.promoteAt) {
+        return false;
+    }
+    modelIndex--;
+    state.probing = true;
+    std::cout << "[GemStack] Trying " << getModelAt(modelIndex) << " again after the downgrade" << std::endl;
+    return true;
+}
+
+void noteModelDowngraded(ModelPromotionState& state, std::chrono::steady_clock::time_point now) {
+    state.probing = false;
+    state.promoteAt = now + std::chrono::seconds(g_config.modelRepromoteSeconds);
+}
+
+void noteModelSucceeded(size_t modelIndex, ModelPromotionState& state, std::chrono::steady_clock::time_point now) {
+    if (!state.probing) {
+        return;
+    }
+    state.probing = false;
+    std::cout << "[GemStack] Re-promoted to " << getModelAt(modelIndex) << std::endl;
+    // Keep climbing one tier per window while the better models hold up
+    state.promoteAt = now + std::chrono::seconds(g_config.modelRepromoteSeconds);
+}
+
 // Escape a string for safe shell usage
 std::string escapeForShell(const std::string& input) {
     std::string escaped;
@@ -157,31 +445,167 @@ std::string escapeForShell(const std::string& input) {
     return escaped;
 }
 
+// Split a command line into argv-style arguments (no shell expansion)
+std::vector<std::string> splitCommandArguments(const std::string& commandLine) {
+    std::vector<std::string> args;
+    std::string current;
+    bool inArgument = false;
+    char quote = 0;
+
+    for (size_t i = 0; i < commandLine.size(); i++) {
+        char c = commandLine[i];
+        if (quote) {
+            if (c == quote) {
+                quote = 0;
+            } else if (quote == '"' && c == '\\' && i + 1 < commandLine.size()) {
+                current += commandLine[++i];
+            } else {
+                current += c;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+            inArgument = true;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (inArgument) {
+                args.push_back(current);
+                current.clear();
+                inArgument = false;
+            }
+        } else {
+            current += c;
+            inArgument = true;
+        }
+    }
+    if (inArgument) {
+        args.push_back(current);
+    }
+    return args;
+}
+
 // Check if output indicates model exhaustion/rate limit
 bool isModelExhausted(const std::string& output) {
-    const std::vector<std::string> exhaustionPatterns = {
-        "rate limit",
-        "Rate limit",
-        "RATE_LIMIT",
-        "quota exceeded",
-        "Quota exceeded",
-        "QUOTA_EXCEEDED",
-        "resource exhausted",
-        "Resource exhausted",
-        "RESOURCE_EXHAUSTED",
-        "too many requests",
-        "Too many requests",
-        "429",
-        "limit reached",
-        "exhausted"
+    return exhaustionMatcher().classify(output) != ExhaustionKind::None;
+}
+
+static std::string toLowerCopy(const std::string& text) {
+    std::string lower = text;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return lower;
+}
+
+// Parse a duration such as "37s", "37.59s", "1m30s", "2h 5m", "500ms" or a bare "20"
+// (seconds) starting at pos. Returns seconds, or -1 if no number is there.
+static double parseDurationAt(const std::string& lower, size_t pos) {
+    double total = 0;
+    bool found = false;
+    while (true) {
+        while (pos < lower.size() && (lower[pos] == ' ' || lower[pos] == '"' || lower[pos] == '\'' ||
+                                      lower[pos] == ':' || lower[pos] == '=')) {
+            pos++;
+        }
+        size_t numberStart = pos;
+        while (pos < lower.size() && (std::isdigit(static_cast<unsigned char>(lower[pos])) || lower[pos] == '.')) {
+            pos++;
+        }
+        if (pos == numberStart) {
+            break;
+        }
+        double value = 0;
+        try {
+            value = std::stod(lower.substr(numberStart, pos - numberStart));
+        } catch (...) {
+            break;
+        }
+        while (pos < lower.size() && lower[pos] == ' ') {
+            pos++;
+        }
+        size_t unitStart = pos;
+        while (pos < lower.size() && std::isalpha(static_cast<unsigned char>(lower[pos]))) {
+            pos++;
+        }
+        std::string unit = lower.substr(unitStart, pos - unitStart);
+        if (unit == "ms" || unit.rfind("milli", 0) == 0) {
+            value /= 1000;
+        } else if (unit == "m" || unit.rfind("min", 0) == 0) {
+            value *= 60;
+        } else if (unit == "h" || unit == "hr" || unit == "hrs" || unit.rfind("hour", 0) == 0) {
+            value *= 3600;
+        } else if (!unit.empty() && unit != "s" && unit.rfind("sec", 0) != 0) {
+            // "retry in 5 attempts" is not a delay; keep what was read so far
+            pos = unitStart;
+            if (!found) {
+                return -1;
+            }
+            break;
+        }
+        total += value;
+        found = true;
+        if (unit.empty()) {
+            break;  // A bare number ends the duration
+        }
+    }
+    return found ? total : -1;
+}
+
+int parseRetryAfterSeconds(const std::string& text) {
+    static const std::vector<std::string> markers = {
+        "retrydelay", "retry-after", "retry after", "retry in", "try again in",
+        "reset after", "resets after", "reset in", "resets in"
     };
 
-    for (const auto& pattern : exhaustionPatterns) {
-        if (output.find(pattern) != std::string::npos) {
-            return true;
+    std::string lower = toLowerCopy(text);
+    for (const auto& marker : markers) {
+        size_t pos = lower.find(marker);
+        while (pos != std::string::npos) {
+            double seconds = parseDurationAt(lower, pos + marker.size());
+            if (seconds >= 0) {
+                return std::max(1, static_cast<int>(std::ceil(seconds)));
+            }
+            pos = lower.find(marker, pos + marker.size());
         }
     }
-    return false;
+    return -1;
+}
+
+ExhaustionInfo classifyExhaustion(const std::string& errorOutput) {
+    ExhaustionInfo info;
+    info.kind = exhaustionMatcher().classify(errorOutput);
+    if (!info.exhausted()) {
+        return info;
+    }
+
+    std::string lower = toLowerCopy(errorOutput);
+    info.retryAfterSeconds = parseRetryAfterSeconds(errorOutput);
+
+    // Model names look like "gemini-2.5-pro". Only names from the model list count: the CLI's
+    // "Full report available at: /tmp/gemini-client-error-....json" is not a model.
+    for (size_t modelStart = lower.find("gemini-"); modelStart != std::string::npos;
+         modelStart = lower.find("gemini-", modelStart + 1)) {
+        size_t modelEnd = modelStart;
+        while (modelEnd < lower.size() && (std::isalnum(static_cast<unsigned char>(lower[modelEnd])) ||
+                                           lower[modelEnd] == '-' || lower[modelEnd] == '.' || lower[modelEnd] == '_')) {
+            modelEnd++;
+        }
+        while (modelEnd > modelStart && (lower[modelEnd - 1] == '.' || lower[modelEnd - 1] == '-')) {
+            modelEnd--;  // Sentence punctuation
+        }
+        std::string name = lower.substr(modelStart, modelEnd - modelStart);
+        for (const auto& model : modelFallbackList) {
+            if (toLowerCopy(model) == name) {
+                info.model = model;
+                return info;
+            }
+        }
+    }
+    return info;
+}
+
+ExhaustionInfo classifyExhaustedRun(int exitCode, const std::string& errorOutput) {
+    if (exitCode == 0) {
+        return ExhaustionInfo();
+    }
+    return classifyExhaustion(errorOutput);
 }
 
 // Helper to trim whitespace from both ends
@@ -231,7 +655,62 @@ bool startsWithDirective(const std::string& trimmedLine, const std::string& dire
     return trimmedLine.find(directive) == 0;
 }
 
+int parseDurationSeconds(const std::string& value) {
+    std::string trimmed = trim(value);
+    if (trimmed.empty()) {
+        return -1;
+    }
+
+    int multiplier = 1;
+    char unit = trimmed.back();
+    if (unit == 's' || unit == 'm' || unit == 'h') {
+        multiplier = (unit == 'h') ? 3600 : (unit == 'm') ? 60 : 1;
+        trimmed.pop_back();
+    }
+    if (trimmed.empty() || !std::all_of(trimmed.begin(), trimmed.end(),
+                                        [](unsigned char c) { return std::isdigit(c); })) {
+        return -1;
+    }
+
+    try {
+        long long seconds = std::stoll(trimmed) * multiplier;
+        return seconds > INT_MAX ? -1 : static_cast<int>(seconds);
+    } catch (...) {
+        return -1;
+    }
+}
+
+// Extract a quoted attribute such as: id "frontend" (used on PromptBlockSTART lines)
+std::string extractQuotedAttribute(const std::string& line, const std::string& key) {
+    std::string marker = key + " \"";
+    size_t pos = line.find(marker);
+    // Require a word boundary so 'id' does not match inside another word
+    while (pos != std::string::npos && pos > 0 && line[pos - 1] != ' ' && line[pos - 1] != '\t') {
+        pos = line.find(marker, pos + 1);
+    }
+    if (pos == std::string::npos) {
+        return "";
+    }
+    size_t valueStart = pos + marker.length();
+    size_t valueEnd = line.find('"', valueStart);
+    if (valueEnd == std::string::npos) {
+        return "";
+    }
+    return line.substr(valueStart, valueEnd - valueStart);
+}
+
 bool loadCommandsFromFile(const std::string& filename) {
+    std::vector<TaskSpec> tasks;
+    bool commandsLoaded = loadTasksFromFile(filename, tasks);
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (const auto& task : tasks) {
+        commandQueue.push(task.command);
+    }
+    return commandsLoaded;
+}
+
+bool loadTasksFromFile(const std::string& filename, std::vector<TaskSpec>& tasks) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cout << "[GemStack] " << filename << " not found. Skipping file input." << std::endl;
@@ -253,6 +732,50 @@ bool loadCommandsFromFile(const std::string& filename) {
     // Current block's goal (high-level description of final product)
     std::string currentBlockGoal;
 
+    // Scheduling labels for the next task ('id' / 'after') and for the current block
+    std::string pendingId;
+    std::vector<std::string> pendingAfter;
+    int pendingTimeout = -1;
+    int pendingIdleTimeout = -1;
+    std::string currentBlockId;
+    std::vector<std::string> currentBlockAfter;
+    bool blockHasTasks = false;
+
+    auto queueTask = [&](const std::string& command) {
+        TaskSpec task;
+        task.command = command;
+        task.id = pendingId;
+        task.after = pendingAfter;
+        task.timeoutSeconds = pendingTimeout;
+        task.idleTimeoutSeconds = pendingIdleTimeout;
+        if (inPromptBlock) {
+            task.block = promptBlockCount;
+            task.blockId = currentBlockId;
+            // The block's own dependencies gate its first task; the rest follow in order
+            if (!blockHasTasks) {
+                task.after.insert(task.after.end(), currentBlockAfter.begin(), currentBlockAfter.end());
+            }
+            blockHasTasks = true;
+        }
+        tasks.push_back(task);
+        pendingId.clear();
+        pendingAfter.clear();
+        pendingTimeout = -1;
+        pendingIdleTimeout = -1;
+        commandsLoaded = true;
+    };
+
+    auto warnUnusedLabels = [&](const std::string& where) {
+        if (!pendingId.empty() || !pendingAfter.empty() || pendingTimeout >= 0 || pendingIdleTimeout >= 0) {
+            std::cout << "[GemStack] Warning: id/after/timeout directive at end of " << where
+                      << " with no following prompt" << std::endl;
+            pendingId.clear();
+            pendingAfter.clear();
+            pendingTimeout = -1;
+            pendingIdleTimeout = -1;
+        }
+    };
+
     // Multi-line parsing state
     bool inMultiLine = false;
     std::string multiLineBuffer;
@@ -342,11 +865,7 @@ bool loadCommandsFromFile(const std::string& filename) {
                             std::cout << "[GemStack] Prompt queued (multi-line)" << std::endl;
                         }
 
-                        {
-                            std::lock_guard<std::mutex> lock(queueMutex);
-                            commandQueue.push(finalCommand);
-                            commandsLoaded = true;
-                        }
+                        queueTask(finalCommand);
                     }
                 }
                 
@@ -379,7 +898,14 @@ bool loadCommandsFromFile(const std::string& filename) {
             pendingSpecifications.clear(); // Clear specs at block start
             pendingStyles.clear();         // Clear styles at block start
             currentBlockGoal.clear();      // Clear goal at block start
-            std::cout << "[GemStack] Entering PromptBlock " << promptBlockCount << std::endl;
+            warnUnusedLabels("file section");
+            // Optional scheduling labels: PromptBlockSTART id "name" after "other"
+            currentBlockId = extractQuotedAttribute(trimmedLine, "id");
+            currentBlockAfter = parseLabelList(extractQuotedAttribute(trimmedLine, "after"));
+            blockHasTasks = false;
+            std::cout << "[GemStack] Entering PromptBlock " << promptBlockCount;
+            if (!currentBlockId.empty()) std::cout << " (" << currentBlockId << ")";
+            std::cout << std::endl;
             continue;
         }
         if (trimmedLine.find("PromptBlockEND") != std::string::npos) {
@@ -392,6 +918,9 @@ bool loadCommandsFromFile(const std::string& filename) {
             }
             currentBlockGoal.clear(); // Clear goal when exiting block
             pendingStyles.clear();    // Clear styles when exiting block
+            warnUnusedLabels("block");
+            currentBlockId.clear();
+            currentBlockAfter.clear();
             std::cout << "[GemStack] Exiting PromptBlock " << promptBlockCount << std::endl;
             continue;
         }
@@ -424,6 +953,39 @@ bool loadCommandsFromFile(const std::string& filename) {
             }
         }
 
+        // Handle 'id' directive - labels the next prompt so others can depend on it
+        if (startsWithDirective(trimmedLine, "id ")) {
+            std::string idContent = trim(extractDirectiveContent(trimmedLine, "id "));
+            if (!idContent.empty()) {
+                pendingId = idContent;
+                std::cout << "[GemStack] Next task labelled \"" << idContent << "\"" << std::endl;
+            }
+            continue;
+        }
+
+        // Handle 'after' directive - the next prompt waits for the listed ids/blocks
+        if (startsWithDirective(trimmedLine, "after ")) {
+            std::vector<std::string> afterLabels = parseLabelList(extractDirectiveContent(trimmedLine, "after "));
+            pendingAfter.insert(pendingAfter.end(), afterLabels.begin(), afterLabels.end());
+            continue;
+        }
+
+        // Handle 'timeout' / 'idletimeout' directives - limits for the next prompt only
+        if (startsWithDirective(trimmedLine, "timeout ") || startsWithDirective(trimmedLine, "idletimeout ")) {
+            bool idle = startsWithDirective(trimmedLine, "idletimeout ");
+            std::string value = extractDirectiveContent(trimmedLine, idle ? "idletimeout " : "timeout ");
+            int seconds = parseDurationSeconds(value);
+            if (seconds < 0) {
+                std::cout << "[GemStack] Warning: invalid " << (idle ? "idletimeout" : "timeout")
+                          << " \"" << value << "\" ignored" << std::endl;
+            } else if (idle) {
+                pendingIdleTimeout = seconds;
+            } else {
+                pendingTimeout = seconds;
+            }
+            continue;
+        }
+
         // Handle 'goal' directive - sets high-level objective for the block
         if (startsWithDirective(trimmedLine, "goal ")) {
             std::string goalContent = extractDirectiveContent(trimmedLine, "goal ");
@@ -523,22 +1085,14 @@ bool loadCommandsFromFile(const std::string& filename) {
                     std::cout << "[GemStack] Prompt queued from " << filename << std::endl;
                 }
 
-                {
-                    std::lock_guard<std::mutex> lock(queueMutex);
-                    commandQueue.push(finalCommand);
-                    commandsLoaded = true;
-                }
+                queueTask(finalCommand);
             }
             continue;
         }
 
         // For any other command (not prompt, specify, or goal), queue it directly
         // This handles things like --help, --version, etc.
-        {
-            std::lock_guard<std::mutex> lock(queueMutex);
-            commandQueue.push(trimmedLine);
-            commandsLoaded = true;
-        }
+        queueTask(trimmedLine);
         std::cout << "[GemStack] Command queued from " << filename << std::endl;
     }
 
@@ -547,6 +1101,7 @@ bool loadCommandsFromFile(const std::string& filename) {
         std::cout << "[GemStack] Warning: " << pendingSpecifications.size()
                   << " specify statement(s) at end of file with no following prompt" << std::endl;
     }
+    warnUnusedLabels("file");
 
     return commandsLoaded;
 }
@@ -595,11 +1150,18 @@ std::string extractFirstMeaningfulLine(const std::string& output, size_t maxLeng
         return "Completed";
     }
 
-    std::istringstream stream(output);
+    // Walk the lines in place rather than copying all of output into a stream
     std::string line;
     std::string result;
 
-    while (std::getline(stream, line)) {
+    for (size_t start = 0; start < output.size();) {
+        size_t end = output.find('\n', start);
+        if (end == std::string::npos) {
+            end = output.size();
+        }
+        line.assign(output, start, end - start);
+        start = end + 1;
+
         // Skip empty lines
         if (line.empty()) continue;
 
@@ -633,17 +1195,14 @@ std::string getSessionLogPath() {
 }
 
 std::string readSessionLog() {
-    std::ifstream file(SESSION_LOG_FILENAME);
-    if (!file.is_open()) {
-        return "";
-    }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    std::lock_guard<std::mutex> lock(g_sessionLogMutex);
+    // Only the lines appended since the previous prompt are read from disk
+    return g_sessionLogCache.contents();
 }
 
 void appendToSessionLog(const std::string& promptSummary, bool success, const std::string& notes) {
+    std::lock_guard<std::mutex> lock(g_sessionLogMutex);
+
     // Open in append mode
     std::ofstream file(SESSION_LOG_FILENAME, std::ios::app);
     if (!file.is_open()) {
@@ -676,8 +1235,18 @@ void appendToSessionLog(const std::string& promptSummary, bool success, const st
 }
 
 void clearSessionLog() {
+    std::lock_guard<std::mutex> lock(g_sessionLogMutex);
+
     // Open in truncate mode to clear the file
     std::ofstream file(SESSION_LOG_FILENAME, std::ios::trunc);
+    g_sessionLogCache.invalidate();
+    {
+        std::lock_guard<std::mutex> digestLock(g_sessionDigestMutex);
+        g_sessionDigest.clear();
+        g_sessionDigestLoaded = true;
+        g_sessionDigestLogGeneration.reset();
+        std::remove(SESSION_DIGEST_FILENAME.c_str());
+    }
     if (file.is_open()) {
         file.close();
         std::cout << "[GemStack] Session log cleared." << std::endl;
@@ -685,7 +1254,44 @@ void clearSessionLog() {
 }
 
 std::string buildSessionContext() {
-    std::string sessionLog = readSessionLog();
+    uint64_t logGeneration = 0;
+    std::string sessionLog;
+    {
+        std::lock_guard<std::mutex> lock(g_sessionLogMutex);
+        sessionLog = g_sessionLogCache.contents(logGeneration);
+    }
+    std::string digest;
+    std::string recent = sessionLog;
+
+    if (g_config.sessionDigest && !sessionLog.empty()) {
+        std::lock_guard<std::mutex> lock(g_sessionDigestMutex);
+        if (!g_sessionDigestLoaded) {
+            g_sessionDigest.load(SESSION_DIGEST_FILENAME);
+            g_sessionDigestLoaded = true;
+        }
+        g_sessionDigest.setMaxChars(static_cast<size_t>(g_config.sessionDigestChars));
+        // The folded prefix is only hashed again when the cache saw the log rewritten
+        bool verifyPrefix = g_sessionDigestLogGeneration != logGeneration;
+        BoundedSessionLog bounded = boundSessionLog(sessionLog, static_cast<size_t>(g_config.sessionRecentEntries),
+                                                    g_sessionDigest, verifyPrefix);
+        g_sessionDigestLogGeneration = logGeneration;
+        if (bounded.digestChanged) {
+            g_sessionDigest.save(SESSION_DIGEST_FILENAME);
+        }
+        digest = bounded.digest;
+        recent = bounded.recent;
+
+        g_sessionContextStats.prompts++;
+        g_sessionContextStats.logBytes += bounded.logBytes;
+        g_sessionContextStats.sentBytes += bounded.keptBytes();
+        if (bounded.keptBytes() < bounded.logBytes) {
+            uint64_t saved = bounded.logBytes - bounded.keptBytes();
+            std::cout << "[GemStack] Session context: " << g_sessionDigest.foldedEntries() << " older entries summarized, "
+                      << bounded.keptBytes() << " of " << bounded.logBytes << " bytes sent (~"
+                      << estimateTokens(saved) << " tokens saved)" << std::endl;
+        }
+    }
+
     std::string context;
 
     // Always include the session log instruction, even if empty
@@ -695,7 +1301,11 @@ std::string buildSessionContext() {
     if (!sessionLog.empty()) {
         context += "\nPREVIOUS SESSION HISTORY (from " + SESSION_LOG_FILENAME + "):\n";
         context += "---\n";
-        context += sessionLog;
+        if (!digest.empty()) {
+            context += digest;
+            context += "Most recent entries:\n";
+        }
+        context += recent;
         context += "---\n";
         context += "Review this history to understand what has been completed. Do not repeat completed work.\n";
     } else {
@@ -706,12 +1316,43 @@ std::string buildSessionContext() {
     return context;
 }
 
+SessionContextStats getSessionContextStats() {
+    std::lock_guard<std::mutex> lock(g_sessionDigestMutex);
+    return g_sessionContextStats;
+}
+
 // ============================================================================
 // Cooldown Management
 // ============================================================================
 
 void defaultSleeper(int seconds) {
-    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    g_waits.waitFor(std::chrono::seconds(seconds));
+}
+
+// Wait through the injected sleeper if there is one. Interruptible waits (idle pauses)
+// also end when urgent work arrives; returns false if the wait was cut short.
+static bool sleepSeconds(int seconds, bool interruptible = false) {
+    if (g_cooldownSleeper) {
+        g_cooldownSleeper(seconds);
+        return !g_waits.cancelled();
+    }
+    return g_waits.waitFor(std::chrono::seconds(seconds), interruptible) == WaitOutcome::Elapsed;
+}
+
+void requestShutdown() {
+    g_waits.cancel();
+}
+
+bool isShutdownRequested() {
+    return g_waits.cancelled();
+}
+
+void resetShutdown() {
+    g_waits.reset();
+}
+
+void wakeIdleWaits() {
+    g_waits.wake();
 }
 
 void setCooldownSleeper(SleeperFunction sleeper) {
@@ -749,18 +1390,85 @@ int getEffectiveCooldownSeconds() {
 }
 
 bool performCooldown() {
-    if (!isCooldownEnabled()) {
+    if (!isCooldownEnabled() || isShutdownRequested()) {
         return false;
     }
 
     int seconds = getEffectiveCooldownSeconds();
     std::cout << "[GemStack] Cooldown: waiting " << seconds << " seconds..." << std::endl;
 
-    if (g_cooldownSleeper) {
-        g_cooldownSleeper(seconds);
-    } else {
-        defaultSleeper(seconds);
+    // Only an idle pause: new urgent work or shutdown ends it
+    if (!sleepSeconds(seconds, true) && !isShutdownRequested()) {
+        std::cout << "[GemStack] Cooldown cut short: new work was queued" << std::endl;
+    }
+
+    return true;
+}
+
+// ============================================================================
+// Per-model Rate Limiting
+// ============================================================================
+
+void configureRateLimits(std::optional<double> cliRequestsPerMinute) {
+    RateLimit defaults;
+    defaults.requestsPerMinute = cliRequestsPerMinute.value_or(g_config.requestsPerMinute);
+    defaults.burst = g_config.rateLimitBurst;
+    g_rateLimiter.configure(defaults, g_config.modelRateLimits);
+}
+
+bool isRateLimitEnabled() {
+    return g_rateLimiter.enabled();
+}
+
+bool waitForModelBudget(const std::string& model) {
+    std::chrono::milliseconds wait = g_rateLimiter.reserve(model);
+    if (wait.count() <= 0) {
+        return false;
     }
 
+    // The sleeper works in whole seconds; round up so the bucket is never overdrawn
+    int seconds = static_cast<int>((wait.count() + 999) / 1000);
+    std::cout << "[GemStack] Rate limit for " << model << ": waiting " << seconds << " seconds..." << std::endl;
+
+    sleepSeconds(seconds);
+
     return true;
 }
+
+// ============================================================================
+// Rate-limit Backoff
+// ============================================================================
+
+int rateLimitBackoffSeconds(int attempt, int baseSeconds, int maxSeconds, double unitRandom) {
+    baseSeconds = std::max(baseSeconds, 1);
+    maxSeconds = std::max(maxSeconds, baseSeconds);
+    long long cap = baseSeconds;
+    for (int i = 0; i < attempt && cap < maxSeconds; i++) {
+        cap *= 2;
+    }
+    cap = std::min<long long>(cap, maxSeconds);
+
+    double half = cap / 2.0;
+    unitRandom = std::clamp(unitRandom, 0.0, 1.0);
+    return std::max(1, static_cast<int>(std::ceil(half + unitRandom * half)));
+}
+
+int performRateLimitBackoff(int attempt) {
+    thread_local std::mt19937 generator{std::random_device{}()};
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    int seconds = rateLimitBackoffSeconds(attempt, g_config.rateLimitBackoffSeconds,
+                                          g_config.rateLimitBackoffMaxSeconds, unit(generator));
+    std::cout << "[GemStack] Rate limited; backing off " << seconds << " seconds before retrying the same model ("
+              << (attempt + 1) << "/" << g_config.rateLimitRetries << ")..." << std::endl;
+
+    sleepSeconds(seconds);
+
+    return seconds;
+}
+
+void performRetryAfterWait(const std::string& model, int seconds) {
+    std::cout << "[GemStack] " << model << " asked to be retried in " << seconds << " seconds; waiting..." << std::endl;
+
+    sleepSeconds(seconds);
+}
@@ -39,30 +39,37 @@ bool GitAutoCommit::isEnabled() const {
     return m_config.enabled;
 }
 
-bool GitAutoCommit::isGitRepository() {
+std::string GitAutoCommit::gitCommand(const std::string& args, const std::string& workingDir) {
+    if (workingDir.empty() || workingDir == ".") {
+        return "git " + args;
+    }
+    return "git -C \"" + workingDir + "\" " + args;
+}
+
+bool GitAutoCommit::isGitRepository(const std::string& workingDir) {
 #ifdef _WIN32
-    int result = system("git rev-parse --is-inside-work-tree >nul 2>&1");
+    int result = system(gitCommand("rev-parse --is-inside-work-tree >nul 2>&1", workingDir).c_str());
 #else
-    int result = system("git rev-parse --is-inside-work-tree >/dev/null 2>&1");
+    int result = system(gitCommand("rev-parse --is-inside-work-tree >/dev/null 2>&1", workingDir).c_str());
 #endif
     return result == 0;
 }
 
-bool GitAutoCommit::initializeRepository() {
+bool GitAutoCommit::initializeRepository(const std::string& workingDir) {
 #ifdef _WIN32
-    int result = system("git init >nul 2>&1");
+    int result = system(gitCommand("init >nul 2>&1", workingDir).c_str());
 #else
-    int result = system("git init >/dev/null 2>&1");
+    int result = system(gitCommand("init >/dev/null 2>&1", workingDir).c_str());
 #endif
     return result == 0;
 }
 
-bool GitAutoCommit::hasUncommittedChanges() {
+bool GitAutoCommit::hasUncommittedChanges(const std::string& workingDir) {
     // Check for any changes using git status --porcelain
 #ifdef _WIN32
-    FILE* pipe = popen("git status --porcelain 2>nul", "r");
+    FILE* pipe = popen(gitCommand("status --porcelain 2>nul", workingDir).c_str(), "r");
 #else
-    FILE* pipe = popen("git status --porcelain 2>/dev/null", "r");
+    FILE* pipe = popen(gitCommand("status --porcelain 2>/dev/null", workingDir).c_str(), "r");
 #endif
 
     if (!pipe) {
@@ -189,45 +196,56 @@ std::string GitAutoCommit::formatCommitSubject(const std::string& promptSummary)
     return subject;
 }
 
-bool GitAutoCommit::stageAllChanges() {
+bool GitAutoCommit::stageAllChanges(const std::string& workingDir) {
 #ifdef _WIN32
-    int result = system("git add -A >nul 2>&1");
+    int result = system(gitCommand("add -A >nul 2>&1", workingDir).c_str());
 #else
-    int result = system("git add -A >/dev/null 2>&1");
+    int result = system(gitCommand("add -A >/dev/null 2>&1", workingDir).c_str());
 #endif
     return result == 0;
 }
 
-bool GitAutoCommit::createCommit(const std::string& message) {
+bool GitAutoCommit::createCommit(const std::string& message, const std::string& workingDir) {
     std::string escapedMessage = escapeForGitMessage(message);
 
 #ifdef _WIN32
-    std::string command = "git commit -m \"" + escapedMessage + "\" >nul 2>&1";
+    std::string command = gitCommand("commit -m \"" + escapedMessage + "\" >nul 2>&1", workingDir);
 #else
-    std::string command = "git commit -m \"" + escapedMessage + "\" >/dev/null 2>&1";
+    std::string command = gitCommand("commit -m \"" + escapedMessage + "\" >/dev/null 2>&1", workingDir);
 #endif
 
     int result = system(command.c_str());
     return result == 0;
 }
 
+bool GitAutoCommit::commitAllChanges(const std::string& message, const std::string& workingDir) {
+    if (!hasUncommittedChanges(workingDir)) {
+        return false;
+    }
+    return stageAllChanges(workingDir) && createCommit(message, workingDir);
+}
+
 bool GitAutoCommit::maybeCommit(const std::string& promptSummary) {
+    return maybeCommit(promptSummary, "");
+}
+
+bool GitAutoCommit::maybeCommit(const std::string& promptSummary, const std::string& workingDir) {
     // Check if auto-commit is enabled (considering CLI overrides)
     if (!isEnabled()) {
         return false;
     }
 
     // Check if we're in a git repository
-    if (!isGitRepository()) {
+    if (!isGitRepository(workingDir)) {
         std::cout << "[GemStack] Repository not initialized. Initializing git repository..." << std::endl;
-        if (!initializeRepository()) {
+        if (!initializeRepository(workingDir)) {
             std::cerr << "[GemStack] Auto-commit failed: could not initialize git repository" << std::endl;
             return false;
         }
     }
 
     // Check if there are changes to commit
-    if (!hasUncommittedChanges()) {
+    if (!hasUncommittedChanges(workingDir)) {
         std::cout << "[GemStack] Auto-commit skipped: no changes detected" << std::endl;
         return false;
     }
@@ -238,13 +256,13 @@ bool GitAutoCommit::maybeCommit(const std::string& promptSummary) {
     std::cout << "[GemStack] Auto-committing changes..." << std::endl;
 
     // Stage all changes
-    if (!stageAllChanges()) {
+    if (!stageAllChanges(workingDir)) {
         std::cerr << "[GemStack] Auto-commit failed: could not stage changes" << std::endl;
         return false;
     }
 
     // Create the commit
-    if (!createCommit(commitMessage)) {
+    if (!createCommit(commitMessage, workingDir)) {
         std::cerr << "[GemStack] Auto-commit failed: could not create commit" << std::endl;
         return false;
     }
@@ -0,0 +1,213 @@
+#include <ModelHealth.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+std::string breakerStateName(BreakerState state) {
+    switch (state) {
+        case BreakerState::Open: return "open";
+        case BreakerState::HalfOpen: return "half-open";
+        default: return "closed";
+    }
+}
+
+static BreakerState parseBreakerState(const std::string& name) {
+    if (name == "open") return BreakerState::Open;
+    if (name == "half-open") return BreakerState::HalfOpen;
+    return BreakerState::Closed;
+}
+
+static bool writeRecords(const std::string& path, const std::map<std::string, ModelHealthRecord>& records) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "# GemStack model health: model state failures lastExhausted openUntil (epoch seconds)\n";
+    for (const auto& [model, entry] : records) {
+        file << model << " " << breakerStateName(entry.state) << " " << entry.recentFailures << " "
+             << entry.lastExhausted << " " << entry.openUntil << "\n";
+    }
+    return file.good();
+}
+
+ModelHealthTable::ModelHealthTable(int failureThreshold, int openSeconds, ClockFunction clock)
+    : failureThreshold(std::max(failureThreshold, 1)), openSeconds(std::max(openSeconds, 1)), clock(std::move(clock)) {}
+
+void ModelHealthTable::setPolicy(int newFailureThreshold, int newOpenSeconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    failureThreshold = std::max(newFailureThreshold, 1);
+    openSeconds = std::max(newOpenSeconds, 1);
+}
+
+long long ModelHealthTable::nowSeconds() const {
+    return std::chrono::duration_cast<std::chrono::seconds>(clock().time_since_epoch()).count();
+}
+
+bool ModelHealthTable::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        // model state failures lastExhausted openUntil
+        std::istringstream fields(line);
+        std::string model, state;
+        ModelHealthRecord entry;
+        if (fields >> model >> state >> entry.recentFailures >> entry.lastExhausted >> entry.openUntil) {
+            entry.state = parseBreakerState(state);
+            // A probe from a previous run never finished; let this run probe again
+            if (entry.state == BreakerState::HalfOpen) {
+                entry.state = BreakerState::Open;
+            }
+            records[model] = entry;
+        }
+    }
+    return true;
+}
+
+void ModelHealthTable::setStateFile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stateFile = path;
+}
+
+bool ModelHealthTable::save(const std::string& path) const {
+    std::map<std::string, ModelHealthRecord> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshot = records;
+    }
+
+    return writeRecords(path, snapshot);
+}
+
+void ModelHealthTable::changed() {
+    if (stateFile.empty()) {
+        return;
+    }
+    writeRecords(stateFile, records);
+}
+
+bool ModelHealthTable::allows(const std::string& model) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = records.find(model);
+    if (it == records.end()) {
+        return true;
+    }
+    ModelHealthRecord& entry = it->second;
+    switch (entry.state) {
+        case BreakerState::Closed:
+            return true;
+        case BreakerState::Open:
+            if (nowSeconds() < entry.openUntil) {
+                return false;
+            }
+            entry.state = BreakerState::HalfOpen;
+            entry.probeInFlight = true;
+            std::cout << "[GemStack] Circuit for " << model << " half-open; sending one probe request" << std::endl;
+            changed();
+            return true;
+        case BreakerState::HalfOpen:
+            if (entry.probeInFlight) {
+                return false;
+            }
+            entry.probeInFlight = true;
+            return true;
+    }
+    return true;
+}
+
+size_t ModelHealthTable::selectModel(const std::vector<std::string>& models, size_t fromIndex) {
+    if (models.empty()) {
+        return 0;
+    }
+    for (size_t i = std::min(fromIndex, models.size() - 1); i < models.size(); i++) {
+        if (allows(models[i])) {
+            return i;
+        }
+    }
+    return models.size() - 1;
+}
+
+void ModelHealthTable::recordSuccess(const std::string& model) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = records.find(model);
+    if (it == records.end()) {
+        return;
+    }
+    ModelHealthRecord& entry = it->second;
+    bool wasClosed = entry.state == BreakerState::Closed;
+    if (wasClosed && entry.recentFailures == 0) {
+        return;  // Nothing to forget
+    }
+    entry.state = BreakerState::Closed;
+    entry.recentFailures = 0;
+    entry.openUntil = 0;
+    entry.probeInFlight = false;
+    if (!wasClosed) {
+        std::cout << "[GemStack] Circuit for " << model << " closed; the model is healthy again" << std::endl;
+    }
+    changed();
+}
+
+void ModelHealthTable::recordExhausted(const std::string& model) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ModelHealthRecord& entry = records[model];
+    long long now = nowSeconds();
+
+    // Failures count as recent within one open period of each other
+    if (entry.lastExhausted > 0 && now - entry.lastExhausted > openSeconds) {
+        entry.recentFailures = 0;
+    }
+    entry.recentFailures++;
+    entry.lastExhausted = now;
+
+    bool failedProbe = entry.state == BreakerState::HalfOpen;
+    if (failedProbe || (entry.state == BreakerState::Closed && entry.recentFailures >= failureThreshold)) {
+        entry.state = BreakerState::Open;
+        entry.openUntil = now + openSeconds;
+        std::cout << "[GemStack] Circuit for " << model << " opened after " << entry.recentFailures
+                  << " rate limits; skipping it for " << openSeconds << " seconds" << std::endl;
+    }
+    entry.probeInFlight = false;
+    changed();
+}
+
+void ModelHealthTable::recordExhaustedUntil(const std::string& model, long long retryAt) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ModelHealthRecord& entry = records[model];
+    long long now = nowSeconds();
+    if (entry.lastExhausted > 0 && now - entry.lastExhausted > openSeconds) {
+        entry.recentFailures = 0;
+    }
+    entry.recentFailures++;
+    entry.lastExhausted = now;
+
+    // The server knows best: no threshold, and no probe before the time it gave
+    entry.state = BreakerState::Open;
+    entry.openUntil = std::max(retryAt, now);
+    entry.probeInFlight = false;
+    std::cout << "[GemStack] Circuit for " << model << " open until its quota resets in "
+              << (entry.openUntil - now) << " seconds" << std::endl;
+    changed();
+}
+
+void ModelHealthTable::recordOtherFailure(const std::string& model) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = records.find(model);
+    if (it != records.end()) {
+        it->second.probeInFlight = false;
+    }
+}
+
+ModelHealthRecord ModelHealthTable::record(const std::string& model) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = records.find(model);
+    return it == records.end() ? ModelHealthRecord() : it->second;
+}
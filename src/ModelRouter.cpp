@@ -0,0 +1,133 @@
+#include <ModelRouter.h>
+#include <GemStackCore.h>
+#include <algorithm>
+#include <cctype>
+
+// Weight of the newest run in the moving latency average
+static const double LATENCY_SMOOTHING = 0.3;
+
+// A later flash model must be this much cheaper per success to take light prompts over
+static const double SWITCH_MARGIN = 0.8;
+
+std::string modelTierName(ModelTier tier) {
+    return tier == ModelTier::Flash ? "flash" : "pro";
+}
+
+bool parseModelTier(const std::string& name, ModelTier& tier) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (lower == "pro") {
+        tier = ModelTier::Pro;
+        return true;
+    }
+    if (lower == "flash" || lower == "lite") {
+        tier = ModelTier::Flash;
+        return true;
+    }
+    return false;
+}
+
+ModelTier defaultModelTier(const std::string& model) {
+    if (model.find("flash") != std::string::npos || model.find("lite") != std::string::npos) {
+        return ModelTier::Flash;
+    }
+    return ModelTier::Pro;
+}
+
+PromptWeight classifyPromptWeight(const std::string& promptContent, size_t shortPromptChars) {
+    // Skip the goal / style / checkpoint preamble added by loadTasksFromFile
+    std::string task = promptContent;
+    for (const std::string& marker : {std::string("proceed with the following task:"), std::string("CURRENT TASK:")}) {
+        size_t pos = promptContent.find(marker);
+        if (pos != std::string::npos) {
+            task = promptContent.substr(pos + marker.size());
+            break;
+        }
+    }
+    return trim(task).size() < shortPromptChars ? PromptWeight::Light : PromptWeight::Heavy;
+}
+
+double ModelStats::successRate() const {
+    return (successes + 1.0) / (successes + failures + 2.0);
+}
+
+void ModelRouter::configure(std::vector<std::string> newModels, std::map<std::string, ModelTier> newTiers) {
+    std::lock_guard<std::mutex> lock(mutex);
+    models = std::move(newModels);
+    tiers = std::move(newTiers);
+}
+
+ModelTier ModelRouter::tierOf(const std::string& model) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tierOfLocked(model);
+}
+
+ModelTier ModelRouter::tierOfLocked(const std::string& model) const {
+    auto it = tiers.find(model);
+    return it == tiers.end() ? defaultModelTier(model) : it->second;
+}
+
+size_t ModelRouter::route(PromptWeight weight) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<size_t> flash;
+    size_t firstPro = models.size();
+    for (size_t i = 0; i < models.size(); i++) {
+        if (tierOfLocked(models[i]) == ModelTier::Flash) {
+            flash.push_back(i);
+        } else if (firstPro == models.size()) {
+            firstPro = i;
+        }
+    }
+    if (weight == PromptWeight::Heavy || flash.empty()) {
+        return firstPro < models.size() ? firstPro : 0;
+    }
+
+    auto proven = [this](size_t index) -> const ModelStats* {
+        auto it = history.find(models[index]);
+        if (it == history.end() || it->second.successes + it->second.failures < MIN_SAMPLES) {
+            return nullptr;
+        }
+        return &it->second;
+    };
+    auto cost = [](const ModelStats& stats) { return stats.meanLatencySeconds / stats.successRate(); };
+
+    // Prefer list order; move on only when history says so
+    size_t pick = flash[0];
+    for (size_t i = 1; i < flash.size(); i++) {
+        const ModelStats* current = proven(pick);
+        if (!current) {
+            break;
+        }
+        if (current->successRate() < 0.5) {
+            pick = flash[i];
+            continue;
+        }
+        const ModelStats* candidate = proven(flash[i]);
+        if (candidate && candidate->meanLatencySeconds > 0 && current->meanLatencySeconds > 0 &&
+            cost(*candidate) < cost(*current) * SWITCH_MARGIN) {
+            pick = flash[i];
+        }
+    }
+    return pick;
+}
+
+void ModelRouter::recordOutcome(const std::string& model, bool success, double latencySeconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ModelStats& stats = history[model];
+    if (!success) {
+        stats.failures++;
+        return;
+    }
+    stats.successes++;
+    if (stats.meanLatencySeconds <= 0) {
+        stats.meanLatencySeconds = latencySeconds;
+    } else {
+        stats.meanLatencySeconds += LATENCY_SMOOTHING * (latencySeconds - stats.meanLatencySeconds);
+    }
+}
+
+ModelStats ModelRouter::stats(const std::string& model) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = history.find(model);
+    return it == history.end() ? ModelStats() : it->second;
+}
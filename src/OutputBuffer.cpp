@@ -0,0 +1,187 @@
+#include <OutputBuffer.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+namespace fs = std::filesystem;
+
+// A name no other GemStack process (or buffer in this one) will pick. Letters only: the path
+// ends up in the retained text, which is scanned for error codes such as "429".
+static std::string makeSpillPath() {
+    static std::atomic<unsigned> counter{0};
+    std::random_device random;
+    std::mt19937_64 generator((static_cast<uint64_t>(random()) << 32) ^
+                              static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) ^
+                              counter++);
+    std::uniform_int_distribution<int> letter(0, 25);
+    std::string name = "gemstack-output-";
+    for (int i = 0; i < 16; i++) {
+        name += static_cast<char>('a' + letter(generator));
+    }
+    name += ".log";
+    std::error_code error;
+    fs::path directory = fs::temp_directory_path(error);
+    if (error) {
+        directory = ".";
+    }
+    return (directory / name).string();
+}
+
+OutputBuffer::OutputBuffer(size_t memoryLimit) : memoryLimit(memoryLimit) {}
+
+OutputBuffer::~OutputBuffer() {
+    removeSpillFile();
+}
+
+OutputBuffer::OutputBuffer(OutputBuffer&& other) noexcept
+    : memoryLimit(other.memoryLimit), headLimit(other.headLimit), tailLimit(other.tailLimit), totalBytes(other.totalBytes),
+      headBytes(std::move(other.headBytes)), ring(std::move(other.ring)), ringStart(other.ringStart),
+      spilling(other.spilling), path(std::move(other.path)), file(std::move(other.file)), keepFile(other.keepFile) {
+    other.path.clear();
+}
+
+OutputBuffer& OutputBuffer::operator=(OutputBuffer&& other) noexcept {
+    if (this != &other) {
+        removeSpillFile();
+        memoryLimit = other.memoryLimit;
+        headLimit = other.headLimit;
+        tailLimit = other.tailLimit;
+        totalBytes = other.totalBytes;
+        headBytes = std::move(other.headBytes);
+        ring = std::move(other.ring);
+        ringStart = other.ringStart;
+        spilling = other.spilling;
+        path = std::move(other.path);
+        file = std::move(other.file);
+        keepFile = other.keepFile;
+        other.path.clear();
+    }
+    return *this;
+}
+
+void OutputBuffer::removeSpillFile() {
+    if (file.is_open()) {
+        file.close();
+    }
+    if (!path.empty() && !keepFile) {
+        std::error_code error;
+        fs::remove(path, error);
+    }
+}
+
+void OutputBuffer::append(const char* data, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    if (!spilling && memoryLimit > 0 && totalBytes + length > memoryLimit) {
+        startSpilling();
+    }
+    totalBytes += length;
+
+    if (!spilling) {
+        headBytes.append(data, length);
+        return;
+    }
+    if (file.is_open()) {
+        file.write(data, static_cast<std::streamsize>(length));
+    }
+    // The chunk that crossed the limit may still have room to fill up the head
+    if (headBytes.size() < headLimit) {
+        size_t fill = std::min(headLimit - headBytes.size(), length);
+        headBytes.append(data, fill);
+        data += fill;
+        length -= fill;
+    }
+    appendTail(data, length);
+}
+
+void OutputBuffer::keepSpillFile() {
+    keepFile = true;
+    if (file.is_open()) {
+        file.flush();
+    }
+}
+
+// Move everything so far to the spill file and trim memory down to the head and tail
+void OutputBuffer::startSpilling() {
+    spilling = true;
+    headLimit = memoryLimit / 2;
+    tailLimit = std::max<size_t>(memoryLimit - headLimit, 1);
+
+    path = makeSpillPath();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (file.is_open()) {
+        file.write(headBytes.data(), static_cast<std::streamsize>(headBytes.size()));
+    } else {
+        path.clear();  // Keep going with just the head and tail
+    }
+
+    ring.reserve(tailLimit);
+    if (headBytes.size() > headLimit) {
+        appendTail(headBytes.data() + headLimit, headBytes.size() - headLimit);
+        headBytes.resize(headLimit);
+    }
+    headBytes.shrink_to_fit();
+}
+
+void OutputBuffer::appendTail(const char* data, size_t length) {
+    if (length >= tailLimit) {
+        ring.assign(data + length - tailLimit, tailLimit);
+        ringStart = 0;
+        return;
+    }
+
+    size_t fill = std::min(tailLimit - ring.size(), length);
+    ring.append(data, fill);
+    data += fill;
+    length -= fill;
+
+    // Full: overwrite the oldest bytes
+    while (length > 0) {
+        size_t chunk = std::min(length, tailLimit - ringStart);
+        std::memcpy(&ring[ringStart], data, chunk);
+        ringStart = (ringStart + chunk) % tailLimit;
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+std::string OutputBuffer::tail() const {
+    if (!spilling) {
+        return "";
+    }
+    std::string linear;
+    linear.reserve(ring.size());
+    linear.append(ring, ringStart, std::string::npos);
+    linear.append(ring, 0, ringStart);
+    return linear;
+}
+
+std::string OutputBuffer::str() const {
+    if (!spilling) {
+        return headBytes;
+    }
+    // No byte count here: digits in the text could look like an HTTP status to isModelExhausted
+    std::string note = "\n[GemStack] ... output omitted";
+    note += path.empty() ? " ...\n" : "; full output in " + path + " ...\n";
+
+    std::string text;
+    text.reserve(headBytes.size() + note.size() + ring.size());
+    text += headBytes;
+    text += note;
+    text += tail();
+    return text;
+}
+
+std::string OutputBuffer::take() {
+    if (spilling) {
+        return str();
+    }
+    std::string text = std::move(headBytes);
+    headBytes.clear();
+    return text;
+}
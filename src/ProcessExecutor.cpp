@@ -1,24 +1,126 @@
 #include <ProcessExecutor.h>
 #include <iostream>
-#include <array>
 #include <vector>
+#include <optional>
+#include <algorithm>
+#include <cstring>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #else
 #include <cstdio>
-#include <memory>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <csignal>
+#include <spawn.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char** environ;
 #endif
 
+// Bytes requested per read; large reads keep the syscall count low for verbose output
+static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+void LineDispatcher::deliver() {
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    if (!observer(line)) {
+        stopRequested = true;
+    }
+    line.clear();
+}
+
+bool LineDispatcher::dispatch(const char* data, size_t length) {
+    const char* end = data + length;
+    while (!stopRequested && data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', static_cast<size_t>(end - data)));
+        const char* lineEnd = newline ? newline : end;
+        size_t room = MAX_LINE_LENGTH - std::min(line.size(), MAX_LINE_LENGTH);
+        line.append(data, std::min(static_cast<size_t>(lineEnd - data), room));
+        if (!newline) {
+            break;
+        }
+        deliver();
+        data = newline + 1;
+    }
+    return !stopRequested;
+}
+
+bool LineDispatcher::finish() {
+    if (!stopRequested && !line.empty()) {
+        deliver();
+    }
+    return !stopRequested;
+}
+
+void ProcessExecutor::collectOutput(OutputBuffer& output, ProcessResult& result) {
+    result.outputSize = output.size();
+    if (output.spilled() && !output.spillPath().empty()) {
+        output.keepSpillFile();
+        result.spillPath = output.spillPath();
+    }
+    result.output = output.take();
+}
+
 #ifdef _WIN32
-// Windows implementation using CreateProcess with proper console handling
-std::pair<int, std::string> ProcessExecutor::execute(const std::string& command, const std::string& workingDir) {
-    std::string output;
+// Quote one argument following the MSVC command-line parsing rules
+static std::string quoteWindowsArgument(const std::string& arg) {
+    if (!arg.empty() && arg.find_first_of(" \t\n\v\"") == std::string::npos) {
+        return arg;
+    }
+
+    std::string quoted = "\"";
+    size_t backslashes = 0;
+    for (char c : arg) {
+        if (c == '\\') {
+            backslashes++;
+        } else if (c == '"') {
+            quoted.append(backslashes * 2 + 1, '\\');
+            quoted += '"';
+            backslashes = 0;
+        } else {
+            quoted.append(backslashes, '\\');
+            quoted += c;
+            backslashes = 0;
+        }
+    }
+    quoted.append(backslashes * 2, '\\');
+    quoted += '"';
+    return quoted;
+}
+
+// Launch a command line with CreateProcess and capture stdout/stderr
+static ProcessResult runProcess(const std::string& cmdLine, const ProcessOptions& options) {
+    const std::string& workingDir = options.workingDir;
+    const std::vector<std::string>& environment = options.environment;
+    const std::string& stdinFile = options.stdinFile;
+    const std::string* stdinData = options.stdinData ? &*options.stdinData : nullptr;
+    bool echoOutput = options.echoOutput;
+
+    ProcessResult result;
+    OutputBuffer output(options.outputMemoryLimit);
+    OutputBuffer errors(options.outputMemoryLimit);
+    auto fail = [&result](const std::string& message) {
+        result.exitCode = -1;
+        result.output = message;
+        return result;
+    };
 
     // Create pipes for capturing stdout/stderr
     HANDLE hStdOutRead = NULL;
     HANDLE hStdOutWrite = NULL;
+    HANDLE hStdErrRead = NULL;
     HANDLE hStdErrWrite = NULL;
 
     SECURITY_ATTRIBUTES saAttr;
@@ -28,23 +130,62 @@ std::pair<int, std::string> ProcessExecutor::execute(const std::string& command,
 
     // Create pipe for stdout
     if (!CreatePipe(&hStdOutRead, &hStdOutWrite, &saAttr, 0)) {
-        return {-1, "Failed to create stdout pipe"};
+        return fail("Failed to create stdout pipe");
     }
 
     // Ensure the read handle is not inherited
     if (!SetHandleInformation(hStdOutRead, HANDLE_FLAG_INHERIT, 0)) {
         CloseHandle(hStdOutRead);
         CloseHandle(hStdOutWrite);
-        return {-1, "Failed to set handle information"};
+        return fail("Failed to set handle information");
     }
 
-    // Duplicate stdout write handle for stderr
-    if (!DuplicateHandle(GetCurrentProcess(), hStdOutWrite,
-                         GetCurrentProcess(), &hStdErrWrite,
-                         0, TRUE, DUPLICATE_SAME_ACCESS)) {
+    if (options.mergeStderr) {
+        // Duplicate stdout write handle for stderr
+        if (!DuplicateHandle(GetCurrentProcess(), hStdOutWrite,
+                             GetCurrentProcess(), &hStdErrWrite,
+                             0, TRUE, DUPLICATE_SAME_ACCESS)) {
+            CloseHandle(hStdOutRead);
+            CloseHandle(hStdOutWrite);
+            return fail("Failed to duplicate handle for stderr");
+        }
+    } else if (!CreatePipe(&hStdErrRead, &hStdErrWrite, &saAttr, 0) ||
+               !SetHandleInformation(hStdErrRead, HANDLE_FLAG_INHERIT, 0)) {
+        // A pipe of its own for stderr
         CloseHandle(hStdOutRead);
         CloseHandle(hStdOutWrite);
-        return {-1, "Failed to duplicate handle for stderr"};
+        if (hStdErrRead) CloseHandle(hStdErrRead);
+        if (hStdErrWrite) CloseHandle(hStdErrWrite);
+        return fail("Failed to create stderr pipe");
+    }
+
+    // Optional stdin redirection from a pipe we feed, or from a file
+    HANDLE hStdIn = GetStdHandle(STD_INPUT_HANDLE);
+    HANDLE hStdInFile = NULL;
+    HANDLE hStdInWrite = NULL;
+    if (stdinData) {
+        if (!CreatePipe(&hStdInFile, &hStdInWrite, &saAttr, 0) ||
+            !SetHandleInformation(hStdInWrite, HANDLE_FLAG_INHERIT, 0)) {
+            CloseHandle(hStdOutRead);
+            CloseHandle(hStdOutWrite);
+            if (hStdErrRead) CloseHandle(hStdErrRead);
+            CloseHandle(hStdErrWrite);
+            if (hStdInFile) CloseHandle(hStdInFile);
+            if (hStdInWrite) CloseHandle(hStdInWrite);
+            return fail("Failed to create stdin pipe");
+        }
+        hStdIn = hStdInFile;
+    } else if (!stdinFile.empty()) {
+        hStdInFile = CreateFileA(stdinFile.c_str(), GENERIC_READ, FILE_SHARE_READ, &saAttr,
+                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hStdInFile == INVALID_HANDLE_VALUE) {
+            CloseHandle(hStdOutRead);
+            CloseHandle(hStdOutWrite);
+            if (hStdErrRead) CloseHandle(hStdErrRead);
+            CloseHandle(hStdErrWrite);
+            return fail("Failed to open stdin file: " + stdinFile);
+        }
+        hStdIn = hStdInFile;
     }
 
     // Set up the process startup info
@@ -52,13 +193,20 @@ std::pair<int, std::string> ProcessExecutor::execute(const std::string& command,
     PROCESS_INFORMATION pi;
     ZeroMemory(&si, sizeof(si));
     si.cb = sizeof(si);
+    si.hStdInput = hStdIn;
     si.hStdOutput = hStdOutWrite;
     si.hStdError = hStdErrWrite;
     si.dwFlags |= STARTF_USESTDHANDLES;
     ZeroMemory(&pi, sizeof(pi));
 
-    // Build command line - use cmd.exe /c to ensure proper shell environment
-    std::string cmdLine = "cmd.exe /c " + command;
+    // Environment block: "KEY=VALUE\0...\0\0" (NULL means inherit from parent)
+    std::string environmentBlock;
+    for (const auto& entry : environment) {
+        environmentBlock += entry;
+        environmentBlock += '\0';
+    }
+    environmentBlock += '\0';
+    LPVOID lpEnvironment = environment.empty() ? NULL : const_cast<char*>(environmentBlock.data());
 
     // Determine working directory (NULL means inherit from parent)
     const char* lpCurrentDirectory = workingDir.empty() ? NULL : workingDir.c_str();
@@ -70,8 +218,8 @@ std::pair<int, std::string> ProcessExecutor::execute(const std::string& command,
         NULL,                          // Process security attributes
         NULL,                          // Thread security attributes
         TRUE,                          // Inherit handles
-        0,                             // Creation flags - inherit parent console
-        NULL,                          // Environment (inherit from parent)
+        options.newProcessGroup ? CREATE_SUSPENDED : 0, // Suspended until it is in its job object
+        lpEnvironment,                 // Environment (NULL inherits from parent)
         lpCurrentDirectory,            // Current directory for the child process
         &si,                           // Startup info
         &pi                            // Process info
@@ -80,31 +228,166 @@ std::pair<int, std::string> ProcessExecutor::execute(const std::string& command,
     // Close write ends of pipes in parent - child has them now
     CloseHandle(hStdOutWrite);
     CloseHandle(hStdErrWrite);
+    if (hStdInFile) {
+        CloseHandle(hStdInFile);
+    }
 
     if (!success) {
         CloseHandle(hStdOutRead);
-        return {-1, "Failed to create process: " + std::to_string(GetLastError())};
+        if (hStdErrRead) CloseHandle(hStdErrRead);
+        if (hStdInWrite) CloseHandle(hStdInWrite);
+        return fail("Failed to create process: " + std::to_string(GetLastError()));
+    }
+
+    // A job object plays the role of a process group: terminating it takes the child's
+    // descendants down too, and they die with us if GemStack exits first
+    HANDLE hJob = NULL;
+    if (options.newProcessGroup) {
+        hJob = CreateJobObjectA(NULL, NULL);
+        if (hJob) {
+            JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits;
+            ZeroMemory(&limits, sizeof(limits));
+            limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+            SetInformationJobObject(hJob, JobObjectExtendedLimitInformation, &limits, sizeof(limits));
+            if (!AssignProcessToJobObject(hJob, pi.hProcess)) {
+                CloseHandle(hJob);
+                hJob = NULL;
+            }
+        }
+        ResumeThread(pi.hThread);
+    }
+
+    // Watchdog thread enforcing timeout / idleTimeout. Windows has no graceful equivalent
+    // of SIGTERM for console children, so an expired limit terminates the job outright.
+    using Clock = std::chrono::steady_clock;
+    std::atomic<long long> lastOutputTicks{Clock::now().time_since_epoch().count()};
+    std::atomic<bool> finished{false};
+    std::atomic<int> expired{0};  // 1 = wall-clock timeout, 2 = idle timeout
+    std::thread watchdog;
+    if (options.timeout.count() > 0 || options.idleTimeout.count() > 0) {
+        watchdog = std::thread([&, started = Clock::now()]() {
+            while (!finished) {
+                Clock::time_point now = Clock::now();
+                Clock::time_point lastOutput{Clock::duration(lastOutputTicks.load())};
+                if (options.timeout.count() > 0 && now - started >= options.timeout) {
+                    expired = 1;
+                } else if (options.idleTimeout.count() > 0 && now - lastOutput >= options.idleTimeout) {
+                    expired = 2;
+                }
+                if (expired) {
+                    if (hJob) {
+                        TerminateJobObject(hJob, 1);
+                    } else {
+                        TerminateProcess(pi.hProcess, 1);
+                    }
+                    return;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        });
+    }
+
+    // Feed stdin from a separate thread so a child that fills its output pipe before
+    // reading all of its input can't deadlock against us
+    std::thread stdinWriter;
+    if (hStdInWrite) {
+        stdinWriter = std::thread([hStdInWrite, stdinData]() {
+            size_t written = 0;
+            while (written < stdinData->size()) {
+                DWORD chunk = static_cast<DWORD>(std::min(stdinData->size() - written, READ_CHUNK_SIZE));
+                DWORD bytesWritten = 0;
+                if (!WriteFile(hStdInWrite, stdinData->data() + written, chunk, &bytesWritten, NULL)) {
+                    break;  // Child closed its stdin
+                }
+                written += bytesWritten;
+            }
+            CloseHandle(hStdInWrite);
+        });
+    }
+
+    std::optional<LineDispatcher> lines;
+    std::optional<LineDispatcher> errorLines;
+    if (options.lineObserver) {
+        lines.emplace(options.lineObserver);
+    }
+    if (hStdErrRead && options.errorLineObserver) {
+        errorLines.emplace(options.errorLineObserver);
+    }
+
+    // A separate stderr pipe is drained on its own thread (anonymous pipes can't be waited
+    // on together), so neither pipe can fill up and stall the child
+    std::thread stderrReader;
+    if (hStdErrRead) {
+        stderrReader = std::thread([&]() {
+            std::vector<char> errorBuffer(READ_CHUNK_SIZE);
+            DWORD errorBytes = 0;
+            while (ReadFile(hStdErrRead, errorBuffer.data(), static_cast<DWORD>(errorBuffer.size()), &errorBytes, NULL) &&
+                   errorBytes > 0) {
+                errors.append(errorBuffer.data(), errorBytes);
+                lastOutputTicks = Clock::now().time_since_epoch().count();
+                if (errorLines && !errorLines->stopped() && !errorLines->dispatch(errorBuffer.data(), errorBytes)) {
+                    if (hJob) {
+                        TerminateJobObject(hJob, 1);
+                    } else {
+                        TerminateProcess(pi.hProcess, 1);
+                    }
+                }
+                if (echoOutput) {
+                    std::cerr.write(errorBuffer.data(), errorBytes);
+                    std::cerr.flush();
+                }
+            }
+            if (errorLines && !errorLines->stopped()) {
+                errorLines->finish();
+            }
+        });
     }
 
-    // Read output from pipe in a loop
-    char buffer[256];
+    // Read output from pipe in large chunks and echo each chunk in one write
+    std::vector<char> buffer(READ_CHUNK_SIZE);
     DWORD bytesRead;
 
     while (true) {
-        BOOL readSuccess = ReadFile(hStdOutRead, buffer, sizeof(buffer) - 1, &bytesRead, NULL);
+        BOOL readSuccess = ReadFile(hStdOutRead, buffer.data(), static_cast<DWORD>(buffer.size()), &bytesRead, NULL);
         if (!readSuccess || bytesRead == 0) {
             break;
         }
-        buffer[bytesRead] = '\0';
-        std::string chunk(buffer, bytesRead);
-        output += chunk;
+        output.append(buffer.data(), bytesRead);
+        lastOutputTicks = Clock::now().time_since_epoch().count();
+        if (lines && !lines->stopped() && !lines->dispatch(buffer.data(), bytesRead)) {
+            if (hJob) {
+                TerminateJobObject(hJob, 1);
+            } else {
+                TerminateProcess(pi.hProcess, 1);
+            }
+        }
         // Print to console in real-time
-        std::cout << chunk;
-        std::cout.flush();
+        if (echoOutput) {
+            std::cout.write(buffer.data(), bytesRead);
+            std::cout.flush();
+        }
+    }
+
+    if (lines && !lines->stopped()) {
+        lines->finish();
+    }
+
+    if (stderrReader.joinable()) {
+        stderrReader.join();
+    }
+    if (stdinWriter.joinable()) {
+        stdinWriter.join();
     }
 
     // Wait for the process to complete
     WaitForSingleObject(pi.hProcess, INFINITE);
+    finished = true;
+    if (watchdog.joinable()) {
+        watchdog.join();
+    }
+    if (hJob) {
+        CloseHandle(hJob);
+    }
 
     // Get exit code
     DWORD exitCode;
@@ -114,15 +397,325 @@ std::pair<int, std::string> ProcessExecutor::execute(const std::string& command,
     CloseHandle(pi.hProcess);
     CloseHandle(pi.hThread);
     CloseHandle(hStdOutRead);
+    if (hStdErrRead) {
+        CloseHandle(hStdErrRead);
+    }
+
+    ProcessExecutor::collectOutput(output, result);
+    result.errorOutput = errors.take();
+    result.exitCode = static_cast<int>(exitCode);
+    result.timedOut = expired != 0;
+    result.idleTimedOut = expired == 2;
+    result.stoppedByObserver = (lines && lines->stopped()) || (errorLines && errorLines->stopped());
+    return result;
+}
 
-    return {static_cast<int>(exitCode), output};
+std::pair<int, std::string> ProcessExecutor::execute(const std::string& command, const std::string& workingDir) {
+    // Use cmd.exe /c to ensure proper shell environment
+    ProcessOptions options;
+    options.workingDir = workingDir;
+    ProcessResult result = runProcess("cmd.exe /c " + command, options);
+    return {result.exitCode, result.output};
+}
+
+ProcessResult ProcessExecutor::execute(const std::vector<std::string>& argv, const ProcessOptions& options) {
+    ProcessResult result;
+    if (argv.empty()) {
+        result.output = "No command given";
+        return result;
+    }
+
+    std::string cmdLine;
+    for (const auto& arg : argv) {
+        if (!cmdLine.empty()) cmdLine += ' ';
+        cmdLine += quoteWindowsArgument(arg);
+    }
+
+    return runProcess(cmdLine, options);
 }
 
 #else
+// Echo to the console once this much output is pending, or whenever the pipe runs dry
+static constexpr size_t ECHO_BATCH_SIZE = 16 * 1024;
+
+// Make a close-on-exec pipe so children spawned concurrently by other workers don't inherit it
+static bool makePipe(int fds[2]) {
+#ifdef __linux__
+    return pipe2(fds, O_CLOEXEC) == 0;
+#else
+    return pipe(fds) == 0 && fcntl(fds[0], F_SETFD, FD_CLOEXEC) == 0 &&
+           fcntl(fds[1], F_SETFD, FD_CLOEXEC) == 0;
+#endif
+}
+
+static void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+// A child that exits without reading its stdin must not kill us with SIGPIPE
+static void ignoreSigpipe() {
+    static std::once_flag once;
+    std::call_once(once, []() { signal(SIGPIPE, SIG_IGN); });
+}
+
+// One output pipe of a child being drained: where its bytes go and who sees its lines
+struct CapturedStream {
+    int fd;
+    OutputBuffer* buffer;
+    std::ostream* echo;      // nullptr: don't echo
+    LineDispatcher* lines;   // nullptr: no line observer
+    std::string pendingEcho;
+    bool open = true;
+
+    CapturedStream(int fd, OutputBuffer* buffer, std::ostream* echo, LineDispatcher* lines = nullptr)
+        : fd(fd), buffer(buffer), echo(echo), lines(lines) {}
+
+    void flushEcho() {
+        if (!pendingEcho.empty()) {
+            echo->write(pendingEcho.data(), static_cast<std::streamsize>(pendingEcho.size()));
+            echo->flush();
+            pendingEcho.clear();
+        }
+    }
+};
+
+// Drain every stream until EOF while writing input to inFd (if >= 0). All descriptors
+// are non-blocking and serviced from one poll() loop, so a child that fills one of its
+// output pipes before consuming all of its input can't deadlock us. Reads use large read()
+// calls, and output goes to an OutputBuffer so memory stays bounded when a limit is set.
+// Console echo is batched rather than written per chunk. inFd is closed once input is fully
+// written. With a watchdog, its deadlines bound each wait and may signal the child. With a
+// line dispatcher, complete lines go to the observer as they arrive; if it asks to stop, the
+// child (process) is killed and the remaining output is drained without dispatching.
+static void pumpProcessIO(CapturedStream* streams, size_t streamCount, int inFd, const std::string& input,
+                          ProcessWatchdog* watchdog = nullptr, const SpawnedProcess* process = nullptr) {
+    for (size_t i = 0; i < streamCount; i++) {
+        setNonBlocking(streams[i].fd);
+    }
+    if (inFd >= 0) {
+        setNonBlocking(inFd);
+    }
+
+    std::vector<char> buffer(READ_CHUNK_SIZE);
+    size_t written = 0;
+    auto closeInput = [&]() {
+        if (inFd >= 0) {
+            close(inFd);
+            inFd = -1;
+        }
+    };
+    // Read what one stream has ready; false if it had nothing
+    auto readStream = [&](CapturedStream& stream) {
+        ssize_t bytesRead = read(stream.fd, buffer.data(), buffer.size());
+        if (bytesRead > 0) {
+            size_t length = static_cast<size_t>(bytesRead);
+            stream.buffer->append(buffer.data(), length);
+            if (stream.echo && stream.pendingEcho.empty() && length >= ECHO_BATCH_SIZE) {
+                stream.echo->write(buffer.data(), static_cast<std::streamsize>(length));
+                stream.echo->flush();
+            } else if (stream.echo) {
+                stream.pendingEcho.append(buffer.data(), length);
+                if (stream.pendingEcho.size() >= ECHO_BATCH_SIZE) {
+                    stream.flushEcho();
+                }
+            }
+            if (watchdog) {
+                watchdog->outputReceived();
+            }
+            if (stream.lines && !stream.lines->stopped() && !stream.lines->dispatch(buffer.data(), length) &&
+                process) {
+                ProcessExecutor::signalProcess(*process, SIGKILL);
+            }
+            return true;
+        }
+        if (bytesRead < 0 && errno == EINTR) {
+            return true;
+        }
+        if (bytesRead == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            if (stream.lines && !stream.lines->stopped()) {
+                stream.lines->finish();
+            }
+            stream.open = false;
+        }
+        return false;
+    };
+
+    if (inFd >= 0 && input.empty()) {
+        closeInput();
+    }
+
+    while (true) {
+        bool progressed = false;
+        size_t openCount = 0;
+        for (size_t i = 0; i < streamCount; i++) {
+            if (streams[i].open) {
+                progressed = readStream(streams[i]) || progressed;
+                openCount += streams[i].open ? 1 : 0;
+            }
+        }
+        if (openCount == 0) {
+            break;
+        }
+
+        if (inFd >= 0) {
+            size_t toWrite = std::min(input.size() - written, READ_CHUNK_SIZE);
+            ssize_t bytesWritten = write(inFd, input.data() + written, toWrite);
+            if (bytesWritten > 0) {
+                written += static_cast<size_t>(bytesWritten);
+                if (written == input.size()) {
+                    closeInput();
+                }
+                progressed = true;
+            } else if (bytesWritten < 0 && errno == EINTR) {
+                progressed = true;
+            } else if (bytesWritten < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                // EPIPE: the child stopped reading; keep collecting its output
+                closeInput();
+            }
+        }
+
+        int waitMs = watchdog ? watchdog->check() : -1;
+        if (watchdog && watchdog->shouldAbandonOutput()) {
+            break;
+        }
+        if (progressed) {
+            continue;
+        }
+
+        // Nothing to do right now: show what we have, then sleep until any pipe is ready
+        std::vector<pollfd> fds;
+        for (size_t i = 0; i < streamCount; i++) {
+            streams[i].flushEcho();
+            if (streams[i].open) {
+                fds.push_back({streams[i].fd, POLLIN, 0});
+            }
+        }
+        if (inFd >= 0) {
+            fds.push_back({inFd, POLLOUT, 0});
+        }
+        while (poll(fds.data(), fds.size(), waitMs) < 0 && errno == EINTR) {
+        }
+    }
+
+    closeInput();
+    for (size_t i = 0; i < streamCount; i++) {
+        streams[i].flushEcho();
+    }
+}
+
+// Process groups that may still have live members, for signalAllProcessGroups().
+// Fixed-size and lock-free so it can be read from a signal handler.
+static constexpr size_t MAX_TRACKED_GROUPS = 256;
+static std::atomic<pid_t> g_processGroups[MAX_TRACKED_GROUPS];
+
+static void trackProcessGroup(pid_t pgid) {
+    for (auto& slot : g_processGroups) {
+        pid_t expected = 0;
+        if (slot.compare_exchange_strong(expected, pgid)) {
+            return;
+        }
+    }
+}
+
+static void untrackProcessGroup(pid_t pgid) {
+    for (auto& slot : g_processGroups) {
+        pid_t expected = pgid;
+        if (slot.compare_exchange_strong(expected, 0)) {
+            return;
+        }
+    }
+}
+
+void ProcessExecutor::signalProcess(const SpawnedProcess& process, int signal) {
+    if (process.pid <= 0) {
+        return;
+    }
+    if (process.processGroup) {
+        kill(-process.pid, signal);
+    }
+    // Also the child itself, in case it moved to a session of its own
+    kill(process.pid, signal);
+}
+
+void ProcessExecutor::signalAllProcessGroups(int signal) {
+    for (auto& slot : g_processGroups) {
+        pid_t pgid = slot.load();
+        if (pgid > 0) {
+            kill(-pgid, signal);
+        }
+    }
+}
+
+void ProcessExecutor::releaseProcess(const SpawnedProcess& process) {
+    if (process.processGroup) {
+        untrackProcessGroup(process.pid);
+    }
+}
+
+ProcessWatchdog::ProcessWatchdog(const ProcessOptions& options, const SpawnedProcess& process)
+    : process(process), timeout(options.timeout), idleTimeout(options.idleTimeout),
+      gracePeriod(options.killGracePeriod), started(Clock::now()), lastOutput(started), stageStarted(started) {}
+
+void ProcessWatchdog::outputReceived() {
+    lastOutput = Clock::now();
+}
+
+int ProcessWatchdog::check() {
+    Clock::time_point now = Clock::now();
+    auto millisecondsUntil = [&](Clock::time_point deadline) {
+        auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+        return static_cast<int>(std::clamp<long long>(remaining, 1, 24LL * 60 * 60 * 1000));
+    };
+
+    switch (stage) {
+        case Stage::Running: {
+            std::optional<Clock::time_point> deadline;
+            bool idleDeadline = false;
+            if (timeout.count() > 0) {
+                deadline = started + timeout;
+            }
+            if (idleTimeout.count() > 0 && (!deadline || lastOutput + idleTimeout < *deadline)) {
+                deadline = lastOutput + idleTimeout;
+                idleDeadline = true;
+            }
+            if (!deadline) {
+                return -1;
+            }
+            if (now < *deadline) {
+                return millisecondsUntil(*deadline);
+            }
+            idleExpired = idleDeadline;
+            ProcessExecutor::signalProcess(process, SIGTERM);
+            stage = Stage::Terminating;
+            stageStarted = now;
+            return millisecondsUntil(now + gracePeriod);
+        }
+        case Stage::Terminating:
+            if (now < stageStarted + gracePeriod) {
+                return millisecondsUntil(stageStarted + gracePeriod);
+            }
+            ProcessExecutor::signalProcess(process, SIGKILL);
+            stage = Stage::Killed;
+            stageStarted = now;
+            return millisecondsUntil(now + gracePeriod);
+        case Stage::Killed:
+            if (now < stageStarted + gracePeriod) {
+                return millisecondsUntil(stageStarted + gracePeriod);
+            }
+            stage = Stage::Abandoned;
+            return -1;
+        case Stage::Abandoned:
+            return -1;
+    }
+    return -1;
+}
+
 // Unix implementation using popen
 std::pair<int, std::string> ProcessExecutor::execute(const std::string& command, const std::string& workingDir) {
-    std::string output;
-    std::array<char, 256> buffer;
+    OutputBuffer output;
 
     // Build command with optional directory change
     std::string fullCommand;
@@ -137,14 +730,178 @@ std::pair<int, std::string> ProcessExecutor::execute(const std::string& command,
         return {-1, "Failed to execute command"};
     }
 
-    while (fgets(buffer.data(), buffer.size(), pipe) != nullptr) {
-        std::string chunk = buffer.data();
-        output += chunk;
-        // Also print to console in real-time
-        std::cout << chunk;
-    }
+    // Nothing has been read through stdio yet, so the descriptor can be drained directly
+    CapturedStream stream(fileno(pipe), &output, &std::cout);
+    pumpProcessIO(&stream, 1, -1, "");
 
     int result = pclose(pipe);
-    return {result, output};
+    return {result, output.take()};
+}
+
+int ProcessExecutor::exitCodeFromWaitStatus(int status) {
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    return -1;
+}
+
+// Start argv[0] with posix_spawnp and explicit pipes (no /bin/sh in between)
+bool ProcessExecutor::spawn(const std::vector<std::string>& argv, const ProcessOptions& options,
+                            SpawnedProcess& process, ProcessResult& failure) {
+    if (argv.empty()) {
+        failure.output = "No command given";
+        return false;
+    }
+
+    bool pipeInput = options.stdinData.has_value();
+    bool pipeErrors = !options.mergeStderr;
+    int outPipe[2];
+    int errPipe[2] = {-1, -1};
+    int inPipe[2] = {-1, -1};
+    if (!makePipe(outPipe)) {
+        failure.output = "Failed to create output pipe";
+        return false;
+    }
+    if (pipeErrors && !makePipe(errPipe)) {
+        close(outPipe[0]);
+        close(outPipe[1]);
+        failure.output = "Failed to create error pipe";
+        return false;
+    }
+    if (pipeInput) {
+        if (!makePipe(inPipe)) {
+            close(outPipe[0]);
+            close(outPipe[1]);
+            if (pipeErrors) {
+                close(errPipe[0]);
+                close(errPipe[1]);
+            }
+            failure.output = "Failed to create input pipe";
+            return false;
+        }
+        ignoreSigpipe();
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (pipeInput) {
+        posix_spawn_file_actions_adddup2(&actions, inPipe[0], STDIN_FILENO);
+    } else if (!options.stdinFile.empty()) {
+        // Open stdin before changing directory so a relative path resolves against our cwd
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, options.stdinFile.c_str(), O_RDONLY, 0);
+    }
+    posix_spawn_file_actions_adddup2(&actions, outPipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, pipeErrors ? errPipe[1] : outPipe[1], STDERR_FILENO);
+    if (!options.workingDir.empty()) {
+        posix_spawn_file_actions_addchdir_np(&actions, options.workingDir.c_str());
+    }
+
+    // We ignore SIGPIPE; give the child the default disposition back
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t defaultSignals;
+    sigemptyset(&defaultSignals);
+    sigaddset(&defaultSignals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attributes, &defaultSignals);
+    short spawnFlags = POSIX_SPAWN_SETSIGDEF;
+    if (options.newProcessGroup) {
+        // pgid == pid, so the child and everything it starts can be signalled together
+        posix_spawnattr_setpgroup(&attributes, 0);
+        spawnFlags |= POSIX_SPAWN_SETPGROUP;
+    }
+    posix_spawnattr_setflags(&attributes, spawnFlags);
+
+    std::vector<char*> argvPtrs;
+    for (const auto& arg : argv) {
+        argvPtrs.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argvPtrs.push_back(nullptr);
+
+    std::vector<char*> envPtrs;
+    for (const auto& entry : options.environment) {
+        envPtrs.push_back(const_cast<char*>(entry.c_str()));
+    }
+    envPtrs.push_back(nullptr);
+    char** envp = options.environment.empty() ? environ : envPtrs.data();
+
+    pid_t pid = 0;
+    int spawnError = posix_spawnp(&pid, argv[0].c_str(), &actions, &attributes, argvPtrs.data(), envp);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+    close(outPipe[1]);
+    if (pipeErrors) {
+        close(errPipe[1]);
+    }
+    if (pipeInput) {
+        close(inPipe[0]);
+    }
+
+    if (spawnError != 0) {
+        close(outPipe[0]);
+        if (pipeErrors) {
+            close(errPipe[0]);
+        }
+        if (pipeInput) {
+            close(inPipe[1]);
+        }
+        failure.exitCode = 127;
+        failure.output = "Failed to launch " + argv[0] + ": " + std::strerror(spawnError);
+        return false;
+    }
+
+    process.pid = pid;
+    process.outputFd = outPipe[0];
+    process.errorFd = errPipe[0];
+    process.inputFd = inPipe[1];
+    process.processGroup = options.newProcessGroup;
+    if (process.processGroup) {
+        trackProcessGroup(pid);
+    }
+    return true;
+}
+
+ProcessResult ProcessExecutor::execute(const std::vector<std::string>& argv, const ProcessOptions& options) {
+    ProcessResult result;
+    SpawnedProcess process;
+    if (!spawn(argv, options, process, result)) {
+        return result;
+    }
+
+    static const std::string noInput;
+    ProcessWatchdog watchdog(options, process);
+    std::optional<LineDispatcher> lines;
+    std::optional<LineDispatcher> errorLines;
+    if (options.lineObserver) {
+        lines.emplace(options.lineObserver);
+    }
+    if (process.errorFd >= 0 && options.errorLineObserver) {
+        errorLines.emplace(options.errorLineObserver);
+    }
+    OutputBuffer output(options.outputMemoryLimit);
+    OutputBuffer errors(options.outputMemoryLimit);
+    CapturedStream streams[2] = {
+        {process.outputFd, &output, options.echoOutput ? &std::cout : nullptr, lines ? &*lines : nullptr},
+        {process.errorFd, &errors, options.echoOutput ? &std::cerr : nullptr, errorLines ? &*errorLines : nullptr}};
+    pumpProcessIO(streams, process.errorFd >= 0 ? 2 : 1, process.inputFd,
+                  options.stdinData ? *options.stdinData : noInput, &watchdog, &process);
+    close(process.outputFd);
+    if (process.errorFd >= 0) {
+        close(process.errorFd);
+    }
+    collectOutput(output, result);
+    result.errorOutput = errors.take();
+
+    int status = 0;
+    while (waitpid(process.pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    releaseProcess(process);
+    result.exitCode = exitCodeFromWaitStatus(status);
+    result.timedOut = watchdog.timedOut();
+    result.idleTimedOut = watchdog.idleTimedOut();
+    result.stoppedByObserver = (lines && lines->stopped()) || (errorLines && errorLines->stopped());
+    return result;
 }
 #endif
@@ -0,0 +1,662 @@
+#include <ProcessReactor.h>
+#include <iostream>
+#include <algorithm>
+#include <optional>
+
+#ifdef __linux__
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#endif
+
+// Bytes requested per read and console echo batch; match ProcessExecutor's capture loop
+static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+static constexpr size_t ECHO_BATCH_SIZE = 16 * 1024;
+
+ProcessResult ProcessHandle::wait() const {
+    return result.get();
+}
+
+bool ProcessHandle::finished() const {
+    return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+bool ProcessHandle::cancel() const {
+    return reactor != nullptr && reactor->cancel(processId);
+}
+
+bool ProcessHandle::release(const std::string& input) const {
+    return reactor != nullptr && reactor->release(processId, input);
+}
+
+#ifdef __linux__
+// epoll user data: job id in the high bits, which descriptor in the low three
+enum EventTag : uint64_t {
+    TagOutput = 0,
+    TagInput = 1,
+    TagExit = 2,
+    TagWake = 3,
+    TagError = 4
+};
+
+static uint64_t eventKey(uint64_t id, EventTag tag) {
+    return (id << 3) | tag;
+}
+
+static void setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+// pidfd_open(2) through syscall() so older glibc builds still compile; -1 if unsupported
+static int openPidFd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+struct ProcessReactor::Job {
+    uint64_t id = 0;
+    SpawnedProcess process;
+    int pidFd = -1;             // Readable once the child exits (-1: poll with waitpid instead)
+    std::string input;
+    size_t written = 0;
+    bool echoOutput = true;
+    bool exited = false;
+    bool held = false;          // Waiting for release(): stdin open but not watched
+    bool failedToStart = false; // Spawn failed; result is final and only needs reporting
+    ProcessOptions limits;      // Timeouts to arm on release
+    std::optional<ProcessWatchdog> watchdog;  // Only when a timeout is configured
+    std::optional<LineDispatcher> lines;      // Only with a line observer
+    std::optional<LineDispatcher> errorLines; // Only with an error line observer and separate stderr
+    OutputBuffer output;
+    OutputBuffer errors;                      // stderr, when not merged into output
+    std::string pendingEcho;                  // Echo not yet written to the console, per stream
+    std::string pendingErrorEcho;
+    ProcessResult result;
+    std::promise<ProcessResult> promise;
+    CompletionCallback onComplete;
+};
+
+ProcessReactor::ProcessReactor() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd >= 0 && wakeFd >= 0) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = eventKey(0, TagWake);
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+        loopThread = std::thread(&ProcessReactor::run, this);
+    } else {
+        std::cerr << "[GemStack] Warning: could not create process reactor (epoll unavailable)" << std::endl;
+    }
+}
+
+ProcessReactor::~ProcessReactor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        for (auto& [id, job] : jobs) {
+            if (!job->exited && !job->failedToStart) {
+                ProcessExecutor::signalProcess(job->process, SIGKILL);
+                job->result.cancelled = true;
+            }
+        }
+    }
+    wake();
+    if (loopThread.joinable()) {
+        loopThread.join();
+    }
+    if (wakeFd >= 0) close(wakeFd);
+    if (epollFd >= 0) close(epollFd);
+}
+
+ProcessHandle ProcessReactor::start(const std::vector<std::string>& argv, const ProcessOptions& options,
+                                    CompletionCallback onComplete) {
+    auto job = std::make_unique<Job>();
+    ProcessHandle handle;
+    handle.reactor = this;
+    handle.result = job->promise.get_future().share();
+
+    // A held child still needs a stdin pipe to be released into later
+    ProcessOptions spawnOptions = options;
+    if (options.holdInput && !spawnOptions.stdinData) {
+        spawnOptions.stdinData = std::string();
+    }
+
+    // No loop thread to report from: the only case where onComplete runs on the caller
+    if (!loopThread.joinable()) {
+        ProcessResult failure;
+        failure.output = "Process reactor is not running";
+        if (onComplete) {
+            onComplete(failure);
+        }
+        job->promise.set_value(failure);
+        return handle;
+    }
+
+    // A failed launch is still reported from the reactor thread, like any other completion
+    if (!ProcessExecutor::spawn(argv, spawnOptions, job->process, job->result)) {
+        job->failedToStart = true;
+        job->onComplete = std::move(onComplete);
+        std::unique_lock<std::mutex> lock(mutex);
+        job->id = nextId++;
+        handle.processId = job->id;
+        jobs[job->id] = std::move(job);
+        lock.unlock();
+        wake();
+        return handle;
+    }
+
+    job->pidFd = openPidFd(job->process.pid);
+    job->held = options.holdInput;
+    if (job->held) {
+        job->limits.timeout = options.timeout;
+        job->limits.idleTimeout = options.idleTimeout;
+        job->limits.killGracePeriod = options.killGracePeriod;
+    } else if (options.timeout.count() > 0 || options.idleTimeout.count() > 0) {
+        job->watchdog.emplace(options, job->process);
+    }
+    if (options.lineObserver) {
+        job->lines.emplace(options.lineObserver);
+    }
+    if (job->process.errorFd >= 0 && options.errorLineObserver) {
+        job->errorLines.emplace(options.errorLineObserver);
+    }
+    job->echoOutput = options.echoOutput;
+    job->output = OutputBuffer(options.outputMemoryLimit);
+    job->errors = OutputBuffer(options.outputMemoryLimit);
+    job->onComplete = std::move(onComplete);
+    if (options.stdinData) {
+        job->input = *options.stdinData;
+    }
+
+    setNonBlocking(job->process.outputFd);
+    if (job->process.errorFd >= 0) {
+        setNonBlocking(job->process.errorFd);
+    }
+    if (job->process.inputFd >= 0 && job->input.empty() && !job->held) {
+        close(job->process.inputFd);
+        job->process.inputFd = -1;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    job->id = nextId++;
+    handle.processId = job->id;
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = eventKey(job->id, TagOutput);
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, job->process.outputFd, &event);
+    if (job->process.errorFd >= 0) {
+        event.data.u64 = eventKey(job->id, TagError);
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, job->process.errorFd, &event);
+    }
+    if (job->process.inputFd >= 0 && !job->held) {
+        setNonBlocking(job->process.inputFd);
+        event.events = EPOLLOUT;
+        event.data.u64 = eventKey(job->id, TagInput);
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, job->process.inputFd, &event);
+    }
+    if (job->pidFd >= 0) {
+        event.events = EPOLLIN;
+        event.data.u64 = eventKey(job->id, TagExit);
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, job->pidFd, &event);
+    }
+
+    bool hasDeadline = job->watchdog.has_value();
+    jobs[job->id] = std::move(job);
+    lock.unlock();
+
+    // The loop may be sleeping with no deadline; make it pick up this one
+    if (hasDeadline) {
+        wake();
+    }
+    return handle;
+}
+
+bool ProcessReactor::cancel(uint64_t processId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(processId);
+    if (it == jobs.end() || it->second->exited || it->second->failedToStart) {
+        return false;
+    }
+    // Not reaped yet (we hold the lock), so the pid can't have been reused
+    ProcessExecutor::signalProcess(it->second->process, SIGKILL);
+    it->second->result.cancelled = true;
+    return true;
+}
+
+bool ProcessReactor::release(uint64_t processId, const std::string& input) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = jobs.find(processId);
+    if (it == jobs.end() || !it->second->held || it->second->exited || it->second->failedToStart ||
+        it->second->result.cancelled) {
+        return false;
+    }
+    Job& job = *it->second;
+    job.held = false;
+    job.input = input;
+    if (job.limits.timeout.count() > 0 || job.limits.idleTimeout.count() > 0) {
+        job.watchdog.emplace(job.limits, job.process);
+    }
+
+    if (job.input.empty()) {
+        close(job.process.inputFd);
+        job.process.inputFd = -1;
+    } else {
+        setNonBlocking(job.process.inputFd);
+        epoll_event event{};
+        event.events = EPOLLOUT;
+        event.data.u64 = eventKey(job.id, TagInput);
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, job.process.inputFd, &event);
+    }
+    lock.unlock();
+
+    // Pick up the new deadline
+    wake();
+    return true;
+}
+
+size_t ProcessReactor::activeCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size();
+}
+
+void ProcessReactor::wake() {
+    if (wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+static void flushEcho(std::ostream& echo, std::string& pending) {
+    if (!pending.empty()) {
+        echo.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+        echo.flush();
+        pending.clear();
+    }
+}
+
+void ProcessReactor::handleOutput(Job& job, bool errorStream) {
+    char buffer[READ_CHUNK_SIZE];
+    int& fd = errorStream ? job.process.errorFd : job.process.outputFd;
+    OutputBuffer& output = errorStream ? job.errors : job.output;
+    std::optional<LineDispatcher>& lines = errorStream ? job.errorLines : job.lines;
+    std::ostream& echo = errorStream ? std::cerr : std::cout;
+    std::string& pendingEcho = errorStream ? job.pendingErrorEcho : job.pendingEcho;
+
+    // The console sees output once per batch or once the pipe runs dry, not once per read
+    struct EchoFlush {
+        std::ostream& echo;
+        std::string& pending;
+        ~EchoFlush() { flushEcho(echo, pending); }
+    } flushOnReturn{echo, pendingEcho};
+
+    while (fd >= 0) {
+        ssize_t bytesRead = read(fd, buffer, sizeof(buffer));
+        if (bytesRead > 0) {
+            output.append(buffer, static_cast<size_t>(bytesRead));
+            if (job.watchdog) {
+                job.watchdog->outputReceived();
+            }
+            if (lines && !lines->stopped() && !lines->dispatch(buffer, static_cast<size_t>(bytesRead)) &&
+                !job.exited) {
+                ProcessExecutor::signalProcess(job.process, SIGKILL);
+            }
+            if (job.echoOutput) {
+                pendingEcho.append(buffer, static_cast<size_t>(bytesRead));
+                if (pendingEcho.size() >= ECHO_BATCH_SIZE) {
+                    flushEcho(echo, pendingEcho);
+                }
+            }
+            continue;
+        }
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        // EOF (or a read error): every writer has closed the pipe
+        if (lines && !lines->stopped()) {
+            lines->finish();
+        }
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        fd = -1;
+    }
+}
+
+void ProcessReactor::handleInput(Job& job) {
+    while (job.process.inputFd >= 0) {
+        size_t toWrite = std::min(job.input.size() - job.written, READ_CHUNK_SIZE);
+        ssize_t bytesWritten = write(job.process.inputFd, job.input.data() + job.written, toWrite);
+        if (bytesWritten > 0) {
+            job.written += static_cast<size_t>(bytesWritten);
+            if (job.written < job.input.size()) {
+                continue;
+            }
+        } else if (bytesWritten < 0 && errno == EINTR) {
+            continue;
+        } else if (bytesWritten < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        // All input written, or EPIPE because the child stopped reading
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, job.process.inputFd, nullptr);
+        close(job.process.inputFd);
+        job.process.inputFd = -1;
+        std::string().swap(job.input);
+    }
+}
+
+bool ProcessReactor::reap(Job& job) {
+    if (job.exited) {
+        return true;
+    }
+    int status = 0;
+    pid_t reaped = waitpid(job.process.pid, &status, WNOHANG);
+    if (reaped == job.process.pid || (reaped < 0 && errno == ECHILD)) {
+        job.exited = true;
+        job.result.exitCode = reaped == job.process.pid ? ProcessExecutor::exitCodeFromWaitStatus(status) : -1;
+        if (job.pidFd >= 0) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, job.pidFd, nullptr);
+            close(job.pidFd);
+            job.pidFd = -1;
+        }
+    }
+    return job.exited;
+}
+
+void ProcessReactor::finishJob(std::unique_ptr<Job> job, std::vector<std::unique_ptr<Job>>& completed) {
+    if (job->watchdog) {
+        job->result.timedOut = job->watchdog->timedOut();
+        job->result.idleTimedOut = job->watchdog->idleTimedOut();
+    }
+    job->result.stoppedByObserver = (job->lines && job->lines->stopped()) ||
+                                    (job->errorLines && job->errorLines->stopped());
+    flushEcho(std::cout, job->pendingEcho);
+    flushEcho(std::cerr, job->pendingErrorEcho);
+    ProcessExecutor::collectOutput(job->output, job->result);
+    job->result.errorOutput = job->errors.take();
+    ProcessExecutor::releaseProcess(job->process);
+    if (job->process.inputFd >= 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, job->process.inputFd, nullptr);
+        close(job->process.inputFd);
+        job->process.inputFd = -1;
+    }
+    for (int* fd : {&job->process.outputFd, &job->process.errorFd}) {
+        if (*fd >= 0) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, *fd, nullptr);
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    completed.push_back(std::move(job));
+}
+
+void ProcessReactor::run() {
+    epoll_event events[64];
+    int waitMs = -1;  // Until the nearest watchdog deadline or exit poll
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping && jobs.empty()) {
+                break;
+            }
+        }
+
+        int count = epoll_wait(epollFd, events, 64, waitMs);
+        if (count < 0 && errno != EINTR) {
+            break;
+        }
+
+        std::vector<std::unique_ptr<Job>> completed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int i = 0; i < count; i++) {
+                uint64_t key = events[i].data.u64;
+                EventTag tag = static_cast<EventTag>(key & 7);
+                if (tag == TagWake) {
+                    uint64_t value = 0;
+                    ssize_t ignored = read(wakeFd, &value, sizeof(value));
+                    (void)ignored;
+                    continue;
+                }
+
+                auto it = jobs.find(key >> 3);
+                if (it == jobs.end()) {
+                    continue;
+                }
+                switch (tag) {
+                    case TagOutput: handleOutput(*it->second, false); break;
+                    case TagError:  handleOutput(*it->second, true); break;
+                    case TagInput:  handleInput(*it->second); break;
+                    case TagExit:   reap(*it->second); break;
+                    default: break;
+                }
+            }
+
+            waitMs = -1;
+            auto waitAtMost = [&waitMs](int milliseconds) {
+                if (milliseconds >= 0 && (waitMs < 0 || milliseconds < waitMs)) {
+                    waitMs = milliseconds;
+                }
+            };
+
+            // A job completes once its output is drained and the child is reaped. When
+            // shutting down, a grandchild holding the pipe open must not keep us waiting.
+            for (auto it = jobs.begin(); it != jobs.end();) {
+                Job& job = *it->second;
+                if (job.failedToStart) {
+                    completed.push_back(std::move(it->second));
+                    it = jobs.erase(it);
+                    continue;
+                }
+
+                // Once a lone child is reaped its pid may be reused, so only a process
+                // group (which outlives it while descendants hold the pipe) is signalled
+                if (job.watchdog && (!job.exited || job.process.processGroup)) {
+                    waitAtMost(job.watchdog->check());
+                    if (job.watchdog->shouldAbandonOutput()) {
+                        for (int* fd : {&job.process.outputFd, &job.process.errorFd}) {
+                            if (*fd >= 0) {
+                                epoll_ctl(epollFd, EPOLL_CTL_DEL, *fd, nullptr);
+                                close(*fd);
+                                *fd = -1;
+                            }
+                        }
+                    }
+                }
+                if (stopping) {
+                    reap(job);
+                }
+
+                bool drained = (job.process.outputFd < 0 && job.process.errorFd < 0) || (stopping && job.exited);
+                if (drained && reap(job)) {
+                    finishJob(std::move(it->second), completed);
+                    it = jobs.erase(it);
+                    continue;
+                }
+                // Without a pidfd, a child that closed its output is polled for exit
+                if (stopping || (job.process.outputFd < 0 && job.process.errorFd < 0 && job.pidFd < 0)) {
+                    waitAtMost(10);
+                }
+                ++it;
+            }
+        }
+
+        // Report outside the lock so callbacks may start or cancel other children
+        for (auto& job : completed) {
+            if (job->onComplete) {
+                job->onComplete(job->result);
+            }
+            job->promise.set_value(std::move(job->result));
+        }
+    }
+}
+
+#else
+// Portable fallback: one thread per child running the synchronous executor
+
+struct ProcessReactor::Job {
+    // A holdInput launch waits here until release(); without pipes we own there is
+    // nothing to keep open, so the child simply starts then
+    bool held = false;
+    std::vector<std::string> argv;
+    ProcessOptions options;
+    CompletionCallback onComplete;
+    std::shared_ptr<std::promise<ProcessResult>> promise;
+};
+
+ProcessReactor::ProcessReactor() = default;
+
+ProcessReactor::~ProcessReactor() {
+    stopping = true;
+    std::vector<uint64_t> held;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& [id, job] : jobs) {
+            if (job->held) {
+                held.push_back(id);
+            }
+        }
+    }
+    for (uint64_t id : held) {
+        cancel(id);
+    }
+    std::map<uint64_t, std::thread> remaining;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        remaining.swap(runners);
+    }
+    for (auto& [id, runner] : remaining) {
+        runner.join();
+    }
+}
+
+void ProcessReactor::joinFinishedRunners() {
+    std::vector<std::thread> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (uint64_t id : finishedRunners) {
+            auto it = runners.find(id);
+            if (it != runners.end()) {
+                finished.push_back(std::move(it->second));
+                runners.erase(it);
+            }
+        }
+        finishedRunners.clear();
+    }
+    // Each has nothing left to do but return
+    for (auto& runner : finished) {
+        runner.join();
+    }
+}
+
+ProcessHandle ProcessReactor::start(const std::vector<std::string>& argv, const ProcessOptions& options,
+                                    CompletionCallback onComplete) {
+    joinFinishedRunners();
+    auto promise = std::make_shared<std::promise<ProcessResult>>();
+    ProcessHandle handle;
+    handle.reactor = this;
+    handle.result = promise->get_future().share();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t id = nextId++;
+    handle.processId = id;
+    jobs[id] = std::make_unique<Job>();
+    if (options.holdInput) {
+        Job& job = *jobs[id];
+        job.held = true;
+        job.argv = argv;
+        job.options = options;
+        job.onComplete = std::move(onComplete);
+        job.promise = promise;
+        return handle;
+    }
+
+    runners[id] = std::thread([this, id, argv, options, onComplete, promise]() {
+        ProcessResult result = ProcessExecutor::execute(argv, options);
+        if (onComplete) {
+            onComplete(result);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.erase(id);
+        }
+        promise->set_value(std::move(result));
+        std::lock_guard<std::mutex> lock(mutex);
+        finishedRunners.push_back(id);
+    });
+    return handle;
+}
+
+bool ProcessReactor::cancel(uint64_t processId) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it = jobs.find(processId);
+    if (it == jobs.end() || !it->second->held) {
+        return false;  // The synchronous executor can't be interrupted
+    }
+    std::unique_ptr<Job> job = std::move(it->second);
+    jobs.erase(it);
+    lock.unlock();
+
+    ProcessResult result;
+    result.cancelled = true;
+    if (job->onComplete) {
+        job->onComplete(result);
+    }
+    job->promise->set_value(std::move(result));
+    return true;
+}
+
+bool ProcessReactor::release(uint64_t processId, const std::string& input) {
+    joinFinishedRunners();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(processId);
+    if (it == jobs.end() || !it->second->held) {
+        return false;
+    }
+    Job& job = *it->second;
+    job.held = false;
+    ProcessOptions options = job.options;
+    options.holdInput = false;
+    options.stdinData = input;
+
+    runners[processId] = std::thread([this, processId, argv = job.argv, options, onComplete = job.onComplete,
+                                      promise = job.promise]() {
+        ProcessResult result = ProcessExecutor::execute(argv, options);
+        if (onComplete) {
+            onComplete(result);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.erase(processId);
+        }
+        promise->set_value(std::move(result));
+        std::lock_guard<std::mutex> lock(mutex);
+        finishedRunners.push_back(processId);
+    });
+    return true;
+}
+
+size_t ProcessReactor::activeCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size();
+}
+
+void ProcessReactor::wake() {}
+#endif
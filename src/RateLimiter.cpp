@@ -0,0 +1,84 @@
+#include <RateLimiter.h>
+#include <algorithm>
+#include <cmath>
+
+TokenBucket::TokenBucket(RateLimit limit, Clock::time_point now)
+    : tokensPerSecond(limit.requestsPerMinute / 60.0),
+      capacity(std::max(limit.burst, 1)),
+      tokens(capacity),
+      lastRefill(now) {}
+
+void TokenBucket::refill(Clock::time_point now) {
+    if (now <= lastRefill) {
+        return;
+    }
+    double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+    tokens = std::min(capacity, tokens + elapsed * tokensPerSecond);
+    lastRefill = now;
+}
+
+double TokenBucket::available(Clock::time_point now) {
+    refill(now);
+    return tokens;
+}
+
+std::chrono::milliseconds TokenBucket::reserve(Clock::time_point now) {
+    refill(now);
+    tokens -= 1;
+    if (tokens >= 0 || tokensPerSecond <= 0) {
+        return std::chrono::milliseconds(0);
+    }
+    return std::chrono::milliseconds(static_cast<long long>(std::ceil(-tokens / tokensPerSecond * 1000)));
+}
+
+ModelRateLimiter::ModelRateLimiter(ClockFunction clock) : clock(std::move(clock)) {}
+
+void ModelRateLimiter::configure(RateLimit newDefaults, std::map<std::string, RateLimit> newPerModel) {
+    std::lock_guard<std::mutex> lock(mutex);
+    defaults = newDefaults;
+    perModel = std::move(newPerModel);
+    buckets.clear();
+}
+
+RateLimit ModelRateLimiter::limitFor(const std::string& model) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return limitForLocked(model);
+}
+
+RateLimit ModelRateLimiter::limitForLocked(const std::string& model) const {
+    RateLimit limit = defaults;
+    auto it = perModel.find(model);
+    if (it != perModel.end()) {
+        if (it->second.requestsPerMinute > 0) {
+            limit.requestsPerMinute = it->second.requestsPerMinute;
+        }
+        if (it->second.burst > 0) {
+            limit.burst = it->second.burst;
+        }
+    }
+    limit.burst = std::max(limit.burst, 1);
+    return limit;
+}
+
+bool ModelRateLimiter::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (defaults.requestsPerMinute > 0) {
+        return true;
+    }
+    return std::any_of(perModel.begin(), perModel.end(),
+                       [](const auto& entry) { return entry.second.requestsPerMinute > 0; });
+}
+
+std::chrono::milliseconds ModelRateLimiter::reserve(const std::string& model) {
+    std::lock_guard<std::mutex> lock(mutex);
+    RateLimit limit = limitForLocked(model);
+    if (limit.requestsPerMinute <= 0) {
+        return std::chrono::milliseconds(0);
+    }
+    auto now = clock();
+    auto it = buckets.find(model);
+    if (it == buckets.end()) {
+        it = buckets.emplace(model, TokenBucket(limit, now)).first;
+    }
+    return it->second.reserve(now);
+}
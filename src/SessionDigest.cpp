@@ -0,0 +1,242 @@
+#include <SessionDigest.h>
+#include <fstream>
+#include <sstream>
+#include <cctype>
+
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+static uint64_t hashBytes(uint64_t hash, const char* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+std::vector<std::string> splitSessionEntries(const std::string& log) {
+    std::vector<std::string> result;
+    size_t pos = 0;
+    while (pos < log.size()) {
+        size_t end = log.find('\n', pos);
+        end = (end == std::string::npos) ? log.size() : end + 1;
+        bool continuation = !result.empty() && (log[pos] == ' ' || log[pos] == '\t');
+        // Blank lines belong to the entry before them
+        bool blank = log.find_first_not_of(" \t\r\n", pos) >= end;
+        if ((continuation || blank) && !result.empty()) {
+            result.back() += log.substr(pos, end - pos);
+        } else {
+            result.push_back(log.substr(pos, end - pos));
+        }
+        pos = end;
+    }
+    return result;
+}
+
+std::string compactSessionEntry(const std::string& entry, size_t maxChars) {
+    // Collapse the entry onto one line
+    std::string text;
+    for (char c : entry) {
+        bool space = std::isspace(static_cast<unsigned char>(c)) != 0;
+        if (space) {
+            if (!text.empty() && text.back() != ' ') {
+                text += ' ';
+            }
+        } else {
+            text += c;
+        }
+    }
+    while (!text.empty() && text.back() == ' ') {
+        text.pop_back();
+    }
+
+    // "[2026-01-24 10:30:00] " in front of entries GemStack wrote
+    if (text.size() > 2 && text[0] == '[' && std::isdigit(static_cast<unsigned char>(text[1]))) {
+        size_t close = text.find("] ");
+        if (close != std::string::npos) {
+            text = text.substr(close + 2);
+        }
+    }
+
+    std::string marker = "* ";
+    if (text.rfind("[SUCCESS] ", 0) == 0) {
+        marker = "+ ";
+        text = text.substr(10);
+    } else if (text.rfind("[FAILED] ", 0) == 0) {
+        marker = "! ";
+        text = text.substr(9);
+    }
+
+    std::string line = marker + text;
+    if (line.size() > maxChars && maxChars > 3) {
+        line = line.substr(0, maxChars - 3) + "...";
+    }
+    return line;
+}
+
+uint64_t estimateTokens(uint64_t bytes) {
+    return (bytes + 3) / 4;
+}
+
+SessionDigest::SessionDigest(size_t maxChars) : maxChars(maxChars), prefixHash(FNV_OFFSET) {}
+
+void SessionDigest::setMaxChars(size_t newMaxChars) {
+    maxChars = newMaxChars;
+    trimLines();
+}
+
+bool SessionDigest::covers(const std::string& log) const {
+    return log.size() >= bytes && hashBytes(FNV_OFFSET, log.data(), bytes) == prefixHash;
+}
+
+void SessionDigest::fold(const std::string& entry) {
+    entries++;
+    bytes += entry.size();
+    prefixHash = hashBytes(prefixHash, entry.data(), entry.size());
+
+    std::string line = compactSessionEntry(entry);
+    if (line[0] == '+') {
+        succeeded++;
+    } else if (line[0] == '!') {
+        failed++;
+    } else {
+        notes++;
+    }
+    lines.push_back(line);
+    lineChars += line.size() + 1;
+    trimLines();
+}
+
+void SessionDigest::trimLines() {
+    while (lineChars > maxChars && !lines.empty()) {
+        lineChars -= lines.front().size() + 1;
+        lines.pop_front();
+        dropped++;
+    }
+}
+
+void SessionDigest::clear() {
+    entries = 0;
+    bytes = 0;
+    prefixHash = FNV_OFFSET;
+    succeeded = 0;
+    failed = 0;
+    notes = 0;
+    dropped = 0;
+    lines.clear();
+    lineChars = 0;
+}
+
+std::string SessionDigest::render() const {
+    if (entries == 0) {
+        return "";
+    }
+    std::string text = "Earlier entries, summarized (" + std::to_string(succeeded) + " succeeded, " +
+                       std::to_string(failed) + " failed, " + std::to_string(notes) + " notes):\n";
+    if (dropped > 0) {
+        text += "(" + std::to_string(dropped) + " oldest entries omitted)\n";
+    }
+    for (const auto& line : lines) {
+        text += line + "\n";
+    }
+    return text;
+}
+
+bool SessionDigest::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    clear();
+    std::string line;
+    bool inLines = false;
+    while (std::getline(file, line)) {
+        if (inLines) {
+            if (!line.empty()) {
+                lines.push_back(line);
+                lineChars += line.size() + 1;
+            }
+            continue;
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (line == "---") {
+            inLines = true;
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+        if (key == "entries") fields >> entries;
+        else if (key == "bytes") fields >> bytes;
+        else if (key == "hash") fields >> prefixHash;
+        else if (key == "succeeded") fields >> succeeded;
+        else if (key == "failed") fields >> failed;
+        else if (key == "notes") fields >> notes;
+        else if (key == "dropped") fields >> dropped;
+    }
+    trimLines();
+    return true;
+}
+
+bool SessionDigest::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "# GemStack session digest: older session log entries, rebuilt whenever the log is cleared or edited\n";
+    file << "entries " << entries << "\n";
+    file << "bytes " << bytes << "\n";
+    file << "hash " << prefixHash << "\n";
+    file << "succeeded " << succeeded << "\n";
+    file << "failed " << failed << "\n";
+    file << "notes " << notes << "\n";
+    file << "dropped " << dropped << "\n";
+    file << "---\n";
+    for (const auto& line : lines) {
+        file << line << "\n";
+    }
+    return file.good();
+}
+
+// Whether an entry starts at pos: a line of its own that is neither indented nor blank
+static bool startsEntry(const std::string& log, size_t pos) {
+    if (pos == 0 || pos == log.size()) {
+        return pos == 0 || log[pos - 1] == '\n';
+    }
+    if (log[pos - 1] != '\n' || log[pos] == ' ' || log[pos] == '\t') {
+        return false;
+    }
+    size_t end = log.find('\n', pos);
+    return log.find_first_not_of(" \t\r\n", pos) < (end == std::string::npos ? log.size() : end);
+}
+
+BoundedSessionLog boundSessionLog(const std::string& log, size_t recentEntries, SessionDigest& digest,
+                                  bool verifyPrefix) {
+    BoundedSessionLog result;
+    result.logBytes = log.size();
+    if (recentEntries < 1) {
+        recentEntries = 1;
+    }
+
+    // The digest must still end on an entry boundary (a folded note may have been continued)
+    bool valid = digest.foldedBytes() <= log.size() && startsEntry(log, digest.foldedBytes());
+    if (!valid || (verifyPrefix && !digest.covers(log))) {
+        digest.clear();
+        result.digestChanged = true;
+    }
+
+    // Everything before foldedBytes() is already in the digest
+    std::vector<std::string> entries = splitSessionEntries(log.substr(digest.foldedBytes()));
+    size_t foldUntil = (entries.size() > recentEntries) ? entries.size() - recentEntries : 0;
+    for (size_t i = 0; i < foldUntil; i++) {
+        digest.fold(entries[i]);
+        result.digestChanged = true;
+    }
+
+    result.digest = digest.render();
+    result.recent = log.substr(digest.foldedBytes());
+    return result;
+}
@@ -0,0 +1,83 @@
+#include <SessionLogCache.h>
+#include <fstream>
+#include <algorithm>
+
+SessionLogCache::SessionLogCache(std::string path) : path(std::move(path)) {}
+
+std::string SessionLogCache::contents() {
+    std::lock_guard<std::mutex> lock(mutex);
+    refresh();
+    return cached;
+}
+
+std::string SessionLogCache::contents(uint64_t& generation) {
+    std::lock_guard<std::mutex> lock(mutex);
+    refresh();
+    generation = generationCount;
+    return cached;
+}
+
+void SessionLogCache::invalidate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    discard();
+}
+
+void SessionLogCache::discard() {
+    cached.clear();
+    generationCount++;
+}
+
+uint64_t SessionLogCache::bytesRead() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return totalBytesRead;
+}
+
+int SessionLogCache::fullReads() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fullReadCount;
+}
+
+void SessionLogCache::refresh() {
+    // Binary, so the cached length is a file offset
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        discard();
+        return;
+    }
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    if (size < 0) {
+        discard();
+        return;
+    }
+
+    size_t offset = cached.size();
+    bool fromScratch = static_cast<size_t>(size) < offset;
+    if (!fromScratch && offset > 0) {
+        // The bytes we already hold must still be there, or the file was rewritten
+        size_t check = std::min(offset, CHECK_BYTES);
+        std::string onDisk(check, '\0');
+        file.seekg(static_cast<std::streamoff>(offset - check));
+        file.read(&onDisk[0], static_cast<std::streamsize>(check));
+        totalBytesRead += static_cast<uint64_t>(file.gcount());
+        fromScratch = !file || cached.compare(offset - check, check, onDisk) != 0;
+        file.clear();
+    }
+    if (fromScratch) {
+        discard();
+        offset = 0;
+    }
+    if (static_cast<size_t>(size) == offset) {
+        return;
+    }
+    if (offset == 0) {
+        fullReadCount++;
+    }
+
+    std::string appended(static_cast<size_t>(size) - offset, '\0');
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(&appended[0], static_cast<std::streamsize>(appended.size()));
+    appended.resize(static_cast<size_t>(file.gcount()));
+    totalBytesRead += appended.size();
+    cached += appended;
+}
@@ -0,0 +1,484 @@
+#include <TaskGraph.h>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <set>
+
+std::vector<std::string> parseLabelList(const std::string& value) {
+    std::vector<std::string> labels;
+    std::string current;
+    for (char c : value) {
+        if (c == ',' || c == ' ' || c == '\t') {
+            if (!current.empty()) {
+                labels.push_back(current);
+                current.clear();
+            }
+        } else {
+            current += c;
+        }
+    }
+    if (!current.empty()) {
+        labels.push_back(current);
+    }
+    return labels;
+}
+
+void TaskGraph::addTasks(const std::vector<TaskSpec>& specs) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const size_t base = nodes.size();
+    const int blockBase = nextBlock - 1;
+    int maxBlock = 0;
+
+    // Pass 1: register nodes and their labels so 'after' may reference later tasks
+    for (const auto& spec : specs) {
+        size_t index = nodes.size();
+        TaskNode node;
+        node.spec = spec;
+
+        if (spec.block > 0) {
+            node.spec.block = blockBase + spec.block;
+            maxBlock = std::max(maxBlock, spec.block);
+            lastTaskInBlock[node.spec.block] = index;
+
+            if (!spec.blockId.empty()) {
+                auto it = blockLabels.find(spec.blockId);
+                if (it == blockLabels.end()) {
+                    blockLabels[spec.blockId] = node.spec.block;
+                } else if (it->second != node.spec.block) {
+                    std::cout << "[GemStack] Warning: Duplicate block id \"" << spec.blockId
+                              << "\". Keeping the first definition." << std::endl;
+                }
+            }
+        }
+
+        if (!spec.id.empty()) {
+            if (labels.count(spec.id) || blockLabels.count(spec.id)) {
+                std::cout << "[GemStack] Warning: Duplicate id \"" << spec.id
+                          << "\". Keeping the first definition." << std::endl;
+            } else {
+                labels[spec.id] = index;
+            }
+        }
+
+        nodes.push_back(node);
+    }
+    nextBlock = blockBase + maxBlock + 1;
+
+    // Pass 2: resolve dependencies (implicit block order + explicit labels)
+    std::map<int, size_t> previousInBlock;
+    for (size_t index = base; index < nodes.size(); index++) {
+        TaskNode& node = nodes[index];
+        std::set<size_t> deps;
+
+        if (node.spec.block > 0) {
+            auto prev = previousInBlock.find(node.spec.block);
+            if (prev != previousInBlock.end()) {
+                deps.insert(prev->second);
+            }
+            previousInBlock[node.spec.block] = index;
+        }
+
+        for (const auto& label : node.spec.after) {
+            auto taskIt = labels.find(label);
+            if (taskIt != labels.end()) {
+                deps.insert(taskIt->second);
+                continue;
+            }
+            auto blockIt = blockLabels.find(label);
+            if (blockIt != blockLabels.end()) {
+                deps.insert(lastTaskInBlock[blockIt->second]);
+                continue;
+            }
+            std::cout << "[GemStack] Warning: Unknown dependency \"" << label
+                      << "\" for task " << (index + 1) << ". Ignoring it." << std::endl;
+        }
+        deps.erase(index);
+
+        for (size_t dep : deps) {
+            node.dependencies.push_back(dep);
+            nodes[dep].dependents.push_back(index);
+            if (nodes[dep].state != TaskState::Succeeded || isHeld(dep, index)) {
+                node.unmetDependencies++;
+            }
+        }
+    }
+
+    // Pass 3: Kahn's algorithm over the new nodes to find cycles
+    std::vector<size_t> inDegree(nodes.size() - base, 0);
+    for (size_t index = base; index < nodes.size(); index++) {
+        for (size_t dep : nodes[index].dependencies) {
+            if (dep >= base) {
+                inDegree[index - base]++;
+            }
+        }
+    }
+    std::vector<size_t> frontier;
+    for (size_t i = 0; i < inDegree.size(); i++) {
+        if (inDegree[i] == 0) frontier.push_back(base + i);
+    }
+    std::vector<bool> reachable(inDegree.size(), false);
+    while (!frontier.empty()) {
+        size_t index = frontier.back();
+        frontier.pop_back();
+        reachable[index - base] = true;
+        for (size_t dependent : nodes[index].dependents) {
+            if (dependent >= base && --inDegree[dependent - base] == 0) {
+                frontier.push_back(dependent);
+            }
+        }
+    }
+
+    // Pass 4: skip cycles and anything behind an already failed task, release the rest
+    for (size_t index = base; index < nodes.size(); index++) {
+        TaskNode& node = nodes[index];
+        if (node.state != TaskState::Pending) {
+            continue;
+        }
+
+        if (!reachable[index - base]) {
+            std::cout << "[GemStack] Warning: Task " << (index + 1)
+                      << " is part of a dependency cycle. Skipping it." << std::endl;
+            node.state = TaskState::Skipped;
+            skipDownstream(index);
+            continue;
+        }
+
+        bool upstreamFailed = false;
+        for (size_t dep : node.dependencies) {
+            if (nodes[dep].state == TaskState::Failed || nodes[dep].state == TaskState::Skipped) {
+                upstreamFailed = true;
+            }
+        }
+        if (upstreamFailed) {
+            node.state = TaskState::Skipped;
+            skipDownstream(index);
+        } else if (node.unmetDependencies == 0) {
+            markReady(index);
+        }
+    }
+
+    readyCV.notify_all();
+}
+
+size_t TaskGraph::addTask(const std::string& command) {
+    std::lock_guard<std::mutex> lock(mutex);
+    TaskNode node;
+    node.spec.command = command;
+    nodes.push_back(node);
+    size_t index = nodes.size() - 1;
+    markReady(index);
+    // All: waitUntilIdle() shares the condition variable and must not take a worker's wakeup
+    readyCV.notify_all();
+    return index;
+}
+
+std::optional<size_t> TaskGraph::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        // Release parked tasks whose time has come
+        auto now = std::chrono::steady_clock::now();
+        auto earliest = std::chrono::steady_clock::time_point::max();
+        for (auto it = parkedTasks.begin(); it != parkedTasks.end();) {
+            if (it->first <= now) {
+                readyTasks.push_back(it->second);
+                std::push_heap(readyTasks.begin(), readyTasks.end(), std::greater<size_t>());
+                it = parkedTasks.erase(it);
+            } else {
+                earliest = std::min(earliest, it->first);
+                ++it;
+            }
+        }
+
+        if (!readyTasks.empty()) {
+            break;
+        }
+        if (closed && runningCount == 0 && parkedTasks.empty() && heldBlocks.empty()) {
+            return std::nullopt;
+        }
+        if (parkedTasks.empty()) {
+            readyCV.wait(lock);
+        } else {
+            readyCV.wait_until(lock, earliest);
+        }
+    }
+
+    std::pop_heap(readyTasks.begin(), readyTasks.end(), std::greater<size_t>());
+    size_t index = readyTasks.back();
+    readyTasks.pop_back();
+
+    nodes[index].state = TaskState::Running;
+    runningCount++;
+    return index;
+}
+
+std::vector<size_t> TaskGraph::complete(size_t index, bool success) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<size_t> skipped;
+    if (index >= nodes.size() || nodes[index].state != TaskState::Running) {
+        return skipped;
+    }
+
+    runningCount--;
+    if (success) {
+        nodes[index].state = TaskState::Succeeded;
+        for (size_t dependent : nodes[index].dependents) {
+            if (isHeld(index, dependent)) {
+                heldBlocks.insert(nodes[index].spec.block);
+                continue;
+            }
+            TaskNode& node = nodes[dependent];
+            if (node.state == TaskState::Pending && node.unmetDependencies > 0) {
+                if (--node.unmetDependencies == 0) {
+                    markReady(dependent);
+                }
+            }
+        }
+    } else {
+        nodes[index].state = TaskState::Failed;
+        skipped = skipDownstream(index);
+    }
+
+    // Wake workers for new ready tasks, or so they can exit once drained
+    readyCV.notify_all();
+    return skipped;
+}
+
+void TaskGraph::holdBlockDependents(bool hold) {
+    std::lock_guard<std::mutex> lock(mutex);
+    holdForMerge = hold;
+}
+
+std::vector<size_t> TaskGraph::releaseBlock(int block, bool merged) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<size_t> skipped;
+    if (!releasedBlocks.insert(block).second) {
+        return skipped;
+    }
+    heldBlocks.erase(block);
+
+    for (size_t index = 0; index < nodes.size(); index++) {
+        if (nodes[index].spec.block != block || nodes[index].state != TaskState::Succeeded) {
+            continue;
+        }
+        for (size_t dependent : nodes[index].dependents) {
+            TaskNode& node = nodes[dependent];
+            if (node.spec.block == block || node.state != TaskState::Pending) {
+                continue;
+            }
+            if (!merged) {
+                // Its changes never reached the main checkout
+                node.state = TaskState::Skipped;
+                skipped.push_back(dependent);
+                std::vector<size_t> downstream = skipDownstream(dependent);
+                skipped.insert(skipped.end(), downstream.begin(), downstream.end());
+            } else if (node.unmetDependencies > 0 && --node.unmetDependencies == 0) {
+                markReady(dependent);
+            }
+        }
+    }
+
+    readyCV.notify_all();
+    return skipped;
+}
+
+void TaskGraph::park(size_t index, std::chrono::steady_clock::time_point notBefore) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index >= nodes.size() || nodes[index].state != TaskState::Running) {
+        return;
+    }
+    runningCount--;
+    nodes[index].state = TaskState::Ready;
+    nodes[index].parkCount++;
+    parkedTasks.emplace_back(notBefore, index);
+    // Idle workers recompute how long to sleep
+    readyCV.notify_all();
+}
+
+int TaskGraph::parkCount(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index < nodes.size() ? nodes[index].parkCount : 0;
+}
+
+void TaskGraph::close() {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    readyCV.notify_all();
+}
+
+std::string TaskGraph::command(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index < nodes.size() ? nodes[index].spec.command : "";
+}
+
+TaskSpec TaskGraph::task(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index < nodes.size() ? nodes[index].spec : TaskSpec();
+}
+
+TaskState TaskGraph::state(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index < nodes.size() ? nodes[index].state : TaskState::Skipped;
+}
+
+std::vector<size_t> TaskGraph::dependencies(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index < nodes.size() ? nodes[index].dependencies : std::vector<size_t>();
+}
+
+size_t TaskGraph::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return nodes.size();
+}
+
+size_t TaskGraph::remaining() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& node : nodes) {
+        if (node.state == TaskState::Pending || node.state == TaskState::Ready) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void TaskGraph::waitUntilIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    readyCV.wait(lock, [this]() {
+        return readyTasks.empty() && parkedTasks.empty() && runningCount == 0 && heldBlocks.empty();
+    });
+}
+
+size_t TaskGraph::cancelPending() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t cancelled = 0;
+    for (auto& node : nodes) {
+        if (node.state == TaskState::Pending || node.state == TaskState::Ready) {
+            node.state = TaskState::Skipped;
+            cancelled++;
+        }
+    }
+    readyTasks.clear();
+    parkedTasks.clear();
+    heldBlocks.clear();
+    closed = true;
+    readyCV.notify_all();
+    return cancelled;
+}
+
+std::vector<int> TaskGraph::blocks() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<int> result;
+    for (const auto& entry : lastTaskInBlock) {
+        result.push_back(entry.first);
+    }
+    return result;
+}
+
+std::vector<int> TaskGraph::blockOrder() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Blocks each block waits for, following dependencies through tasks outside blocks
+    std::map<int, std::set<int>> waitsFor;
+    for (size_t index = 0; index < nodes.size(); index++) {
+        int block = nodes[index].spec.block;
+        if (block <= 0) continue;
+        std::set<int>& upstream = waitsFor[block];
+        std::vector<size_t> stack = nodes[index].dependencies;
+        std::set<size_t> seen;
+        while (!stack.empty()) {
+            size_t current = stack.back();
+            stack.pop_back();
+            if (!seen.insert(current).second) continue;
+            int currentBlock = nodes[current].spec.block;
+            if (currentBlock > 0 && currentBlock != block) {
+                upstream.insert(currentBlock);
+            }
+            stack.insert(stack.end(), nodes[current].dependencies.begin(), nodes[current].dependencies.end());
+        }
+    }
+
+    // Repeatedly take the lowest block whose upstream blocks are all placed
+    std::vector<int> order;
+    std::set<int> placed;
+    while (order.size() < waitsFor.size()) {
+        bool progressed = false;
+        for (const auto& [block, upstream] : waitsFor) {
+            if (placed.count(block)) continue;
+            bool ready = std::all_of(upstream.begin(), upstream.end(),
+                                     [&placed](int dep) { return placed.count(dep) > 0; });
+            if (ready) {
+                order.push_back(block);
+                placed.insert(block);
+                progressed = true;
+                break;
+            }
+        }
+        if (!progressed) {
+            // Cycles were skipped when the tasks were added; keep the rest ascending
+            for (const auto& entry : waitsFor) {
+                if (!placed.count(entry.first)) {
+                    order.push_back(entry.first);
+                    placed.insert(entry.first);
+                }
+            }
+        }
+    }
+    return order;
+}
+
+std::optional<bool> TaskGraph::blockOutcome(int block) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    bool allSucceeded = true;
+    bool found = false;
+    for (const auto& node : nodes) {
+        if (node.spec.block != block) continue;
+        found = true;
+        switch (node.state) {
+            case TaskState::Pending:
+            case TaskState::Ready:
+            case TaskState::Running:
+                return std::nullopt;
+            case TaskState::Succeeded:
+                break;
+            default:
+                allSucceeded = false;
+                break;
+        }
+    }
+    if (!found) {
+        return std::nullopt;
+    }
+    return allSucceeded;
+}
+
+// Caller holds the mutex
+bool TaskGraph::isHeld(size_t dependency, size_t dependent) const {
+    int block = nodes[dependency].spec.block;
+    return holdForMerge && block > 0 && nodes[dependent].spec.block != block && !releasedBlocks.count(block);
+}
+
+// Caller holds the mutex
+void TaskGraph::markReady(size_t index) {
+    nodes[index].state = TaskState::Ready;
+    readyTasks.push_back(index);
+    std::push_heap(readyTasks.begin(), readyTasks.end(), std::greater<size_t>());
+}
+
+// Caller holds the mutex
+std::vector<size_t> TaskGraph::skipDownstream(size_t index) {
+    std::vector<size_t> skipped;
+    std::vector<size_t> stack = {index};
+    while (!stack.empty()) {
+        size_t current = stack.back();
+        stack.pop_back();
+        for (size_t dependent : nodes[current].dependents) {
+            if (nodes[dependent].state == TaskState::Pending) {
+                nodes[dependent].state = TaskState::Skipped;
+                skipped.push_back(dependent);
+                stack.push_back(dependent);
+            }
+        }
+    }
+    return skipped;
+}
@@ -0,0 +1,41 @@
+#include <WaitController.h>
+
+WaitOutcome WaitController::waitFor(std::chrono::milliseconds duration, bool interruptible) {
+    auto deadline = std::chrono::steady_clock::now() + duration;
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t generation = wakeGeneration;
+    while (true) {
+        if (stopped) {
+            return WaitOutcome::Cancelled;
+        }
+        if (interruptible && wakeGeneration != generation) {
+            return WaitOutcome::Woken;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return WaitOutcome::Elapsed;
+        }
+        changedCV.wait_until(lock, deadline);
+    }
+}
+
+void WaitController::wake() {
+    std::lock_guard<std::mutex> lock(mutex);
+    wakeGeneration++;
+    changedCV.notify_all();
+}
+
+void WaitController::cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+    changedCV.notify_all();
+}
+
+bool WaitController::cancelled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stopped;
+}
+
+void WaitController::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = false;
+}
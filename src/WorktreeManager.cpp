@@ -0,0 +1,238 @@
+#include <WorktreeManager.h>
+#include <GitAutoCommit.h>
+#include <GemStackCore.h>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define GEMSTACK_NULL_DEVICE "nul"
+#else
+#define GEMSTACK_NULL_DEVICE "/dev/null"
+#endif
+
+namespace fs = std::filesystem;
+
+// Run a git command in dir, discarding its output
+static bool runGit(const std::string& args, const std::string& dir) {
+    std::string command = GitAutoCommit::gitCommand(args + " >" GEMSTACK_NULL_DEVICE " 2>&1", dir);
+    return system(command.c_str()) == 0;
+}
+
+// Run a git command in dir and return its trimmed stdout ("" on failure)
+static std::string captureGit(const std::string& args, const std::string& dir) {
+    std::string command = GitAutoCommit::gitCommand(args + " 2>" GEMSTACK_NULL_DEVICE, dir);
+    FILE* pipe = popen(command.c_str(), "r");
+    if (!pipe) {
+        return "";
+    }
+
+    std::string output;
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+        output += buffer;
+    }
+    int result = pclose(pipe);
+    return result == 0 ? trim(output) : "";
+}
+
+// Keep branch/directory names to a safe character set
+static std::string sanitizeRefName(const std::string& name) {
+    std::string sanitized;
+    for (char c : name) {
+        bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                    c == '-' || c == '_' || c == '.';
+        sanitized += safe ? c : '-';
+    }
+    return sanitized;
+}
+
+WorktreeMergeStrategy parseWorktreeMergeStrategy(const std::string& value) {
+    return value == "rebase" ? WorktreeMergeStrategy::Rebase : WorktreeMergeStrategy::Merge;
+}
+
+WorktreeManager::WorktreeManager(const std::string& repoDir, WorktreeMergeStrategy strategy)
+    : repoDir(repoDir), strategy(strategy) {}
+
+bool WorktreeManager::initialize() {
+    if (!GitAutoCommit::isGitRepository(repoDir)) {
+        std::cout << "[GemStack] Repository not initialized. Initializing git repository..." << std::endl;
+        if (!GitAutoCommit::initializeRepository(repoDir)) {
+            std::cerr << "[GemStack] Worktree isolation unavailable: could not initialize git repository" << std::endl;
+            return false;
+        }
+    }
+
+    // Worktrees branch off an existing commit
+    if (captureGit("rev-parse --verify HEAD", repoDir).empty()) {
+        std::cerr << "[GemStack] Worktree isolation unavailable: repository has no commits yet" << std::endl;
+        return false;
+    }
+
+    baseBranch = captureGit("rev-parse --abbrev-ref HEAD", repoDir);
+    if (baseBranch.empty() || baseBranch == "HEAD") {
+        // Detached HEAD: merge into the commit itself
+        baseBranch = captureGit("rev-parse HEAD", repoDir);
+    }
+
+    // Keep worktrees inside the git directory so 'git add -A' in the main checkout never sees them
+    std::string gitDir = captureGit("rev-parse --git-common-dir", repoDir);
+    fs::path gitDirPath(gitDir);
+    if (gitDirPath.is_relative()) {
+        gitDirPath = fs::path(repoDir) / gitDirPath;
+    }
+    std::error_code ec;
+    worktreeRoot = normalizePath(fs::absolute(gitDirPath / "gemstack-worktrees", ec).string());
+
+    runGit("worktree prune", repoDir);
+    return true;
+}
+
+void WorktreeManager::setBlocks(const std::vector<int>& blockOrder) {
+    std::lock_guard<std::mutex> lock(mutex);
+    mergeOrder = blockOrder;
+    nextToMerge = 0;
+}
+
+std::optional<std::string> WorktreeManager::acquire(int block, const std::string& label) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    BlockRecord& record = records[block];
+    if (!record.path.empty()) {
+        return record.path;
+    }
+
+    // Pick an unused branch name; branches kept from earlier conflicts must not be reused
+    std::string name = label.empty() ? "block-" + std::to_string(block) : sanitizeRefName(label);
+    std::string branch = "gemstack/" + name;
+    for (int suffix = 2; !captureGit("rev-parse --verify --quiet refs/heads/" + branch, repoDir).empty(); suffix++) {
+        branch = "gemstack/" + name + "-" + std::to_string(suffix);
+    }
+
+    std::string path = joinPath(worktreeRoot, sanitizeRefName(branch));
+    std::error_code ec;
+    fs::remove_all(path, ec);
+
+    if (!runGit("worktree add -b " + branch + " \"" + path + "\" " + baseBranch, repoDir)) {
+        std::cerr << "[GemStack] Warning: could not create worktree for block " << block
+                  << ". Running it in the main checkout." << std::endl;
+        return std::nullopt;
+    }
+
+    record.branch = branch;
+    record.path = path;
+    std::cout << "[GemStack] Block " << block << " isolated in worktree " << path
+              << " (branch " << branch << ")" << std::endl;
+    return record.path;
+}
+
+std::vector<WorktreeMergeResult> WorktreeManager::finishBlock(int block, bool success) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<WorktreeMergeResult> results;
+
+    BlockRecord& record = records[block];
+    if (record.finished) {
+        return results;
+    }
+    record.finished = true;
+    record.success = success;
+
+    if (std::find(mergeOrder.begin(), mergeOrder.end(), block) == mergeOrder.end()) {
+        mergeOrder.push_back(block);
+    }
+
+    // Merge in fixed block order: stop at the first block that is still running
+    while (nextToMerge < mergeOrder.size()) {
+        auto it = records.find(mergeOrder[nextToMerge]);
+        if (it == records.end() || !it->second.finished) {
+            break;
+        }
+        if (!it->second.path.empty()) {
+            results.push_back(mergeBlock(it->first, it->second));
+        } else {
+            // Ran in the main checkout (no worktree could be created): nothing to merge
+            WorktreeMergeResult result;
+            result.block = it->first;
+            result.merged = it->second.success;
+            result.message = "ran in the main checkout";
+            results.push_back(result);
+        }
+        nextToMerge++;
+    }
+
+    return results;
+}
+
+WorktreeMergeResult WorktreeManager::mergeBlock(int block, BlockRecord& record) {
+    WorktreeMergeResult result;
+    result.block = block;
+    result.branch = record.branch;
+
+    // Commit whatever the block left behind so the branch carries all of its work
+    GitAutoCommit::commitAllChanges("[GemStack] Block " + std::to_string(block) + " results", record.path);
+
+    if (!record.success) {
+        result.message = "block failed; branch " + record.branch + " kept for inspection";
+        std::cerr << "[GemStack] Block " << block << " failed. Not merging; branch "
+                  << record.branch << " kept for inspection." << std::endl;
+        removeWorktree(record);
+        return result;
+    }
+
+    std::string newCommits = captureGit("rev-list --count " + baseBranch + ".." + record.branch, repoDir);
+    if (newCommits == "0") {
+        result.merged = true;
+        result.message = "no changes";
+        removeWorktree(record);
+        runGit("branch -D " + record.branch, repoDir);
+        return result;
+    }
+
+    if (strategy == WorktreeMergeStrategy::Rebase) {
+        // Replay the block's commits on top of everything merged so far, then fast-forward
+        if (!runGit("rebase " + baseBranch, record.path)) {
+            runGit("rebase --abort", record.path);
+            result.conflict = true;
+        } else if (!runGit("merge --ff-only " + record.branch, repoDir)) {
+            result.conflict = true;
+        }
+    } else {
+        if (!runGit("merge --no-ff --no-edit " + record.branch, repoDir)) {
+            runGit("merge --abort", repoDir);
+            result.conflict = true;
+        }
+    }
+
+    removeWorktree(record);
+
+    if (result.conflict) {
+        result.message = "conflict merging " + record.branch + " into " + baseBranch;
+        std::cerr << "[GemStack] Merge conflict: block " << block << " (branch " << record.branch
+                  << ") could not be merged into " << baseBranch
+                  << ". The branch was kept; resolve it manually." << std::endl;
+        return result;
+    }
+
+    result.merged = true;
+    result.message = "merged " + record.branch + " into " + baseBranch;
+    std::cout << "[GemStack] Merged block " << block << " (" << record.branch << ") into "
+              << baseBranch << std::endl;
+    runGit("branch -d " + record.branch, repoDir);
+    return result;
+}
+
+void WorktreeManager::removeWorktree(const BlockRecord& record) {
+    runGit("worktree remove --force \"" + record.path + "\"", repoDir);
+}
+
+std::string WorktreeManager::getBaseBranch() const {
+    return baseBranch;
+}
+
+std::string WorktreeManager::getWorktreeRoot() const {
+    return worktreeRoot;
+}
@@ -12,19 +12,55 @@
 #include <cstdio>
 #include <array>
 #include <vector>
+#include <map>
 #include <stdexcept>
 #include <filesystem>
 #include <optional>
+#include <algorithm>
+#include <memory>
+#include <csignal>
+#include <functional>
+#include <ctime>
 
 #include <GemStackCore.h>
 #include <GitAutoCommit.h>
 #include <ProcessExecutor.h>
+#include <ProcessReactor.h>
 #include <ConsoleUI.h>
 #include <CliManager.h>
+#include <CliWorkerPool.h>
+#include <AdmissionController.h>
+#include <ModelHealth.h>
+#include <TaskGraph.h>
+#include <ModelRouter.h>
+#include <SessionDigest.h>
+#include <WorktreeManager.h>
 
 // Global auto-commit handler
 GitAutoCommit g_autoCommit;
 
+// Serializes auto-commits between parallel workers (git holds a single index lock)
+std::mutex g_autoCommitMutex;
+
+// Watches every Gemini CLI child from one event-loop thread; kills stragglers on exit
+ProcessReactor g_processReactor;
+
+// Long-lived CLI processes reused across prompts (null unless warm workers are enabled)
+std::unique_ptr<CliWorkerPool> g_workerPool;
+
+// Holds new prompts back while the host is saturated (admits everything unless limits are configured)
+AdmissionController g_admission;
+
+// Per-model circuit breakers, persisted in MODEL_HEALTH_FILENAME
+ModelHealthTable g_modelHealth;
+
+// Progress numbers of parked tasks, reused when they run again
+std::mutex g_parkedTaskMutex;
+std::map<size_t, int> g_parkedTaskNumbers;
+
+// Safety cap for --jobs
+const int MAX_JOBS = 64;
+
 namespace fs = std::filesystem;
 
 // Reflection mode prompt log
@@ -127,112 +163,330 @@ static std::string extractPromptSummary(const std::string& prompt) {
     return summary;
 }
 
-// Execute a single prompt and return the result
-std::pair<bool, std::string> executeSinglePrompt(const std::string& prompt, bool injectSessionContext = true) {
+// A CLI started ahead of a worker's next prompt, so Node boots while the current prompt is
+// committed and the cooldown runs. It blocks reading stdin until the prompt is released to it.
+struct StandbyProcess {
+    ProcessHandle handle;
+    std::string model;
+    std::string workingDir;
+    int timeoutSeconds = 0;
+    int idleTimeoutSeconds = 0;
+};
+
+// Per-worker execution state. Each worker owns its model position so parallel
+// workers never clobber each other's fallback state.
+struct WorkerContext {
+    int id = 0;               // 0 for the main thread (reflective mode), 1..N for pool workers
+    size_t modelIndex = 0;    // Index into modelFallbackList
+    std::string workingDir = ".";  // Where the CLI runs (a block's worktree when isolated)
+    int timeoutSeconds = 0;        // Limits for the current prompt (0 = none)
+    int idleTimeoutSeconds = 0;
+    std::function<bool()> hasPendingWork;  // Whether another prompt is queued (unset = never start a standby)
+    std::optional<StandbyProcess> standby;
+    uint64_t admissionWindow = 0;  // From g_admission.acquire(), reported back on a rate limit
+    ModelPromotionState promotion; // When to try the model above again after a downgrade
+    bool canPark = false;          // The current task may be handed back to the task graph
+    std::optional<std::chrono::steady_clock::time_point> parkedUntil;  // Set when it was
+};
+
+WorkerContext makeWorkerContext(int id) {
+    WorkerContext context;
+    context.id = id;
+    context.modelIndex = currentModelIndex.load();
+    if (isModelRoutingEnabled()) {
+        // Heavy prompts start on the first pro-tier model, even if the list begins with a flash one
+        context.modelIndex = std::max(context.modelIndex, routeModel(PromptWeight::Heavy));
+    }
+    context.timeoutSeconds = g_config.promptTimeoutSeconds;
+    context.idleTimeoutSeconds = g_config.promptIdleTimeoutSeconds;
+    return context;
+}
+
+// Launch options shared by every CLI run in this context
+ProcessOptions makeCliOptions(const WorkerContext& context) {
+    ProcessOptions options;
+    // Execute in the worker's directory (current directory unless isolated in a worktree)
+    options.workingDir = context.workingDir;
+    // Own process group, so a timeout also takes down the agent's shell tool calls
+    options.newProcessGroup = true;
+    options.timeout = std::chrono::seconds(context.timeoutSeconds);
+    options.idleTimeout = std::chrono::seconds(context.idleTimeoutSeconds);
+    // Keep stderr apart: errors are classified from it alone, summaries come from stdout only
+    options.mergeStderr = false;
+    // Stop as soon as a quota / 429 error is printed instead of waiting for the CLI to give up
+    options.errorLineObserver = [](const std::string& line) { return !isModelExhausted(line); };
+    // Keep only the head and tail of huge outputs in memory; summaries and rate-limit checks use those
+    options.outputMemoryLimit = static_cast<size_t>(g_config.outputMemoryLimitMB) << 20;
+    return options;
+}
+
+// Kill a standby CLI that will not be used
+void discardStandby(WorkerContext& context) {
+    if (context.standby) {
+        context.standby->handle.cancel();
+        context.standby.reset();
+    }
+}
+
+// Speculatively start the CLI for the worker's next prompt, guessing it will use the same model,
+// directory and limits as the current one. Warm workers are already booted, so this is only
+// done for one-shot CLI processes.
+void prepareStandby(WorkerContext& context) {
+    if (g_workerPool || !context.hasPendingWork || !context.hasPendingWork()) {
+        return;
+    }
+    std::string model = getModelAt(context.modelIndex);
+    if (context.standby) {
+        const StandbyProcess& standby = *context.standby;
+        if (standby.model == model && standby.workingDir == context.workingDir && !standby.handle.finished()) {
+            return;
+        }
+        discardStandby(context);
+    }
+
+    ProcessOptions options = makeCliOptions(context);
+    options.holdInput = true;
+    std::vector<std::string> argv = {"node", CliManager::getGeminiCliPath(), "--yolo", "--model", model, "prompt"};
+    context.standby = StandbyProcess{g_processReactor.start(argv, options), model, context.workingDir,
+                                     context.timeoutSeconds, context.idleTimeoutSeconds};
+}
+
+// Release the prompt to the standby CLI if it matches this run. Returns an invalid handle
+// (discarding any mismatched standby) when a fresh process is needed instead.
+ProcessHandle claimStandby(WorkerContext& context, const std::string& model, const std::string& input) {
+    ProcessHandle handle;
+    if (!context.standby) {
+        return handle;
+    }
+    const StandbyProcess& standby = *context.standby;
+    bool matches = standby.model == model && standby.workingDir == context.workingDir &&
+                   standby.timeoutSeconds == context.timeoutSeconds &&
+                   standby.idleTimeoutSeconds == context.idleTimeoutSeconds;
+    if (matches && standby.handle.release(input)) {
+        handle = standby.handle;
+        context.standby.reset();
+        return handle;
+    }
+    discardStandby(context);
+    return handle;
+}
+
+// Execute a single prompt and return the result. A meta-query (GemStack asking the model what
+// to do next) is routed as a light prompt.
+std::pair<bool, std::string> executeSinglePrompt(const std::string& prompt, WorkerContext& context,
+                                                 bool injectSessionContext = true, bool metaQuery = false) {
     bool success = false;
     std::string finalOutput;
     std::string promptSummary = extractPromptSummary(prompt);
 
-    // Check if this is a "prompt" command that we can pass via file to avoid shell injection
+    // Check if this is a "prompt" command whose content we can stream over stdin
     bool isPromptCommand = (prompt.find("prompt \"") == 0);
-    std::string tempInputFile = "GemStackInput.tmp";
-    bool useFile = false;
-    std::string fullCommand;
     std::string cliPath = CliManager::getGeminiCliPath();
     std::string model; // Will be set in the loop
+    std::string promptInput;
+    PromptWeight weight = PromptWeight::Heavy;
+    int timeoutAttempts = 0;
+    int rateLimitAttempts = 0;  // Backoff retries on the current model
 
     if (isPromptCommand) {
-        useFile = true;
-        std::string contentToWrite;
-
         // Extract raw content from prompt command
         std::string promptContent = prompt.substr(8);
         if (!promptContent.empty() && promptContent.back() == '"') {
             promptContent.pop_back();
         }
 
+        weight = getPromptWeight(promptContent, metaQuery);
+
         // Build full content with session context
         if (injectSessionContext) {
-            std::string sessionContext = buildSessionContext();
-            contentToWrite = sessionContext + promptContent;
+            promptInput = buildSessionContext() + promptContent;
         } else {
-            contentToWrite = promptContent;
+            promptInput = std::move(promptContent);
         }
+    }
 
-        // Write to temp file
-        std::ofstream outFile(tempInputFile, std::ios::trunc); // Overwrite if exists
-        if (outFile.is_open()) {
-            outFile << contentToWrite;
-            outFile.close();
-        } else {
-            std::cerr << "[GemStack] Error: Could not create temp input file. Falling back to unsafe method." << std::endl;
-            useFile = false;
-        }
+    // Light prompts start on the routed flash model and fall back from there for this prompt
+    // only; the worker's own position (and its downgrades) is kept for heavy prompts
+    bool routed = isModelRoutingEnabled() && weight == PromptWeight::Light;
+    size_t routedIndex = routed ? routeModel(weight) : 0;
+    ModelPromotionState routedPromotion;
+    size_t& modelIndex = routed ? routedIndex : context.modelIndex;
+    ModelPromotionState& promotion = routed ? routedPromotion : context.promotion;
+    if (routed) {
+        std::cout << "[GemStack] Light prompt; routing to " << getModelAt(modelIndex) << std::endl;
+    } else {
+        // Give the better model another chance once the downgrade window has passed
+        maybePromoteModel(modelIndex, promotion, std::chrono::steady_clock::now());
     }
 
     while (!success) {
-        model = getCurrentModel();
+        // Skip models whose circuit breaker is open (rate limited over and over, maybe in an earlier run)
+        size_t available = g_modelHealth.selectModel(modelFallbackList, modelIndex);
+        if (available != modelIndex) {
+            std::cout << "[GemStack] Skipping " << getModelAt(modelIndex) << " (circuit open); using "
+                      << getModelAt(available) << std::endl;
+            modelIndex = available;
+            rateLimitAttempts = 0;
+            noteModelDowngraded(promotion, std::chrono::steady_clock::now());
+        }
+        model = getModelAt(modelIndex);
+
+        // Pace requests to this model's budget (includes retries and downgrades)
+        waitForModelBudget(model);
+        if (isShutdownRequested()) {
+            std::cout << "[GemStack] Shutting down; not starting the prompt." << std::endl;
+            appendToSessionLog(promptSummary, false, "Stopped: GemStack shut down");
+            break;
+        }
         std::cout << "[GemStack] Processing with model " << model << std::endl;
 
-        if (useFile) {
-            // Use redirection from temp file
+        // Launch node directly (no shell), so arguments need no escaping
+        std::vector<std::string> argv = {"node", cliPath, "--yolo", "--model", model};
+        ProcessOptions options = makeCliOptions(context);
+
+        if (isPromptCommand) {
+            // Stream the prompt to the CLI's stdin over a pipe; nothing touches the disk
             // Note: "prompt" subcommand is required
-            fullCommand = "node \"" + cliPath + "\" --yolo --model " + model + " prompt < " + tempInputFile;
+            argv.push_back("prompt");
+            options.stdinData = promptInput;
         } else {
-            // Legacy/Fallback method (unsafe for flags in content, but necessary for non-prompt commands like --version)
-            
-            // Build the prompt with session context if requested (and feasible)
-            std::string promptWithContext = prompt;
-            if (injectSessionContext && !isPromptCommand) { 
-                // Only try to inject if it looks like a prompt but failed isPromptCommand check?
-                // Actually, if it's not "prompt \"...\"", we probably can't inject context easily 
-                // without breaking the command structure (e.g. it might be "--help").
-                // So we skip injection for non-standard prompts.
+            // Non-prompt commands like --version are split into arguments as written.
+            // Session context is not injected: it could break the command structure (e.g. "--help").
+            for (const auto& arg : splitCommandArguments(prompt)) {
+                argv.push_back(arg);
             }
+        }
 
-            // Sanitize
-            std::string safePrompt = escapeForShell(promptWithContext);
-            fullCommand = "node \"" + cliPath + "\" --yolo --model " + model + " " + safePrompt;
+        // Prefer a warm CLI process for this model, then one started during the last cooldown;
+        // start a fresh one if neither can take the prompt
+        auto launched = std::chrono::steady_clock::now();
+        std::optional<ProcessResult> warmResult;
+        if (isPromptCommand && g_workerPool) {
+            warmResult = g_workerPool->run(model, options);
+        }
+        ProcessResult processResult;
+        if (warmResult) {
+            processResult = std::move(*warmResult);
+        } else {
+            ProcessHandle handle = isPromptCommand ? claimStandby(context, model, promptInput) : ProcessHandle();
+            if (!handle.valid()) {
+                handle = g_processReactor.start(argv, options);
+            }
+            processResult = handle.wait();
+        }
+        int result = processResult.exitCode;
+        finalOutput = std::move(processResult.output);
+        double latencySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - launched).count();
+        recordModelOutcome(model, result == 0 && !processResult.timedOut, latencySeconds);
+
+        if (!processResult.spillPath.empty()) {
+            std::cout << "[GemStack] CLI printed " << (processResult.outputSize >> 20)
+                      << " MB; kept its start and end in memory, full output in " << processResult.spillPath << std::endl;
         }
 
-        // Execute in current directory
-        auto [result, output] = ProcessExecutor::execute(fullCommand, ".");
-        finalOutput = output;
+        if (processResult.stoppedByObserver) {
+            std::cout << "[GemStack] Rate limit reported mid-run; stopped the CLI early." << std::endl;
+        }
 
-        if (result == 0 && !isModelExhausted(output)) {
+        if (processResult.timedOut) {
+            std::string reason = processResult.idleTimedOut
+                ? "no output for " + std::to_string(context.idleTimeoutSeconds) + "s"
+                : "exceeded " + std::to_string(context.timeoutSeconds) + "s";
+            std::cerr << "[GemStack] Command timed out (" << reason << "); process group killed." << std::endl;
+            g_modelHealth.recordOtherFailure(model);
+            if (timeoutAttempts < g_config.timeoutRetries) {
+                timeoutAttempts++;
+                std::cout << "[GemStack] Retrying after timeout (" << timeoutAttempts << "/"
+                          << g_config.timeoutRetries << ")..." << std::endl;
+                continue;
+            }
+            appendToSessionLog(promptSummary, false, "Timed out: " + reason);
+            break;
+        } else if (result == 0) {
             std::cout << "[GemStack] Command finished successfully." << std::endl;
             success = true;
+            g_modelHealth.recordSuccess(model);
+            noteModelSucceeded(modelIndex, promotion, std::chrono::steady_clock::now());
+            g_admission.recordSuccess();
 
             // Append to session log
             appendToSessionLog(promptSummary, true);
 
+            // Boot the next prompt's CLI while we commit and cool down
+            prepareStandby(context);
+
             // Perform auto-commit if enabled (uses GitAutoCommit module)
-            g_autoCommit.maybeCommit(promptSummary);
-        } else if (isModelExhausted(output)) {
-            if (!downgradeModel()) {
+            if (context.workingDir == ".") {
+                std::lock_guard<std::mutex> lock(g_autoCommitMutex);
+                g_autoCommit.maybeCommit(promptSummary);
+            } else {
+                // Worktrees have their own index, so no need to serialize with other workers
+                g_autoCommit.maybeCommit(promptSummary, context.workingDir);
+            }
+        } else if (ExhaustionInfo exhaustion = classifyExhaustedRun(result, processResult.errorOutput);
+                   exhaustion.exhausted()) {
+            auto now = std::chrono::steady_clock::now();
+            // Fewer prompts in flight until the quota recovers
+            g_admission.recordRateLimit(context.admissionWindow);
+            // The error may name the model whose quota ran out; otherwise it is the one we asked for
+            std::string affected = exhaustion.model.empty() ? model : exhaustion.model;
+            int retryAfter = exhaustion.retryAfterSeconds;
+            bool retrySoon = retryAfter > 0 && retryAfter <= g_config.rateLimitBackoffMaxSeconds;
+            if (retryAfter > 0 && (!retrySoon || exhaustion.kind == ExhaustionKind::DailyQuota)) {
+                // Out for a long while: every worker skips the model until then
+                g_modelHealth.recordExhaustedUntil(affected, static_cast<long long>(std::time(nullptr)) + retryAfter);
+            } else {
+                // A short delay is handled by parking or backing off; it only counts toward the
+                // breaker threshold, so one burst doesn't push every worker off the model
+                g_modelHealth.recordExhausted(affected);
+            }
+
+            // A burst of 429s often clears in seconds; only a persistent one costs the better model.
+            // A model being re-tried after a downgrade gets no backoff: it is plainly still limited.
+            // Nor does one whose breaker this failure just opened, or whose quota for the day is gone.
+            bool breakerOpen = g_modelHealth.record(affected).state == BreakerState::Open;
+            if (promotion.probing) {
+                std::cout << "[GemStack] " << model << " is still rate limited." << std::endl;
+            } else if (retrySoon && rateLimitAttempts < g_config.rateLimitRetries) {
+                // The error said exactly when to come back: park the task and let this worker
+                // run other work meanwhile, or wait that long if there is nothing else to do
+                rateLimitAttempts++;
+                if (context.canPark) {
+                    context.parkedUntil = now + std::chrono::seconds(retryAfter);
+                    std::cout << "[GemStack] Parking the prompt for " << retryAfter << " seconds as "
+                              << affected << " asked; running other work meanwhile." << std::endl;
+                    break;
+                }
+                performRetryAfterWait(affected, retryAfter);
+                continue;
+            } else if (retryAfter <= 0 && !breakerOpen && exhaustion.kind != ExhaustionKind::DailyQuota &&
+                       rateLimitAttempts < g_config.rateLimitRetries) {
+                performRateLimitBackoff(rateLimitAttempts);
+                rateLimitAttempts++;
+                continue;
+            }
+            rateLimitAttempts = 0;
+            if (!downgradeModel(modelIndex)) {
                 std::cerr << "[GemStack] Command failed: all models exhausted." << std::endl;
                 // Log failure to session log
                 appendToSessionLog(promptSummary, false, "All models exhausted");
                 break;
             }
+            noteModelDowngraded(promotion, now);
+            if (retryAfter > 0) {
+                // Come back up exactly when the quota resets
+                promotion.promoteAt = now + std::chrono::seconds(retryAfter);
+            }
             std::cout << "[GemStack] Retrying command with downgraded model..." << std::endl;
         } else {
             std::cerr << "[GemStack] Command failed with code: " << result << std::endl;
+            g_modelHealth.recordOtherFailure(model);
             // Log failure to session log
             appendToSessionLog(promptSummary, false, "Exit code: " + std::to_string(result));
             break;
         }
     }
 
-    // Cleanup temp file
-    if (useFile) {
-        std::error_code ec;
-        fs::remove(tempInputFile, ec);
-        if (ec) {
-            // Non-critical error, just log debug if needed
-        }
-    }
-
     return {success, finalOutput};
 }
 
@@ -257,6 +511,7 @@ void runReflectiveMode(const std::string& initialPrompt, int maxIterations, Cons
     }
 
     std::string currentPrompt = initialPrompt;
+    WorkerContext workerContext = makeWorkerContext(0);
 
     for (int iteration = 1; iteration <= maxIterations; iteration++) {
         std::cout << "\n----------------------------------------\n";
@@ -283,7 +538,7 @@ void runReflectiveMode(const std::string& initialPrompt, int maxIterations, Cons
         ui.startAnimation();
 
         // Execute the current prompt (with context if applicable)
-        auto [success, output] = executeSinglePrompt(promptWithContext);
+        auto [success, output] = executeSinglePrompt(promptWithContext, workerContext);
 
         // Extract summary from output for the log
         std::string summary = extractOutputSummary(output);
@@ -313,8 +568,8 @@ void runReflectiveMode(const std::string& initialPrompt, int maxIterations, Cons
             break;
         }
 
-        // Perform cooldown if enabled and not the last iteration
-        if (iteration < maxIterations) {
+        // Perform cooldown if enabled and not the last iteration (rate limits pace each request instead)
+        if (iteration < maxIterations && !isRateLimitEnabled()) {
             performCooldown();
         }
 
@@ -340,7 +595,7 @@ void runReflectiveMode(const std::string& initialPrompt, int maxIterations, Cons
             std::string reflectionQuery = "prompt \"" + historyContext + "\"";
 
             // Don't inject session context for the reflection meta-query
-            auto [reflectSuccess, nextPrompt] = executeSinglePrompt(reflectionQuery, false);
+            auto [reflectSuccess, nextPrompt] = executeSinglePrompt(reflectionQuery, workerContext, false, true);
 
             ui.stopAnimation();
 
@@ -357,7 +612,8 @@ void runReflectiveMode(const std::string& initialPrompt, int maxIterations, Cons
                 std::cerr << "[GemStack] AI returned empty response for next prompt." << std::endl;
                 break;
             }
-            nextPrompt = nextPrompt.substr(start, end - start + 1);
+            nextPrompt.erase(end + 1);
+            nextPrompt.erase(0, start);
 
             // Validate the trimmed response isn't empty
             if (nextPrompt.empty()) {
@@ -380,39 +636,125 @@ void runReflectiveMode(const std::string& initialPrompt, int maxIterations, Cons
     std::cout << "========================================\n\n";
 }
 
-void worker(ConsoleUI& ui) {
-    while (true) {
-        std::string command;
-        bool moreCommandsPending = false;
+// Merge back any PromptBlocks whose tasks have all finished (worktree isolation), then
+// release the tasks that were held until those blocks' changes reached the main checkout
+void finishWorktreeBlocks(TaskGraph& taskGraph, WorktreeManager& worktrees, const std::vector<int>& blocks) {
+    for (int block : blocks) {
+        if (block <= 0) continue;
+        std::optional<bool> outcome = taskGraph.blockOutcome(block);
+        if (!outcome) continue;
+
+        std::vector<WorktreeMergeResult> results;
         {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            queueCV.wait(lock, [] { return !commandQueue.empty() || !running; });
+            // Merges write to the main checkout, so serialize with auto-commits there
+            std::lock_guard<std::mutex> lock(g_autoCommitMutex);
+            results = worktrees.finishBlock(block, *outcome);
+        }
+        for (const auto& result : results) {
+            for (size_t skippedIndex : taskGraph.releaseBlock(result.block, result.merged)) {
+                std::string summary = extractPromptSummary(taskGraph.command(skippedIndex));
+                std::cout << "[GemStack] Skipping task " << (skippedIndex + 1) << " (block " << result.block
+                          << " was not merged): " << summary << std::endl;
+                appendToSessionLog(summary, false, "Skipped: dependency not merged");
+            }
+        }
+    }
+}
 
-            if (commandQueue.empty() && !running) {
-                break;
+void worker(TaskGraph& taskGraph, ConsoleUI& ui, int workerId, WorktreeManager* worktrees) {
+    WorkerContext context = makeWorkerContext(workerId);
+    context.hasPendingWork = [&taskGraph]() { return taskGraph.remaining() > 0; };
+
+    while (true) {
+        // Wait for a task whose dependencies have all succeeded
+        std::optional<size_t> taskIndex = taskGraph.acquire();
+        if (!taskIndex) {
+            break;
+        }
+        TaskSpec task = taskGraph.task(*taskIndex);
+        std::string command = task.command;
+
+        // Per-prompt limits from 'timeout'/'idletimeout' directives override the config
+        context.timeoutSeconds = task.timeoutSeconds >= 0 ? task.timeoutSeconds : g_config.promptTimeoutSeconds;
+        context.idleTimeoutSeconds = task.idleTimeoutSeconds >= 0 ? task.idleTimeoutSeconds
+                                                                 : g_config.promptIdleTimeoutSeconds;
+
+        // Run block tasks inside the block's worktree when isolation is enabled
+        context.workingDir = ".";
+        if (worktrees && task.block > 0) {
+            std::lock_guard<std::mutex> lock(g_autoCommitMutex);
+            if (std::optional<std::string> path = worktrees->acquire(task.block, task.blockId)) {
+                context.workingDir = *path;
             }
+        }
 
-            command = commandQueue.front();
-            commandQueue.pop();
-            moreCommandsPending = !commandQueue.empty();
-            isBusy = true;
+        // Increment task counter (a parked task keeps the number it had)
+        int taskNum = 0;
+        {
+            std::lock_guard<std::mutex> lock(g_parkedTaskMutex);
+            auto parked = g_parkedTaskNumbers.find(*taskIndex);
+            if (parked != g_parkedTaskNumbers.end()) {
+                taskNum = parked->second;
+                g_parkedTaskNumbers.erase(parked);
+            }
+        }
+        if (taskNum == 0) {
+            taskNum = ui.incrementTaskProgress();
         }
 
-        // Increment task counter
-        ui.incrementTaskProgress();
+        // Execute the command with model fallback, once the host has room for another CLI.
+        // A prompt may be parked until the time a rate-limit error gave, but not indefinitely.
+        context.canPark = taskGraph.parkCount(*taskIndex) < g_config.rateLimitRetries;
+        context.parkedUntil.reset();
+        bool success = false;
+        if (std::optional<uint64_t> window = g_admission.acquire()) {
+            context.admissionWindow = *window;
+            ui.beginSlot(workerId - 1, taskNum);
+            success = executeSinglePrompt(command, context).first;
+            ui.endSlot(workerId - 1);
+            g_admission.release();
+        } else {
+            // Shut down while held back for host headroom
+            std::cout << "[GemStack] Shutting down; not starting the prompt." << std::endl;
+            appendToSessionLog(extractPromptSummary(command), false, "Stopped: GemStack shut down");
+        }
 
-        // Execute the command with model fallback
-        ui.startAnimation();
-        auto [success, output] = executeSinglePrompt(command);
-        ui.stopAnimation();
+        if (context.parkedUntil && !isShutdownRequested()) {
+            {
+                std::lock_guard<std::mutex> lock(g_parkedTaskMutex);
+                g_parkedTaskNumbers[*taskIndex] = taskNum;
+            }
+            taskGraph.park(*taskIndex, *context.parkedUntil);
+            continue;
+        }
 
-        // Perform cooldown if enabled and more commands are pending
-        if (moreCommandsPending) {
-            performCooldown();
+        // Release dependents, or skip everything downstream of a failure
+        std::vector<size_t> skipped = taskGraph.complete(*taskIndex, success);
+        for (size_t skippedIndex : skipped) {
+            std::string summary = extractPromptSummary(taskGraph.command(skippedIndex));
+            std::cout << "[GemStack] Skipping task " << (skippedIndex + 1)
+                      << " (depends on failed task " << (*taskIndex + 1) << "): " << summary << std::endl;
+            appendToSessionLog(summary, false, "Skipped: dependency failed");
+        }
+
+        if (worktrees) {
+            std::vector<int> finishedBlocks = {task.block};
+            for (size_t skippedIndex : skipped) {
+                finishedBlocks.push_back(taskGraph.task(skippedIndex).block);
+            }
+            finishWorktreeBlocks(taskGraph, *worktrees, finishedBlocks);
         }
 
-        isBusy = false;
+        // Perform cooldown if enabled and more commands are pending
+        if (taskGraph.remaining() > 0) {
+            prepareStandby(context);  // Usually already running unless the prompt failed
+            if (!isRateLimitEnabled()) {
+                performCooldown();
+            }
+        }
     }
+
+    discardStandby(context);
 }
 
 void printUsage(const char* programName) {
@@ -428,6 +770,17 @@ void printUsage(const char* programName) {
     std::cout << "  --cooldown                     Enable cooldown delay between prompts\n";
     std::cout << "  --no-cooldown                  Disable cooldown delay between prompts\n";
     std::cout << "  --cooldown-seconds <n>         Set cooldown delay duration (default: 60)\n";
+    std::cout << "  --requests-per-minute <n>      Limit requests to each model (replaces the cooldown)\n";
+    std::cout << "  --rate-limit-retries <n>       Backoff retries on a rate-limited model before downgrading\n";
+    std::cout << "  --jobs <n>                     Number of prompts to run in parallel (default: 1)\n";
+    std::cout << "  --isolate-blocks               Run each PromptBlock in its own git worktree\n";
+    std::cout << "  --no-isolate-blocks            Run all PromptBlocks in the current checkout\n";
+    std::cout << "  --adaptive-jobs                Adapt parallel prompts (up to --jobs) to rate limits\n";
+    std::cout << "  --no-adaptive-jobs             Always run --jobs prompts in parallel\n";
+    std::cout << "  --model-routing                Start light prompts on a flash-tier model\n";
+    std::cout << "  --no-model-routing             Start every prompt on the best model\n";
+    std::cout << "  --warm-workers                 Reuse long-lived CLI processes across prompts\n";
+    std::cout << "  --no-warm-workers              Start a new CLI process for every prompt\n";
     std::cout << "  --help                         Show this help message\n\n";
     std::cout << "Precedence: CLI flags > config file > defaults\n\n";
     std::cout << "Examples:\n";
@@ -435,12 +788,29 @@ void printUsage(const char* programName) {
     std::cout << "  " << programName << " --reflect \"Create a todo list\" --iterations 10\n";
     std::cout << "  " << programName << " --auto-commit --commit-prefix \"[AI]\"\n";
     std::cout << "  " << programName << " --cooldown --cooldown-seconds 30\n";
+    std::cout << "  " << programName << " --jobs 4\n";
     std::cout << "  " << programName << " --config ./my-config.txt\n";
 }
 
+#ifndef _WIN32
+// CLI children run in their own process groups, so the terminal's Ctrl-C no longer
+// reaches them. Take them down before dying ourselves.
+extern "C" void terminateChildrenAndExit(int signal) {
+    ProcessExecutor::signalAllProcessGroups(SIGTERM);
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+#endif
+
 int main(int argc, char* argv[]) {
     std::cout << "Welcome to GemStack!" << std::endl;
 
+#ifndef _WIN32
+    std::signal(SIGINT, terminateChildrenAndExit);
+    std::signal(SIGTERM, terminateChildrenAndExit);
+    std::signal(SIGHUP, terminateChildrenAndExit);
+#endif
+
     // Parse command line arguments (first pass to get config path)
     std::string configPath = "GemStackConfig.txt";  // Default
     bool reflectMode = false;
@@ -456,6 +826,27 @@ int main(int argc, char* argv[]) {
     std::optional<bool> cliCooldownEnabled;
     std::optional<int> cliCooldownSeconds;
 
+    // CLI override for the per-model rate limit
+    std::optional<double> cliRequestsPerMinute;
+
+    // CLI override for rate-limit backoff
+    std::optional<int> cliRateLimitRetries;
+
+    // CLI override for parallel workers
+    std::optional<int> cliJobs;
+
+    // CLI override for worktree isolation
+    std::optional<bool> cliWorktreeIsolation;
+
+    // CLI override for warm workers
+    std::optional<bool> cliWarmWorkers;
+
+    // CLI override for adaptive concurrency
+    std::optional<bool> cliAdaptiveJobs;
+
+    // CLI override for model routing
+    std::optional<bool> cliModelRouting;
+
     const int MAX_ITERATIONS = 100;  // Safety cap
 
     for (int i = 1; i < argc; i++) {
@@ -549,6 +940,69 @@ int main(int argc, char* argv[]) {
                 std::cerr << "Error: --cooldown-seconds requires a numeric argument" << std::endl;
                 return 1;
             }
+        } else if (arg == "--requests-per-minute") {
+            if (i + 1 < argc) {
+                try {
+                    double rate = std::stod(argv[++i]);
+                    cliRequestsPerMinute = (rate > 0) ? rate : 0;
+                } catch (...) {
+                    std::cerr << "Error: --requests-per-minute requires a numeric argument" << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --requests-per-minute requires a numeric argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--rate-limit-retries") {
+            if (i + 1 < argc) {
+                try {
+                    int retries = std::stoi(argv[++i]);
+                    cliRateLimitRetries = (retries > 0) ? retries : 0;
+                } catch (...) {
+                    std::cerr << "Error: --rate-limit-retries requires a numeric argument" << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --rate-limit-retries requires a numeric argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--isolate-blocks") {
+            cliWorktreeIsolation = true;
+        } else if (arg == "--no-isolate-blocks") {
+            cliWorktreeIsolation = false;
+        } else if (arg == "--warm-workers") {
+            cliWarmWorkers = true;
+        } else if (arg == "--no-warm-workers") {
+            cliWarmWorkers = false;
+        } else if (arg == "--adaptive-jobs") {
+            cliAdaptiveJobs = true;
+        } else if (arg == "--no-adaptive-jobs") {
+            cliAdaptiveJobs = false;
+        } else if (arg == "--model-routing") {
+            cliModelRouting = true;
+        } else if (arg == "--no-model-routing") {
+            cliModelRouting = false;
+        } else if (arg == "--jobs") {
+            if (i + 1 < argc) {
+                try {
+                    int jobs = std::stoi(argv[++i]);
+                    if (jobs < 1) {
+                        std::cerr << "Error: jobs must be at least 1" << std::endl;
+                        return 1;
+                    }
+                    if (jobs > MAX_JOBS) {
+                        std::cerr << "Error: jobs cannot exceed " << MAX_JOBS << std::endl;
+                        return 1;
+                    }
+                    cliJobs = jobs;
+                } catch (...) {
+                    std::cerr << "Error: --jobs requires a numeric argument" << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Error: --jobs requires a numeric argument" << std::endl;
+                return 1;
+            }
         }
     }
 
@@ -579,11 +1033,77 @@ int main(int argc, char* argv[]) {
         std::cout << "[GemStack] Auto-commit is enabled" << std::endl;
     }
 
+    // Per-model token buckets (CLI > config > default)
+    configureRateLimits(cliRequestsPerMinute);
+
+    // Rate-limit backoff before downgrading (CLI > config > default)
+    if (cliRateLimitRetries) {
+        g_config.rateLimitRetries = *cliRateLimitRetries;
+    }
+
+    // Model list, tiers and routing (CLI > config > default)
+    configureModelRouting(cliModelRouting);
+    if (isModelRoutingEnabled()) {
+        size_t lightIndex = routeModel(PromptWeight::Light);
+        std::cout << "[GemStack] Model routing: light prompts start on " << getModelAt(lightIndex)
+                  << ", heavy prompts on " << getModelAt(routeModel(PromptWeight::Heavy)) << std::endl;
+    }
+
+    // Model health from earlier runs; breakers still open are skipped until they expire
+    g_modelHealth.setPolicy(g_config.modelBreakerFailures, g_config.modelBreakerOpenSeconds);
+    g_modelHealth.load(MODEL_HEALTH_FILENAME);
+    g_modelHealth.setStateFile(MODEL_HEALTH_FILENAME);
+    for (const auto& fallbackModel : modelFallbackList) {
+        ModelHealthRecord health = g_modelHealth.record(fallbackModel);
+        if (health.state == BreakerState::Open) {
+            std::cout << "[GemStack] " << fallbackModel << " was rate limited in an earlier run; circuit open for "
+                      << std::max(0LL, health.openUntil - static_cast<long long>(std::time(nullptr))) << " more seconds"
+                      << std::endl;
+        }
+    }
+
     // Log effective cooldown state
-    if (isCooldownEnabled()) {
+    if (isRateLimitEnabled()) {
+        std::cout << "[GemStack] Rate limiting requests per model"
+                  << (isCooldownEnabled() ? "; the fixed cooldown is skipped" : "") << std::endl;
+    } else if (isCooldownEnabled()) {
         std::cout << "[GemStack] Cooldown is enabled: " << getEffectiveCooldownSeconds() << " seconds between prompts" << std::endl;
     }
 
+    // Resolve worker count (CLI > config > default)
+    int jobs = std::min(cliJobs.value_or(g_config.jobs), MAX_JOBS);
+    if (jobs > 1) {
+        std::cout << "[GemStack] Running " << jobs << " prompts in parallel" << std::endl;
+    }
+
+    // Warm workers (CLI > config > default)
+    if (cliWarmWorkers.value_or(g_config.warmWorkersEnabled) && !CliManager::getWorkerScriptPath().empty()) {
+        std::string workerScript = CliManager::getWorkerScriptPath();
+        g_workerPool = std::make_unique<CliWorkerPool>([workerScript](const std::string& model) {
+            return std::vector<std::string>{"node", workerScript, "--yolo", "--model", model, "prompt"};
+        }, g_config.warmWorkerMaxUses, g_config.warmWorkerMaxMemoryMB);
+        std::cout << "[GemStack] Warm workers enabled; each is recycled after "
+                  << g_config.warmWorkerMaxUses << " prompts" << std::endl;
+    }
+
+    // Admission control for parallel workers
+    AdmissionLimits admissionLimits;
+    admissionLimits.maxLoadPerCpu = g_config.maxLoadPerCpu;
+    admissionLimits.minFreeMemoryMB = g_config.minFreeMemoryMB;
+    admissionLimits.maxRunningChildren = g_config.maxRunningChildren;
+    g_admission.setLimits(admissionLimits);
+    if (g_admission.enabled() && jobs > 1) {
+        std::cout << "[GemStack] Admission control: new prompts wait while the host is saturated" << std::endl;
+    }
+
+    // Adaptive concurrency (CLI > config > default); --jobs becomes the ceiling
+    bool adaptiveJobs = cliAdaptiveJobs.value_or(g_config.adaptiveConcurrency) && jobs > 1;
+    if (adaptiveJobs) {
+        g_admission.enableAdaptiveLimit((jobs + 1) / 2, jobs);
+        std::cout << "[GemStack] Adaptive concurrency: starting with " << g_admission.adaptiveLimit()
+                  << " of " << jobs << " prompts in parallel" << std::endl;
+    }
+
     std::cout << std::endl;
 
     // Instantiate ConsoleUI
@@ -607,36 +1127,47 @@ int main(int argc, char* argv[]) {
     // Normal mode
     std::cout << "Queue commands for Gemini. Type 'exit' to quit." << std::endl;
 
-    // Load commands from file
-    bool fileCommandsLoaded = loadCommandsFromFile("GemStackQueue.txt");
+    // Load tasks from file and build the dependency graph
+    TaskGraph taskGraph;
+    std::vector<TaskSpec> fileTasks;
+    bool fileCommandsLoaded = loadTasksFromFile("GemStackQueue.txt", fileTasks);
+    taskGraph.addTasks(fileTasks);
 
     // Set total task count for progress display
-    {
-        std::lock_guard<std::mutex> lock(queueMutex);
-        // Update ConsoleUI with total tasks
-        ui.setTotalTasks(static_cast<int>(commandQueue.size()));
-    }
+    ui.setTotalTasks(static_cast<int>(taskGraph.size()));
     // Note: ConsoleUI initialized with current=0 by default
 
-    // Start worker thread, passing UI instance
-    std::thread workerThread([&ui]() { worker(ui); });
+    // Optional worktree isolation for PromptBlocks
+    std::unique_ptr<WorktreeManager> worktrees;
+    if (cliWorktreeIsolation.value_or(g_config.worktreeIsolation)) {
+        worktrees = std::make_unique<WorktreeManager>(".", parseWorktreeMergeStrategy(g_config.worktreeMergeStrategy));
+        if (worktrees->initialize()) {
+            // Tasks that wait on a block start only once it is merged, so they see its changes
+            taskGraph.holdBlockDependents(true);
+            worktrees->setBlocks(taskGraph.blockOrder());
+            std::cout << "[GemStack] Worktree isolation enabled; blocks merge into "
+                      << worktrees->getBaseBranch() << " in order" << std::endl;
+        } else {
+            worktrees.reset();
+        }
+    }
+
+    // Start worker pool, passing UI instance
+    ui.setWorkerSlots(jobs);
+    if (adaptiveJobs) {
+        ui.setConcurrencyLimit(g_admission.adaptiveLimit());
+        g_admission.setLimitListener([&ui](int limit) { ui.setConcurrencyLimit(limit); });
+    }
+    std::vector<std::thread> workerThreads;
+    for (int workerId = 1; workerId <= jobs; workerId++) {
+        workerThreads.emplace_back([&taskGraph, &ui, workerId, &worktrees]() {
+            worker(taskGraph, ui, workerId, worktrees.get());
+        });
+    }
 
     if (fileCommandsLoaded) {
-        // Accessing commandQueue via mutex to check size is redundant as ui has it, 
-        // but ui.totalTasks is atomic.
-        // We can just print a message.
         std::cout << "[GemStack] Processing tasks in batch mode..." << std::endl;
-        while (true) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            bool empty;
-            {
-                std::lock_guard<std::mutex> lock(queueMutex);
-                empty = commandQueue.empty();
-            }
-            if (empty && !isBusy) {
-                break;
-            }
-        }
+        taskGraph.waitUntilIdle();
     } else {
         std::string line;
         while (true) {
@@ -646,6 +1177,14 @@ int main(int argc, char* argv[]) {
             }
 
             if (line == "exit" || line == "quit") {
+                // Stop now: end every wait and drop prompts that have not started.
+                // Prompts already running finish.
+                requestShutdown();
+                g_admission.cancel();
+                size_t dropped = taskGraph.cancelPending();
+                if (dropped > 0) {
+                    std::cout << "[GemStack] Stopping; " << dropped << " queued prompt(s) not started." << std::endl;
+                }
                 break;
             }
 
@@ -653,47 +1192,44 @@ int main(int argc, char* argv[]) {
                 continue;
             }
 
-            {
-                std::lock_guard<std::mutex> lock(queueMutex);
-                commandQueue.push(line);
-                // Update total tasks count in UI for correct progress display
-                // Need to get current total and add 1
-                // But ConsoleUI only has setTotalTasks.
-                // We should probably expose addTasks or something.
-                // For now, re-set it.
-                // Wait, commandQueue.size() includes the new one.
-                // Total tasks tracked by UI should ideally increase.
-                // But totalTasks in ConsoleUI is just for display "x/Total".
-                // If we are in interactive mode, Total keeps growing?
-                // The original code:
-                /*
-                {
-                    std::lock_guard<std::mutex> lock(queueMutex);
-                    commandQueue.push(line);
-                }
-                */
-                // It DID NOT update totalTasks in interactive loop in original code!
-                // So original code showed [x/InitTotal] ?
-                // Original: `totalTasks` was atomic global. Set once before worker start.
-                // Never updated in interactive loop.
-                // So interactive commands showed [1/0], [2/0]?
-                // I will replicate existing behavior or improve it. 
-                // Since I cannot change ConsoleUI API in this file easily without rewriting header, 
-                // I'll stick to existing behavior (no update).
-            }
-            queueCV.notify_one();
+            // Interactive commands have no dependencies and run as soon as a worker is free
+            taskGraph.addTask(line);
             std::cout << "[GemStack] Command queued." << std::endl;
+            // A command typed now is wanted now: end any worker's idle cooldown
+            wakeIdleWaits();
+        }
+    }
+
+    // Workers finish what is already queued (at end of input), then exit
+    taskGraph.close();
+
+    for (auto& workerThread : workerThreads) {
+        if (workerThread.joinable()) {
+            workerThread.join();
         }
     }
 
-    {
-        std::lock_guard<std::mutex> lock(queueMutex);
-        running = false;
+    if (adaptiveJobs) {
+        g_admission.setLimitListener(nullptr);
+        std::cout << "[GemStack] Adaptive concurrency: ended at " << g_admission.adaptiveLimit()
+                  << " parallel prompts (peak " << g_admission.peakAdaptiveLimit() << ", cut "
+                  << g_admission.adaptiveCuts() << " times on rate limits)" << std::endl;
+    }
+
+    // What routing learned about each model this run
+    for (const auto& model : modelFallbackList) {
+        ModelStats stats = getModelStats(model);
+        if (stats.successes + stats.failures > 0) {
+            std::cout << "[GemStack] " << model << ": " << stats.successes << " succeeded, " << stats.failures
+                      << " failed, " << static_cast<int>(stats.meanLatencySeconds) << "s average" << std::endl;
+        }
     }
-    queueCV.notify_all();
 
-    if (workerThread.joinable()) {
-        workerThread.join();
+    SessionContextStats context = getSessionContextStats();
+    if (context.sentBytes < context.logBytes) {
+        uint64_t saved = context.logBytes - context.sentBytes;
+        std::cout << "[GemStack] Session context: " << saved / 1024 << " KB (~" << estimateTokens(saved)
+                  << " tokens) of session history left out of " << context.prompts << " prompts" << std::endl;
     }
 
     std::cout << "Goodbye!" << std::endl;
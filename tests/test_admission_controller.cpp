@@ -0,0 +1,319 @@
+#include <gtest/gtest.h>
+#include <AdmissionController.h>
+#include <GemStackCore.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// A host whose load the test controls
+class FakeHost {
+public:
+    HostProbe probe() {
+        return [this]() {
+            HostLoad load;
+            load.loadAverage = loadAverage.load();
+            load.cpuCount = 4;
+            load.availableMemoryMB = availableMemoryMB.load();
+            return load;
+        };
+    }
+
+    std::atomic<double> loadAverage{1.0};
+    std::atomic<long long> availableMemoryMB{8192};
+};
+
+static AdmissionLimits limits(double maxLoadPerCpu, int minFreeMemoryMB, int maxRunningChildren) {
+    AdmissionLimits result;
+    result.maxLoadPerCpu = maxLoadPerCpu;
+    result.minFreeMemoryMB = minFreeMemoryMB;
+    result.maxRunningChildren = maxRunningChildren;
+    return result;
+}
+
+// acquire() if it would admit at once; false instead of waiting on a saturated host
+static bool acquireIfAdmitted(AdmissionController& admission, FakeHost& host) {
+    if (!admission.saturationReason(host.probe()()).empty()) {
+        return false;
+    }
+    admission.acquire();
+    return true;
+}
+
+TEST(AdmissionControllerTest, NoLimitsAdmitsEverything) {
+    FakeHost host;
+    host.loadAverage = 100;
+    host.availableMemoryMB = 1;
+    AdmissionController admission({}, host.probe());
+    EXPECT_FALSE(admission.enabled());
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(acquireIfAdmitted(admission, host));
+    }
+    EXPECT_EQ(admission.running(), 10);
+}
+
+TEST(AdmissionControllerTest, ChildLimit) {
+    FakeHost host;
+    AdmissionController admission(limits(0, 0, 2), host.probe());
+    EXPECT_TRUE(acquireIfAdmitted(admission, host));
+    EXPECT_TRUE(acquireIfAdmitted(admission, host));
+    EXPECT_FALSE(acquireIfAdmitted(admission, host));
+    admission.release();
+    EXPECT_TRUE(acquireIfAdmitted(admission, host));
+}
+
+TEST(AdmissionControllerTest, LoadLimitIsPerCpu) {
+    FakeHost host;
+    AdmissionController admission(limits(1.5, 0, 0), host.probe());
+    ASSERT_TRUE(acquireIfAdmitted(admission, host));
+
+    host.loadAverage = 5.9;  // 1.475 per CPU
+    EXPECT_TRUE(acquireIfAdmitted(admission, host));
+    host.loadAverage = 6.5;  // 1.625 per CPU
+    EXPECT_FALSE(acquireIfAdmitted(admission, host));
+    EXPECT_EQ(admission.saturationReason(host.probe()()), "load average 6.5 on 4 CPUs");
+}
+
+TEST(AdmissionControllerTest, MemoryFloor) {
+    FakeHost host;
+    AdmissionController admission(limits(0, 1024, 0), host.probe());
+    ASSERT_TRUE(acquireIfAdmitted(admission, host));
+
+    host.availableMemoryMB = 512;
+    EXPECT_FALSE(acquireIfAdmitted(admission, host));
+    EXPECT_EQ(admission.saturationReason(host.probe()()), "512 MB of memory available");
+    host.availableMemoryMB = 2048;
+    EXPECT_TRUE(acquireIfAdmitted(admission, host));
+}
+
+TEST(AdmissionControllerTest, UnknownReadingsNeverBlock) {
+    FakeHost host;
+    host.loadAverage = -1;
+    host.availableMemoryMB = -1;
+    AdmissionController admission(limits(0.5, 1024, 0), host.probe());
+    EXPECT_TRUE(acquireIfAdmitted(admission, host));
+    EXPECT_TRUE(acquireIfAdmitted(admission, host));
+}
+
+TEST(AdmissionControllerTest, FirstPromptAlwaysAdmitted) {
+    // Other users keep the host busy; we still make progress one prompt at a time
+    FakeHost host;
+    host.loadAverage = 100;
+    AdmissionController admission(limits(1.0, 0, 0), host.probe());
+    EXPECT_TRUE(acquireIfAdmitted(admission, host));
+    EXPECT_FALSE(acquireIfAdmitted(admission, host));
+    admission.release();
+    EXPECT_TRUE(acquireIfAdmitted(admission, host));
+}
+
+TEST(AdmissionControllerTest, WaiterAdmittedOnRelease) {
+    FakeHost host;
+    AdmissionController admission(limits(0, 0, 1), host.probe());
+    admission.setPollInterval(std::chrono::seconds(30));  // Only a release can wake it in time
+    admission.acquire();
+
+    std::atomic<bool> admitted{false};
+    std::thread waiter([&]() {
+        admission.acquire();
+        admitted = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(admitted);
+
+    auto start = std::chrono::steady_clock::now();
+    admission.release();
+    waiter.join();
+    EXPECT_TRUE(admitted);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    EXPECT_EQ(admission.running(), 1);
+}
+
+TEST(AdmissionControllerTest, CancelEndsWaitingAcquire) {
+    FakeHost host;
+    AdmissionController admission(limits(0, 0, 1), host.probe());
+    admission.setPollInterval(std::chrono::seconds(30));  // Only cancel() can end it in time
+    ASSERT_TRUE(admission.acquire());
+
+    std::atomic<bool> returned{false};
+    std::optional<uint64_t> window = 0;
+    std::thread waiter([&]() {
+        window = admission.acquire();
+        returned = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(returned);
+
+    auto start = std::chrono::steady_clock::now();
+    admission.cancel();
+    waiter.join();
+    EXPECT_FALSE(window.has_value());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    EXPECT_EQ(admission.running(), 1);
+
+    // Later calls return at once, even with headroom, until reset()
+    admission.release();
+    EXPECT_FALSE(admission.acquire().has_value());
+    EXPECT_EQ(admission.running(), 0);
+    admission.reset();
+    EXPECT_TRUE(admission.acquire().has_value());
+    EXPECT_EQ(admission.running(), 1);
+}
+
+TEST(AdmissionControllerTest, WaiterAdmittedWhenLoadDrops) {
+    FakeHost host;
+    AdmissionController admission(limits(1.0, 0, 0), host.probe());
+    admission.setPollInterval(std::chrono::milliseconds(20));
+    admission.acquire();
+    host.loadAverage = 20;
+
+    std::atomic<bool> admitted{false};
+    std::thread waiter([&]() {
+        admission.acquire();
+        admitted = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(admitted);
+
+    host.loadAverage = 2;
+    waiter.join();
+    EXPECT_TRUE(admitted);
+    EXPECT_EQ(admission.running(), 2);
+}
+
+TEST(AdmissionControllerTest, AdaptiveLimitCapsRunningPrompts) {
+    FakeHost host;
+    AdmissionController admission({}, host.probe());
+    EXPECT_EQ(admission.adaptiveLimit(), 0);
+    admission.enableAdaptiveLimit(2, 8);
+    EXPECT_TRUE(admission.enabled());
+    EXPECT_EQ(admission.adaptiveLimit(), 2);
+
+    EXPECT_TRUE(acquireIfAdmitted(admission, host));
+    EXPECT_TRUE(acquireIfAdmitted(admission, host));
+    EXPECT_FALSE(acquireIfAdmitted(admission, host));
+    EXPECT_EQ(admission.saturationReason(host.probe()()), "adaptive limit of 2 prompts reached");
+}
+
+TEST(AdmissionControllerTest, AdditiveIncreaseOncePerWindow) {
+    FakeHost host;
+    AdmissionController admission({}, host.probe());
+    admission.enableAdaptiveLimit(2, 4);
+    std::vector<int> changes;
+    admission.setLimitListener([&](int limit) { changes.push_back(limit); });
+
+    // One more slot after 'limit' successes: 2 to reach 3, then 3 to reach 4
+    admission.recordSuccess();
+    EXPECT_EQ(admission.adaptiveLimit(), 2);
+    admission.recordSuccess();
+    EXPECT_EQ(admission.adaptiveLimit(), 3);
+    for (int i = 0; i < 3; i++) {
+        admission.recordSuccess();
+    }
+    EXPECT_EQ(admission.adaptiveLimit(), 4);
+
+    // Never past the ceiling
+    for (int i = 0; i < 20; i++) {
+        admission.recordSuccess();
+    }
+    EXPECT_EQ(admission.adaptiveLimit(), 4);
+    EXPECT_EQ(admission.peakAdaptiveLimit(), 4);
+    EXPECT_EQ(changes, (std::vector<int>{3, 4}));
+}
+
+TEST(AdmissionControllerTest, MultiplicativeDecreaseOncePerWindow) {
+    FakeHost host;
+    AdmissionController admission({}, host.probe());
+    admission.enableAdaptiveLimit(8, 8);
+
+    // Four prompts launched together all hit the same quota wall
+    std::vector<uint64_t> windows;
+    for (int i = 0; i < 4; i++) {
+        windows.push_back(admission.acquire().value());
+    }
+    EXPECT_TRUE(admission.recordRateLimit(windows[0]));
+    for (int i = 1; i < 4; i++) {
+        EXPECT_FALSE(admission.recordRateLimit(windows[i]));
+    }
+    EXPECT_EQ(admission.adaptiveLimit(), 4);
+    EXPECT_EQ(admission.adaptiveCuts(), 1);
+
+    // A prompt admitted after the cut that is still rate limited cuts again, down to one
+    for (int i = 0; i < 4; i++) {
+        admission.release();
+    }
+    EXPECT_TRUE(admission.recordRateLimit(admission.acquire().value()));
+    EXPECT_EQ(admission.adaptiveLimit(), 2);
+    admission.release();
+    EXPECT_TRUE(admission.recordRateLimit(admission.acquire().value()));
+    admission.release();
+    EXPECT_TRUE(admission.recordRateLimit(admission.acquire().value()));
+    EXPECT_EQ(admission.adaptiveLimit(), 1);
+    EXPECT_EQ(admission.adaptiveCuts(), 4);
+}
+
+TEST(AdmissionControllerTest, FeedbackIgnoredWhenNotAdaptive) {
+    FakeHost host;
+    AdmissionController admission({}, host.probe());
+    uint64_t window = admission.acquire().value();
+    EXPECT_FALSE(admission.recordRateLimit(window));
+    admission.recordSuccess();
+    EXPECT_EQ(admission.adaptiveLimit(), 0);
+    EXPECT_EQ(admission.adaptiveCuts(), 0);
+}
+
+TEST(AdmissionControllerTest, WaiterAdmittedWhenLimitGrows) {
+    FakeHost host;
+    AdmissionController admission({}, host.probe());
+    admission.setPollInterval(std::chrono::seconds(30));  // Only the increase can wake it in time
+    admission.enableAdaptiveLimit(1, 2);
+    admission.acquire();
+
+    std::atomic<bool> admitted{false};
+    std::thread waiter([&]() {
+        admission.acquire();
+        admitted = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(admitted);
+
+    admission.recordSuccess();
+    waiter.join();
+    EXPECT_TRUE(admitted);
+    EXPECT_EQ(admission.running(), 2);
+}
+
+#ifdef __linux__
+TEST(AdmissionControllerTest, ReadsHostLoad) {
+    HostLoad load = readHostLoad();
+    EXPECT_GE(load.loadAverage, 0);
+    EXPECT_GT(load.availableMemoryMB, 0);
+    EXPECT_GE(load.cpuCount, 1);
+}
+#endif
+
+TEST(AdmissionControllerTest, ConfigKeys) {
+    std::string filename = "test_admission_config.txt";
+    std::ofstream file(filename);
+    file << "maxLoadPerCpu=1.5\n";
+    file << "min_free_memory_mb=2048\n";
+    file << "max_running_children=3\n";
+    file << "adaptive_concurrency=yes\n";
+    file.close();
+
+    g_config = getDefaultConfig();
+    EXPECT_EQ(g_config.maxLoadPerCpu, 0);
+    EXPECT_EQ(g_config.minFreeMemoryMB, 0);
+    EXPECT_EQ(g_config.maxRunningChildren, 0);
+    EXPECT_FALSE(g_config.adaptiveConcurrency);
+
+    EXPECT_TRUE(loadConfig(filename));
+    EXPECT_DOUBLE_EQ(g_config.maxLoadPerCpu, 1.5);
+    EXPECT_EQ(g_config.minFreeMemoryMB, 2048);
+    EXPECT_EQ(g_config.maxRunningChildren, 3);
+    EXPECT_TRUE(g_config.adaptiveConcurrency);
+
+    g_config = getDefaultConfig();
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,340 @@
+#include <gtest/gtest.h>
+#include <CliWorkerPool.h>
+#include <CliManager.h>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#ifndef _WIN32
+// Speaks the warm worker protocol like gemstack-worker.mjs does. It reports its pid, model
+// and use count so tests can tell fresh workers from reused ones; a few magic inputs
+// make it fail, crash, hang or print a rate-limit error.
+static const char* STUB_WORKER = R"SH(
+echo '@@GEMSTACK_READY@@'
+uses=0
+while read -r tag cwdlen inputlen; do
+    [ "$tag" = GEMSTACK_REQUEST ] || exit 3
+    cwd=$(head -c "$cwdlen")
+    input=$(head -c "$inputlen")
+    uses=$((uses + 1))
+    code=0
+    rss=50000000
+    case "$input" in
+        crash) exit 9 ;;
+        hang) printf working; sleep 30 ;;
+        ratelimit) echo 'Error code: 429'; sleep 30 ;;
+        fail|chatty) code=5 ;;
+        bloat) rss=3000000000 ;;
+        warn) echo 'Error code: 429 (retrying)' >&2 ;;
+        ratelimit-stderr) echo 'Error code: 429' >&2; sleep 30 ;;
+    esac
+    printf 'pid=%s model=%s uses=%s cwd=%s input=%s' "$$" "$1" "$uses" "$cwd" "$input"
+    printf '\n@@GEMSTACK_DONE %s %s@@\n' "$code" "$rss"
+    [ "$input" = chatty ] && echo 'printed between requests' && echo 'on stderr too' >&2
+done
+)SH";
+
+static CliWorkerPool::WorkerCommand stubCommand() {
+    return [](const std::string& model) {
+        return std::vector<std::string>{"sh", "-c", STUB_WORKER, "stub", model};
+    };
+}
+
+static ProcessOptions request(const std::string& input) {
+    ProcessOptions options;
+    options.echoOutput = false;
+    options.stdinData = input;
+    options.killGracePeriod = std::chrono::milliseconds(200);
+    return options;
+}
+
+// "pid=123 model=..." -> "123"
+static std::string field(const std::string& output, const std::string& name) {
+    size_t start = output.find(name + "=");
+    if (start == std::string::npos) {
+        return "";
+    }
+    start += name.size() + 1;
+    return output.substr(start, output.find(' ', start) - start);
+}
+
+TEST(CliWorkerPoolTest, ReusesWorkerAcrossRequests) {
+    CliWorkerPool pool(stubCommand());
+    std::optional<ProcessResult> first = pool.run("model-a", request("hello"));
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->exitCode, 0);
+    EXPECT_EQ(field(first->output, "input"), "hello");
+    EXPECT_EQ(field(first->output, "uses"), "1");
+    EXPECT_EQ(pool.idleCount("model-a"), 1u);
+
+    std::optional<ProcessResult> second = pool.run("model-a", request("again"));
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(field(second->output, "pid"), field(first->output, "pid"));
+    EXPECT_EQ(field(second->output, "uses"), "2");
+    EXPECT_EQ(field(second->output, "input"), "again");
+}
+
+TEST(CliWorkerPoolTest, TerminatorIsNotPartOfOutput) {
+    CliWorkerPool pool(stubCommand());
+    std::optional<ProcessResult> result = pool.run("model-a", request("x"));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->output.find("GEMSTACK"), std::string::npos);
+    EXPECT_EQ(result->output.back(), 'x');  // The framing newline is stripped too
+}
+
+TEST(CliWorkerPoolTest, RecyclesAfterMaxUses) {
+    CliWorkerPool pool(stubCommand(), 2);
+    std::string firstPid = field(pool.run("model-a", request("1"))->output, "pid");
+    std::optional<ProcessResult> second = pool.run("model-a", request("2"));
+    EXPECT_EQ(field(second->output, "pid"), firstPid);
+    EXPECT_EQ(pool.idleCount("model-a"), 0u);  // Retired after its second request
+
+    std::optional<ProcessResult> third = pool.run("model-a", request("3"));
+    ASSERT_TRUE(third.has_value());
+    EXPECT_NE(field(third->output, "pid"), firstPid);
+    EXPECT_EQ(field(third->output, "uses"), "1");
+}
+
+TEST(CliWorkerPoolTest, RecyclesWhenMemoryGrows) {
+    CliWorkerPool pool(stubCommand(), 20, 1024);
+    std::string firstPid = field(pool.run("model-a", request("1"))->output, "pid");
+    EXPECT_EQ(pool.idleCount("model-a"), 1u);  // 50 MB is within the limit
+
+    std::optional<ProcessResult> bloated = pool.run("model-a", request("bloat"));
+    ASSERT_TRUE(bloated.has_value());
+    EXPECT_EQ(bloated->exitCode, 0);
+    EXPECT_EQ(field(bloated->output, "pid"), firstPid);
+    EXPECT_EQ(pool.idleCount("model-a"), 0u);  // Retired after reporting 3 GB
+
+    std::optional<ProcessResult> next = pool.run("model-a", request("3"));
+    ASSERT_TRUE(next.has_value());
+    EXPECT_NE(field(next->output, "pid"), firstPid);
+}
+
+TEST(CliWorkerPoolTest, OutputBetweenRequestsIsDropped) {
+    CliWorkerPool pool(stubCommand());
+    ASSERT_TRUE(pool.run("model-a", request("chatty")).has_value());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    ProcessOptions options = request("next");
+    options.mergeStderr = false;
+    std::optional<ProcessResult> next = pool.run("model-a", options);
+    ASSERT_TRUE(next.has_value());
+    EXPECT_EQ(next->output.find("between requests"), std::string::npos);
+    EXPECT_EQ(next->errorOutput.find("stderr too"), std::string::npos);
+    EXPECT_EQ(field(next->output, "input"), "next");
+}
+
+TEST(CliWorkerPoolTest, OneWorkerPerModel) {
+    CliWorkerPool pool(stubCommand());
+    std::optional<ProcessResult> a = pool.run("model-a", request("x"));
+    std::optional<ProcessResult> b = pool.run("model-b", request("x"));
+    ASSERT_TRUE(a.has_value() && b.has_value());
+    EXPECT_EQ(field(a->output, "model"), "model-a");
+    EXPECT_EQ(field(b->output, "model"), "model-b");
+    EXPECT_NE(field(a->output, "pid"), field(b->output, "pid"));
+    EXPECT_EQ(pool.idleCount(), 2u);
+
+    pool.shutdown();
+    EXPECT_EQ(pool.idleCount(), 0u);
+}
+
+TEST(CliWorkerPoolTest, SendsAbsoluteWorkingDirAndExitCode) {
+    CliWorkerPool pool(stubCommand());
+    ProcessOptions options = request("fail");
+    options.workingDir = ".";
+    std::optional<ProcessResult> result = pool.run("model-a", options);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result->exitCode, 5);
+    EXPECT_EQ(field(result->output, "cwd"), std::filesystem::current_path().string());
+    // A failed prompt doesn't make the worker unusable
+    EXPECT_EQ(pool.idleCount("model-a"), 1u);
+}
+
+TEST(CliWorkerPoolTest, WorkerDyingSilentlyFallsBack) {
+    CliWorkerPool pool(stubCommand());
+    EXPECT_FALSE(pool.run("model-a", request("crash")).has_value());
+    EXPECT_EQ(pool.idleCount("model-a"), 0u);
+
+    // A replacement is started for the next request
+    std::optional<ProcessResult> result = pool.run("model-a", request("ok"));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(field(result->output, "uses"), "1");
+}
+
+TEST(CliWorkerPoolTest, TimeoutKillsWorker) {
+    CliWorkerPool pool(stubCommand());
+    ProcessOptions options = request("hang");
+    options.timeout = std::chrono::milliseconds(300);
+
+    auto start = std::chrono::steady_clock::now();
+    std::optional<ProcessResult> result = pool.run("model-a", options);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->timedOut);
+    EXPECT_EQ(result->output, "working");
+    EXPECT_EQ(pool.idleCount("model-a"), 0u);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(CliWorkerPoolTest, LineObserverStopsWorker) {
+    CliWorkerPool pool(stubCommand());
+    ProcessOptions options = request("ratelimit");
+    options.lineObserver = [](const std::string& line) { return line != "Error code: 429"; };
+
+    auto start = std::chrono::steady_clock::now();
+    std::optional<ProcessResult> result = pool.run("model-a", options);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->stoppedByObserver);
+    EXPECT_EQ(pool.idleCount("model-a"), 0u);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(CliWorkerPoolTest, StderrKeptApartOrMerged) {
+    CliWorkerPool pool(stubCommand());
+    ProcessOptions options = request("warn");
+    options.mergeStderr = false;
+    std::optional<ProcessResult> separate = pool.run("model-a", options);
+    ASSERT_TRUE(separate.has_value());
+    EXPECT_EQ(separate->errorOutput, "Error code: 429 (retrying)\n");
+    EXPECT_EQ(separate->output.find("429"), std::string::npos);
+    EXPECT_EQ(field(separate->output, "input"), "warn");
+
+    // Same worker, merged this time
+    std::optional<ProcessResult> merged = pool.run("model-a", request("warn"));
+    ASSERT_TRUE(merged.has_value());
+    EXPECT_EQ(field(merged->output, "pid"), field(separate->output, "pid"));
+    EXPECT_NE(merged->output.find("Error code: 429"), std::string::npos);
+    EXPECT_TRUE(merged->errorOutput.empty());
+}
+
+TEST(CliWorkerPoolTest, ErrorLineObserverStopsWorker) {
+    CliWorkerPool pool(stubCommand());
+    ProcessOptions options = request("ratelimit-stderr");
+    options.mergeStderr = false;
+    options.errorLineObserver = [](const std::string& line) { return line != "Error code: 429"; };
+
+    auto start = std::chrono::steady_clock::now();
+    std::optional<ProcessResult> result = pool.run("model-a", options);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result->stoppedByObserver);
+    EXPECT_EQ(pool.idleCount("model-a"), 0u);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(CliWorkerPoolTest, FailedStartBacksOff) {
+    int starts = 0;
+    bool broken = true;
+    CliWorkerPool pool([&](const std::string& model) {
+        starts++;
+        return broken ? std::vector<std::string>{"nonexistent_command_12345"}
+                      : stubCommand()(model);
+    });
+    pool.setStartRetryDelay(std::chrono::milliseconds(200));
+    EXPECT_FALSE(pool.run("model-a", request("x")).has_value());
+    EXPECT_FALSE(pool.run("model-a", request("x")).has_value());
+    EXPECT_EQ(starts, 1);  // Not retried right away
+
+    // Tried again once the delay has passed; a second failure waits twice as long
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    EXPECT_FALSE(pool.run("model-a", request("x")).has_value());
+    EXPECT_EQ(starts, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    EXPECT_FALSE(pool.run("model-a", request("x")).has_value());
+    EXPECT_EQ(starts, 2);
+
+    // A transient failure doesn't keep warm workers off for good
+    broken = false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    std::optional<ProcessResult> result = pool.run("model-a", request("x"));
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(field(result->output, "input"), "x");
+    EXPECT_EQ(starts, 3);
+}
+
+TEST(CliWorkerPoolTest, WorkerThatNeverBecomesReady) {
+    CliWorkerPool pool([](const std::string&) {
+        return std::vector<std::string>{"sh", "-c", "echo booting; sleep 30"};
+    });
+    pool.setStartupTimeout(std::chrono::milliseconds(300));
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(pool.run("model-a", request("x")).has_value());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+// Stands in for gemini.js behind the real gemstack-worker.mjs: ends a run by exiting,
+// by letting its work drain, or by exiting with a timer left behind that fires later
+static const char* FAKE_CLI = R"JS(export {};
+let input = '';
+process.stdin.on('data', (chunk) => { input += chunk; });
+process.stdin.on('end', () => {
+  const command = input.trim();
+  if (command === 'exit') {
+    process.stdout.write('answer');
+    process.exit(3);
+  } else if (command === 'drain') {
+    setTimeout(() => {
+      process.stdout.write('drained');
+      process.exitCode = 4;
+    }, 50);
+  } else if (command === 'stale') {
+    setTimeout(() => {
+      process.stdout.write('late');
+      process.exit(9);
+    }, 300);
+    process.stdout.write('leaving');
+    process.exit(0);
+  } else if (command === 'slow') {
+    setTimeout(() => {
+      process.stdout.write('slow done');
+      process.exit(2);
+    }, 600);
+  }
+});
+)JS";
+
+TEST(CliWorkerPoolTest, NodeWorkerScriptEndsEachRunOnItsOwn) {
+    if (system("node --version >/dev/null 2>&1") != 0) {
+        GTEST_SKIP() << "node not available";
+    }
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "gemstack_worker_script_test";
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "gemini.js") << FAKE_CLI;
+    std::string script = (dir / "gemstack-worker.mjs").string();
+    ASSERT_TRUE(CliManager::writeWorkerScript(script));
+
+    CliWorkerPool pool([script](const std::string&) {
+        return std::vector<std::string>{"node", script};
+    });
+    // A run that never ends fails the test instead of hanging it
+    auto bounded = [](const std::string& input) {
+        ProcessOptions options = request(input);
+        options.timeout = std::chrono::seconds(10);
+        return options;
+    };
+    std::optional<ProcessResult> exited = pool.run("model-a", bounded("exit"));
+    ASSERT_TRUE(exited.has_value());
+    EXPECT_EQ(exited->exitCode, 3);
+    EXPECT_EQ(exited->output, "answer");
+
+    // No process.exit: the run ends once nothing it started is pending, as the process would
+    std::optional<ProcessResult> drained = pool.run("model-a", bounded("drain"));
+    ASSERT_TRUE(drained.has_value());
+    EXPECT_EQ(drained->exitCode, 4);
+    EXPECT_EQ(drained->output, "drained");
+
+    // A timer left by one run fires during the next: its exit and output are ignored
+    std::optional<ProcessResult> stale = pool.run("model-a", bounded("stale"));
+    ASSERT_TRUE(stale.has_value());
+    EXPECT_EQ(stale->output, "leaving");
+    std::optional<ProcessResult> slow = pool.run("model-a", bounded("slow"));
+    ASSERT_TRUE(slow.has_value());
+    EXPECT_EQ(slow->exitCode, 2);
+    EXPECT_EQ(slow->output, "slow done");
+    EXPECT_EQ(pool.idleCount("model-a"), 1u);
+
+    pool.shutdown();
+    std::filesystem::remove_all(dir);
+}
+#endif
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <ExhaustionMatcher.h>
+#include <GemStackCore.h>
+#include <string>
+#include <vector>
+
+// Rate-limit and quota errors as the Gemini CLI and API print them
+static const std::vector<std::string> kExhaustedCorpus = {
+    "Error: rate limit exceeded",
+    "RATE_LIMIT_EXCEEDED",
+    "Rate-limited by the server; backing off",
+    "quota exceeded for today",
+    "Quota exceeded for quota metric 'Generate Content API requests per minute'",
+    "You exceeded your current quota, please check your plan and billing details.",
+    "RESOURCE_EXHAUSTED",
+    "[GoogleGenerativeAI Error]: Resource exhausted. Please try again later.",
+    "Too Many Requests",
+    "Error code: 429",
+    "HTTP 429",
+    "got status 429 from generativelanguage.googleapis.com",
+    R"({"error":{"code":429,"message":"Please slow down","status":"UNAVAILABLE"}})",
+    "{\n  \"error\": {\n    \"code\": 429,\n    \"status\": \"UNAVAILABLE\"\n  }\n}",
+    "Request failed with status code 429",
+    "Attempt 1 failed with status 429. Retrying with backoff...",
+    "Request failed with status code 429.",
+    "HTTP 429.",
+    "Rate limit hit, retry in 5s",
+    "Your daily usage limit reached for gemini-2.5-pro",
+    "Model capacity exhausted, try a different model",
+};
+
+// Ordinary agent and tool output that mentions the same words or numbers
+static const std::vector<std::string> kBenignCorpus = {
+    "Command completed successfully",
+    "File created",
+    "",
+    "The rate of change is high",
+    "src/main.cpp:429:12: error: expected ';' before '}' token",
+    "error at line 429: unexpected token",
+    "Error: assertion failed at Line 429",
+    "Processed 1429 files in 3.2s",
+    "Listening on port 4290",
+    "Wrote 429 bytes",
+    "Status: 12 files changed, 429 insertions(+), 17 deletions(-)",
+    "Read 0x429 from the register",
+    "Using version 4.29.0",
+    "Test-429 passed",
+    "The iterator is exhausted after the last element",
+    "All retries exhausted for the flaky integration test",
+    "Maximum recursion limit reached while parsing the tree",
+    "Search space exhausted; no solution found",
+    "Added a daily backup job",
+    "Added rate limit middleware to the Express API",
+    "Implemented a rate-limiting decorator in utils/throttle.py",
+    "Bumped the API client to 1.429.0",
+};
+
+TEST(ExhaustionMatcherTest, DetectsExhaustionCorpus) {
+    for (const auto& text : kExhaustedCorpus) {
+        EXPECT_TRUE(isModelExhausted(text)) << text;
+    }
+}
+
+TEST(ExhaustionMatcherTest, NoFalsePositivesInAgentOutput) {
+    for (const auto& text : kBenignCorpus) {
+        EXPECT_FALSE(isModelExhausted(text)) << text;
+    }
+}
+
+TEST(ExhaustionMatcherTest, CaseInsensitive) {
+    EXPECT_TRUE(isModelExhausted("RATE LIMIT EXCEEDED"));
+    EXPECT_TRUE(isModelExhausted("Quota Exceeded"));
+    EXPECT_TRUE(isModelExhausted("too MANY requests"));
+}
+
+TEST(ExhaustionMatcherTest, ContextMustBeOnTheSameLine) {
+    // The status word and the number are on different lines of unrelated output
+    EXPECT_FALSE(isModelExhausted("Error: build failed\nCompiled 429 objects"));
+    EXPECT_FALSE(isModelExhausted("quota.cpp updated\nthe cache is exhausted"));
+    EXPECT_TRUE(isModelExhausted("Compiled 12 objects\nHTTP error 429"));
+}
+
+TEST(ExhaustionMatcherTest, OverlappingPatterns) {
+    // "resource_exhausted" also contains "resource" and "exhausted"; one hit is enough
+    EXPECT_EQ(exhaustionMatcher().classify("RESOURCE_EXHAUSTED"), ExhaustionKind::RateLimit);
+    // A match at the very end of the input
+    EXPECT_EQ(exhaustionMatcher().classify("status 429"), ExhaustionKind::RateLimit);
+    EXPECT_EQ(exhaustionMatcher().classify("429 status"), ExhaustionKind::RateLimit);
+}
+
+TEST(ExhaustionMatcherTest, ClassifiesDailyQuota) {
+    const ExhaustionMatcher& matcher = exhaustionMatcher();
+    EXPECT_EQ(matcher.classify("Quota exceeded: GenerateRequestsPerDayPerProjectPerModel"), ExhaustionKind::DailyQuota);
+    // The daily marker may come before the error, on another line
+    EXPECT_EQ(matcher.classify("Daily limit for this project\nError 429"), ExhaustionKind::DailyQuota);
+    EXPECT_EQ(matcher.classify("Error 429, requests per minute"), ExhaustionKind::RateLimit);
+    // "daily" alone is not an error
+    EXPECT_EQ(matcher.classify("Added a daily backup job"), ExhaustionKind::None);
+}
+
+TEST(ExhaustionMatcherTest, FindsErrorInLargeOutput) {
+    std::string output;
+    for (int i = 0; i < 20000; i++) {
+        output += "src/file" + std::to_string(i) + ".cpp:429: note: processed line 429 of the exhausted iterator\n";
+    }
+    EXPECT_FALSE(isModelExhausted(output));
+    output += "Error: 429 Too Many Requests\n";
+    EXPECT_TRUE(isModelExhausted(output));
+}
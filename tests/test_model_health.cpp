@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <ModelHealth.h>
+#include <GemStackCore.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+using namespace std::chrono_literals;
+
+// Wall clock the test moves by hand
+class FakeWallClock {
+public:
+    ModelHealthTable::ClockFunction function() {
+        return [this]() { return now; };
+    }
+
+    ModelHealthTable::Clock::time_point now = ModelHealthTable::Clock::time_point() + 1000000s;
+};
+
+static const std::vector<std::string> kModels = {"pro", "flash", "lite"};
+
+TEST(ModelHealthTest, UnknownModelsAreClosed) {
+    FakeWallClock clock;
+    ModelHealthTable health(3, 600, clock.function());
+    EXPECT_TRUE(health.allows("pro"));
+    EXPECT_EQ(health.record("pro").state, BreakerState::Closed);
+    EXPECT_EQ(health.selectModel(kModels, 0), 0u);
+}
+
+TEST(ModelHealthTest, OpensAfterThresholdAndIsSkipped) {
+    FakeWallClock clock;
+    ModelHealthTable health(3, 600, clock.function());
+    health.recordExhausted("pro");
+    health.recordExhausted("pro");
+    EXPECT_TRUE(health.allows("pro"));
+    health.recordExhausted("pro");
+
+    ModelHealthRecord record = health.record("pro");
+    EXPECT_EQ(record.state, BreakerState::Open);
+    EXPECT_EQ(record.recentFailures, 3);
+    EXPECT_FALSE(health.allows("pro"));
+    EXPECT_EQ(health.selectModel(kModels, 0), 1u);
+}
+
+TEST(ModelHealthTest, OldFailuresAreForgotten) {
+    FakeWallClock clock;
+    ModelHealthTable health(3, 600, clock.function());
+    health.recordExhausted("pro");
+    health.recordExhausted("pro");
+    clock.now += 601s;
+    health.recordExhausted("pro");
+    EXPECT_EQ(health.record("pro").recentFailures, 1);
+    EXPECT_EQ(health.record("pro").state, BreakerState::Closed);
+}
+
+TEST(ModelHealthTest, SuccessResetsFailures) {
+    FakeWallClock clock;
+    ModelHealthTable health(2, 600, clock.function());
+    health.recordExhausted("pro");
+    health.recordSuccess("pro");
+    health.recordExhausted("pro");
+    EXPECT_EQ(health.record("pro").state, BreakerState::Closed);
+}
+
+TEST(ModelHealthTest, HalfOpenAllowsOneProbe) {
+    FakeWallClock clock;
+    ModelHealthTable health(1, 600, clock.function());
+    health.recordExhausted("pro");
+    EXPECT_FALSE(health.allows("pro"));
+
+    clock.now += 600s;
+    EXPECT_TRUE(health.allows("pro"));  // The probe
+    EXPECT_EQ(health.record("pro").state, BreakerState::HalfOpen);
+    EXPECT_FALSE(health.allows("pro"));  // Everyone else waits for its verdict
+    EXPECT_EQ(health.selectModel(kModels, 0), 1u);
+
+    // A timeout says nothing about the quota; the next caller probes instead
+    health.recordOtherFailure("pro");
+    EXPECT_TRUE(health.allows("pro"));
+
+    health.recordSuccess("pro");
+    EXPECT_EQ(health.record("pro").state, BreakerState::Closed);
+    EXPECT_TRUE(health.allows("pro"));
+    EXPECT_TRUE(health.allows("pro"));
+}
+
+TEST(ModelHealthTest, FailedProbeReopens) {
+    FakeWallClock clock;
+    ModelHealthTable health(3, 600, clock.function());
+    for (int i = 0; i < 3; i++) {
+        health.recordExhausted("pro");
+    }
+    clock.now += 600s;
+    ASSERT_TRUE(health.allows("pro"));
+
+    // One failure is enough for a probe
+    health.recordExhausted("pro");
+    EXPECT_EQ(health.record("pro").state, BreakerState::Open);
+    EXPECT_FALSE(health.allows("pro"));
+}
+
+TEST(ModelHealthTest, RetryTimeOpensUntilThen) {
+    FakeWallClock clock;
+    ModelHealthTable health(3, 600, clock.function());
+    long long now = std::chrono::duration_cast<std::chrono::seconds>(clock.now.time_since_epoch()).count();
+
+    // One error with a reset time is enough, and sets the exact reopening time
+    health.recordExhaustedUntil("pro", now + 45);
+    EXPECT_EQ(health.record("pro").state, BreakerState::Open);
+    EXPECT_EQ(health.record("pro").openUntil, now + 45);
+    clock.now += 44s;
+    EXPECT_FALSE(health.allows("pro"));
+    clock.now += 1s;
+    EXPECT_TRUE(health.allows("pro"));
+}
+
+TEST(ModelHealthTest, AllOpenFallsBackToLastModel) {
+    FakeWallClock clock;
+    ModelHealthTable health(1, 600, clock.function());
+    for (const auto& model : kModels) {
+        health.recordExhausted(model);
+    }
+    EXPECT_EQ(health.selectModel(kModels, 0), 2u);
+}
+
+TEST(ModelHealthTest, PersistsAcrossRuns) {
+    std::string path = "test_model_health_state.txt";
+    std::remove(path.c_str());
+    FakeWallClock clock;
+    {
+        ModelHealthTable health(1, 3600, clock.function());
+        health.setStateFile(path);
+        health.recordExhausted("pro");
+        health.recordExhausted("flash");
+        health.recordSuccess("flash");
+    }
+
+    // A restarted GemStack still skips the exhausted model
+    clock.now += 60s;
+    ModelHealthTable restarted(1, 3600, clock.function());
+    ASSERT_TRUE(restarted.load(path));
+    EXPECT_EQ(restarted.record("pro").state, BreakerState::Open);
+    EXPECT_EQ(restarted.record("flash").state, BreakerState::Closed);
+    EXPECT_EQ(restarted.selectModel(kModels, 0), 1u);
+
+    // ...until the open period is over
+    clock.now += 3600s;
+    EXPECT_EQ(restarted.selectModel(kModels, 0), 0u);
+
+    std::remove(path.c_str());
+}
+
+TEST(ModelHealthTest, MissingStateFile) {
+    ModelHealthTable health;
+    EXPECT_FALSE(health.load("no_such_model_health_file.txt"));
+    EXPECT_TRUE(health.allows("pro"));
+}
+
+TEST(ModelHealthTest, ConfigKeys) {
+    std::string filename = "test_model_health_config.txt";
+    std::ofstream file(filename);
+    file << "model_breaker_failures=5\n";
+    file << "modelBreakerOpenSeconds=2h\n";
+    file.close();
+
+    g_config = getDefaultConfig();
+    EXPECT_EQ(g_config.modelBreakerFailures, 3);
+    EXPECT_EQ(g_config.modelBreakerOpenSeconds, 1800);
+    EXPECT_TRUE(loadConfig(filename));
+    EXPECT_EQ(g_config.modelBreakerFailures, 5);
+    EXPECT_EQ(g_config.modelBreakerOpenSeconds, 7200);
+
+    g_config = getDefaultConfig();
+    std::remove(filename.c_str());
+}
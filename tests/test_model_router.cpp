@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include <ModelRouter.h>
+#include <GemStackCore.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+static const std::vector<std::string> kModels = {
+    "gemini-3-pro-preview", "gemini-3-flash-preview", "gemini-2.5-pro", "gemini-2.0-flash"
+};
+
+TEST(ModelRouterTest, TiersFromNames) {
+    EXPECT_EQ(defaultModelTier("gemini-2.5-pro"), ModelTier::Pro);
+    EXPECT_EQ(defaultModelTier("gemini-2.5-flash"), ModelTier::Flash);
+    EXPECT_EQ(defaultModelTier("gemini-2.5-flash-lite"), ModelTier::Flash);
+
+    ModelTier tier = ModelTier::Pro;
+    EXPECT_TRUE(parseModelTier("Flash", tier));
+    EXPECT_EQ(tier, ModelTier::Flash);
+    EXPECT_TRUE(parseModelTier("pro", tier));
+    EXPECT_EQ(tier, ModelTier::Pro);
+    EXPECT_FALSE(parseModelTier("ultra", tier));
+}
+
+TEST(ModelRouterTest, ClassifiesPromptWeight) {
+    EXPECT_EQ(classifyPromptWeight("List the files you changed", 200), PromptWeight::Light);
+    EXPECT_EQ(classifyPromptWeight(std::string(300, 'x'), 200), PromptWeight::Heavy);
+    // Length limit 0: nothing is light by length
+    EXPECT_EQ(classifyPromptWeight("Fix it", 0), PromptWeight::Heavy);
+
+    // A long checkpoint preamble doesn't make a short task heavy...
+    std::string checkpoint = "CHECKPOINT - Before proceeding, verify the following expectations are met:\n";
+    checkpoint += "  1. " + std::string(400, 'y') + "\n\n";
+    EXPECT_EQ(classifyPromptWeight(checkpoint + "After verification is complete, proceed with the following task:\nAdd a test",
+                                   200), PromptWeight::Light);
+    // ...nor a short preamble a long task light
+    EXPECT_EQ(classifyPromptWeight("GOAL - A game\n\nCURRENT TASK:\n" + std::string(300, 'z'), 200),
+              PromptWeight::Heavy);
+}
+
+TEST(ModelRouterTest, RoutesByTier) {
+    ModelRouter router;
+    router.configure(kModels);
+    EXPECT_EQ(router.route(PromptWeight::Heavy), 0u);
+    EXPECT_EQ(router.route(PromptWeight::Light), 1u);
+}
+
+TEST(ModelRouterTest, ConfiguredTiersOverrideNames) {
+    ModelRouter router;
+    router.configure({"flash-first", "big-model", "small-model"},
+                     {{"small-model", ModelTier::Flash}});
+    EXPECT_EQ(router.tierOf("flash-first"), ModelTier::Flash);
+    EXPECT_EQ(router.tierOf("small-model"), ModelTier::Flash);
+    // Heavy prompts skip a flash model at the head of the list
+    EXPECT_EQ(router.route(PromptWeight::Heavy), 1u);
+    EXPECT_EQ(router.route(PromptWeight::Light), 0u);
+}
+
+TEST(ModelRouterTest, NoFlashModelRoutesEverythingToPro) {
+    ModelRouter router;
+    router.configure({"gemini-2.5-pro", "gemini-1.5-pro"});
+    EXPECT_EQ(router.route(PromptWeight::Light), 0u);
+}
+
+TEST(ModelRouterTest, TracksLatencyAndSuccess) {
+    ModelRouter router;
+    router.configure(kModels);
+    router.recordOutcome("gemini-3-flash-preview", true, 10);
+    router.recordOutcome("gemini-3-flash-preview", true, 20);
+    router.recordOutcome("gemini-3-flash-preview", false, 1);
+
+    ModelStats stats = router.stats("gemini-3-flash-preview");
+    EXPECT_EQ(stats.successes, 2);
+    EXPECT_EQ(stats.failures, 1);
+    EXPECT_DOUBLE_EQ(stats.meanLatencySeconds, 13);  // 10 + 0.3 * (20 - 10); failures don't count
+    EXPECT_DOUBLE_EQ(stats.successRate(), 0.6);
+}
+
+TEST(ModelRouterTest, FasterFlashModelTakesOverOnceProven) {
+    ModelRouter router;
+    router.configure(kModels);
+    for (int i = 0; i < ModelRouter::MIN_SAMPLES; i++) {
+        router.recordOutcome("gemini-3-flash-preview", true, 60);
+        router.recordOutcome("gemini-2.0-flash", true, 60);
+    }
+    // Equal history: list order wins
+    EXPECT_EQ(router.route(PromptWeight::Light), 1u);
+
+    for (int i = 0; i < 10; i++) {
+        router.recordOutcome("gemini-2.0-flash", true, 10);
+    }
+    EXPECT_EQ(router.route(PromptWeight::Light), 3u);
+    // Heavy prompts never leave the pro tier for speed
+    EXPECT_EQ(router.route(PromptWeight::Heavy), 0u);
+}
+
+TEST(ModelRouterTest, FailingFlashModelIsPassedOver) {
+    ModelRouter router;
+    router.configure(kModels);
+    for (int i = 0; i < 4; i++) {
+        router.recordOutcome("gemini-3-flash-preview", false, 1);
+    }
+    // The next flash model has no history yet, but anything beats one that keeps failing
+    EXPECT_EQ(router.route(PromptWeight::Light), 3u);
+}
+
+TEST(ModelRouterTest, UnprovenModelsDontMoveRouting) {
+    ModelRouter router;
+    router.configure(kModels);
+    router.recordOutcome("gemini-3-flash-preview", true, 100);
+    router.recordOutcome("gemini-2.0-flash", true, 1);
+    EXPECT_EQ(router.route(PromptWeight::Light), 1u);
+}
+
+class ModelRoutingConfigTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        g_config = getDefaultConfig();
+        configureModelRouting();
+    }
+
+    void TearDown() override {
+        g_config = getDefaultConfig();
+        configureModelRouting();
+    }
+};
+
+TEST_F(ModelRoutingConfigTest, DefaultsToBuiltInList) {
+    // Opt-in: without it every prompt keeps starting on the best model
+    EXPECT_FALSE(isModelRoutingEnabled());
+    ASSERT_FALSE(modelFallbackList.empty());
+    EXPECT_EQ(modelFallbackList[0], "gemini-3-pro-preview");
+    EXPECT_EQ(getModelAt(routeModel(PromptWeight::Light)), "gemini-3-flash-preview");
+    EXPECT_EQ(getPromptWeight(std::string(1000, 'x'), true), PromptWeight::Light);
+    EXPECT_EQ(getPromptWeight(std::string(1000, 'x')), PromptWeight::Heavy);
+}
+
+TEST_F(ModelRoutingConfigTest, ConfigKeys) {
+    std::string filename = "test_model_routing_config.txt";
+    std::ofstream file(filename);
+    file << "models=gemini-2.5-pro, gemini-2.5-flash-lite ,gemini-2.5-flash\n";
+    file << "modelTier.gemini-2.5-flash=pro\n";
+    file << "model_tier.gemini-2.5-pro=bogus\n";
+    file << "route_short_prompt_chars=50\n";
+    file << "modelRouting=yes\n";
+    file.close();
+
+    EXPECT_TRUE(loadConfig(filename));
+    ASSERT_EQ(g_config.models.size(), 3u);
+    EXPECT_EQ(g_config.models[1], "gemini-2.5-flash-lite");
+    EXPECT_EQ(g_config.modelTiers.size(), 1u);
+    EXPECT_EQ(g_config.modelTiers["gemini-2.5-flash"], ModelTier::Pro);
+    EXPECT_EQ(g_config.routeShortPromptChars, 50);
+    EXPECT_TRUE(g_config.modelRouting);
+
+    configureModelRouting();
+    EXPECT_EQ(modelFallbackList, g_config.models);
+    EXPECT_TRUE(isModelRoutingEnabled());
+    EXPECT_EQ(routeModel(PromptWeight::Light), 1u);
+    EXPECT_EQ(getPromptWeight(std::string(60, 'x')), PromptWeight::Heavy);
+
+    // The CLI flag wins over the config
+    configureModelRouting(false);
+    EXPECT_FALSE(isModelRoutingEnabled());
+
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <OutputBuffer.h>
+#include <ProcessExecutor.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+static std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+TEST(OutputBufferTest, UnlimitedKeepsEverything) {
+    OutputBuffer buffer;
+    buffer.append("hello ");
+    buffer.append(std::string(100000, 'x'));
+    EXPECT_FALSE(buffer.spilled());
+    EXPECT_EQ(buffer.size(), 100006u);
+    EXPECT_EQ(buffer.str(), "hello " + std::string(100000, 'x'));
+    EXPECT_TRUE(buffer.spillPath().empty());
+}
+
+TEST(OutputBufferTest, UnderLimitStaysInMemory) {
+    OutputBuffer buffer(16);
+    buffer.append("0123456789abcdef");
+    EXPECT_FALSE(buffer.spilled());
+    EXPECT_EQ(buffer.take(), "0123456789abcdef");
+}
+
+TEST(OutputBufferTest, SpillKeepsHeadAndTail) {
+    std::string everything;
+    std::string spillPath;
+    {
+        OutputBuffer buffer(10);
+        for (char c = 'a'; c <= 'z'; c++) {
+            buffer.append(std::string(1, c));
+            everything += c;
+        }
+        ASSERT_TRUE(buffer.spilled());
+        EXPECT_EQ(buffer.size(), 26u);
+        EXPECT_EQ(buffer.head(), "abcde");
+        EXPECT_EQ(buffer.tail(), "vwxyz");
+
+        spillPath = buffer.spillPath();
+        ASSERT_FALSE(spillPath.empty());
+        std::string text = buffer.str();
+        EXPECT_EQ(text.substr(0, 5), "abcde");
+        EXPECT_EQ(text.substr(text.size() - 5), "vwxyz");
+        EXPECT_NE(text.find("output omitted; full output in " + spillPath), std::string::npos);
+    }
+    // Nobody asked to keep it
+    EXPECT_FALSE(std::filesystem::exists(spillPath));
+}
+
+TEST(OutputBufferTest, SpillFileHoldsEverything) {
+    OutputBuffer buffer(10);
+    std::string everything;
+    for (int i = 0; i < 1000; i++) {
+        std::string chunk = "line " + std::to_string(i) + "\n";
+        buffer.append(chunk);
+        everything += chunk;
+    }
+    buffer.keepSpillFile();
+    EXPECT_EQ(readFile(buffer.spillPath()), everything);
+    std::filesystem::remove(buffer.spillPath());
+}
+
+TEST(OutputBufferTest, DeletesSpillFileByDefault) {
+    std::string spillPath;
+    {
+        OutputBuffer buffer(4);
+        buffer.append("0123456789");
+        spillPath = buffer.spillPath();
+        ASSERT_TRUE(std::filesystem::exists(spillPath));
+    }
+    EXPECT_FALSE(std::filesystem::exists(spillPath));
+}
+
+TEST(OutputBufferTest, LargeChunkFillsHeadAndReplacesTail) {
+    OutputBuffer buffer(8);
+    buffer.append("abc");
+    buffer.append(std::string(50, '-') + "WXYZ");
+    EXPECT_EQ(buffer.head(), "abc-");
+    EXPECT_EQ(buffer.tail(), "WXYZ");
+    EXPECT_EQ(buffer.size(), 57u);
+}
+
+TEST(OutputBufferTest, NoteHasNoDigits) {
+    // The retained text is scanned for error codes like "429"; the note mustn't add any
+    OutputBuffer buffer(4);
+    buffer.append(std::string(5000, 'x'));
+    std::string text = buffer.str();
+    std::string note = text.substr(2, text.size() - 4);
+    EXPECT_EQ(note.find_first_of("0123456789"), std::string::npos) << note;
+}
+
+TEST(OutputBufferTest, KeptSpillFileSurvives) {
+    std::string spillPath;
+    {
+        OutputBuffer buffer(4);
+        buffer.append("0123456789");
+        buffer.keepSpillFile();
+        spillPath = buffer.spillPath();
+    }
+    ASSERT_TRUE(std::filesystem::exists(spillPath));
+    EXPECT_EQ(readFile(spillPath), "0123456789");
+    std::filesystem::remove(spillPath);
+}
+
+TEST(OutputBufferTest, MovedBufferOwnsSpillFile) {
+    OutputBuffer source(4);
+    source.append("0123456789");
+    std::string spillPath = source.spillPath();
+    {
+        OutputBuffer moved(std::move(source));
+        EXPECT_EQ(moved.spillPath(), spillPath);
+    }
+    EXPECT_FALSE(std::filesystem::exists(spillPath));
+}
+
+TEST(LineDispatcherTest, JoinsLinesAcrossChunks) {
+    std::vector<std::string> lines;
+    LineDispatcher dispatcher([&lines](const std::string& line) {
+        lines.push_back(line);
+        return true;
+    });
+    dispatcher.dispatch("first li");
+    dispatcher.dispatch("ne\r\nsecond\nthi");
+    dispatcher.dispatch("rd");
+    EXPECT_EQ(lines, (std::vector<std::string>{"first line", "second"}));
+    dispatcher.finish();
+    EXPECT_EQ(lines, (std::vector<std::string>{"first line", "second", "third"}));
+}
+
+TEST(LineDispatcherTest, StopsWhenObserverSaysSo) {
+    int calls = 0;
+    LineDispatcher dispatcher([&calls](const std::string& line) {
+        calls++;
+        return line != "stop";
+    });
+    EXPECT_FALSE(dispatcher.dispatch("go\nstop\nmore\n"));
+    EXPECT_TRUE(dispatcher.stopped());
+    EXPECT_EQ(calls, 2);
+    EXPECT_FALSE(dispatcher.dispatch("again\n"));
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(LineDispatcherTest, OverlongLineIsCapped) {
+    std::vector<size_t> lengths;
+    LineDispatcher dispatcher([&lengths](const std::string& line) {
+        lengths.push_back(line.size());
+        return true;
+    });
+    dispatcher.dispatch(std::string(LineDispatcher::MAX_LINE_LENGTH * 3, 'x'));
+    dispatcher.dispatch("\nshort\n");
+    ASSERT_FALSE(lengths.empty());
+    for (size_t length : lengths) {
+        EXPECT_LE(length, LineDispatcher::MAX_LINE_LENGTH);
+    }
+    EXPECT_EQ(lengths.back(), 5u);
+}
+
+#ifndef _WIN32
+TEST(OutputBufferTest, ExecutorSpillsLargeOutput) {
+    ProcessOptions options;
+    options.echoOutput = false;
+    options.outputMemoryLimit = 64 * 1024;
+    ProcessResult result = ProcessExecutor::execute(
+        {"sh", "-c", "echo start; head -c 1000000 /dev/zero | tr '\\0' x; echo; echo end"}, options);
+
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.outputSize, 1000011u);
+    EXPECT_LT(result.output.size(), 70u * 1024);
+    EXPECT_EQ(result.output.substr(0, 6), "start\n");
+    EXPECT_EQ(result.output.substr(result.output.size() - 4), "end\n");
+
+    // The caller owns the complete copy
+    ASSERT_FALSE(result.spillPath.empty());
+    EXPECT_EQ(std::filesystem::file_size(result.spillPath), 1000011u);
+    std::filesystem::remove(result.spillPath);
+}
+
+TEST(OutputBufferTest, ExecutorWithoutLimitDoesNotSpill) {
+    ProcessOptions options;
+    options.echoOutput = false;
+    ProcessResult result = ProcessExecutor::execute({"sh", "-c", "head -c 200000 /dev/zero"}, options);
+    EXPECT_EQ(result.output.size(), 200000u);
+    EXPECT_EQ(result.outputSize, 200000u);
+    EXPECT_TRUE(result.spillPath.empty());
+}
+#endif
@@ -431,6 +431,27 @@ TEST(SecurityUtilities, EscapeForShellNewlines) {
     EXPECT_EQ(escapeForShell("line1\rline2"), "line1 line2");
 }
 
+TEST(SecurityUtilities, SplitCommandArgumentsWhitespace) {
+    std::vector<std::string> expected = {"--version"};
+    EXPECT_EQ(splitCommandArguments("  --version  "), expected);
+
+    expected = {"a", "b", "c"};
+    EXPECT_EQ(splitCommandArguments("a \tb\n c"), expected);
+
+    EXPECT_TRUE(splitCommandArguments("   ").empty());
+}
+
+TEST(SecurityUtilities, SplitCommandArgumentsQuotes) {
+    std::vector<std::string> expected = {"prompt", "hello world; $HOME"};
+    EXPECT_EQ(splitCommandArguments("prompt \"hello world; $HOME\""), expected);
+
+    expected = {"say", "it's \"ok\""};
+    EXPECT_EQ(splitCommandArguments("say \"it's \\\"ok\\\"\""), expected);
+
+    expected = {"a b", ""};
+    EXPECT_EQ(splitCommandArguments("'a b' ''"), expected);
+}
+
 // ============================================================================
 // Model Management Tests
 // ============================================================================
@@ -472,6 +493,94 @@ TEST(ModelManagement, ResetModelToTop) {
     EXPECT_EQ(getCurrentModel(), modelFallbackList[0]);
 }
 
+TEST(ModelManagement, PerWorkerDowngradeLeavesGlobalUntouched) {
+    resetModelToTop();
+
+    size_t workerIndex = 0;
+    EXPECT_TRUE(downgradeModel(workerIndex));
+    EXPECT_EQ(workerIndex, 1u);
+    EXPECT_EQ(getModelAt(workerIndex), modelFallbackList[1]);
+
+    // Global fallback state is independent of the worker's index
+    EXPECT_EQ(getCurrentModel(), modelFallbackList[0]);
+}
+
+TEST(ModelManagement, GetModelAtClampsToLastModel) {
+    EXPECT_EQ(getModelAt(modelFallbackList.size() + 5), modelFallbackList.back());
+}
+
+TEST(ModelManagement, RepromotesAfterWindow) {
+    g_config = getDefaultConfig();
+    g_config.modelRepromoteSeconds = 600;
+    auto now = std::chrono::steady_clock::now();
+
+    size_t workerIndex = 0;
+    ModelPromotionState promotion;
+    EXPECT_FALSE(maybePromoteModel(workerIndex, promotion, now));  // Already at the top
+
+    ASSERT_TRUE(downgradeModel(workerIndex));
+    noteModelDowngraded(promotion, now);
+    EXPECT_FALSE(maybePromoteModel(workerIndex, promotion, now + std::chrono::seconds(599)));
+    EXPECT_EQ(workerIndex, 1u);
+
+    // Window passed: probe the better model, and stay there when it succeeds
+    now += std::chrono::seconds(600);
+    EXPECT_TRUE(maybePromoteModel(workerIndex, promotion, now));
+    EXPECT_EQ(workerIndex, 0u);
+    EXPECT_TRUE(promotion.probing);
+    noteModelSucceeded(workerIndex, promotion, now);
+    EXPECT_FALSE(promotion.probing);
+    EXPECT_EQ(workerIndex, 0u);
+
+    g_config = getDefaultConfig();
+}
+
+TEST(ModelManagement, FailedProbeWaitsAnotherWindow) {
+    g_config = getDefaultConfig();
+    g_config.modelRepromoteSeconds = 600;
+    auto now = std::chrono::steady_clock::now();
+
+    size_t workerIndex = 1;
+    ModelPromotionState promotion;
+    noteModelDowngraded(promotion, now);
+    now += std::chrono::seconds(600);
+    ASSERT_TRUE(maybePromoteModel(workerIndex, promotion, now));
+
+    // Still limited: back down, and no new probe until a full window later
+    ASSERT_TRUE(downgradeModel(workerIndex));
+    noteModelDowngraded(promotion, now);
+    EXPECT_FALSE(promotion.probing);
+    EXPECT_FALSE(maybePromoteModel(workerIndex, promotion, now + std::chrono::seconds(300)));
+    EXPECT_TRUE(maybePromoteModel(workerIndex, promotion, now + std::chrono::seconds(600)));
+
+    g_config = getDefaultConfig();
+}
+
+TEST(ModelManagement, RepromotionDisabled) {
+    g_config = getDefaultConfig();
+    g_config.modelRepromoteSeconds = 0;
+    size_t workerIndex = 2;
+    ModelPromotionState promotion;
+    EXPECT_FALSE(maybePromoteModel(workerIndex, promotion, std::chrono::steady_clock::now() + std::chrono::hours(24)));
+    EXPECT_EQ(workerIndex, 2u);
+    g_config = getDefaultConfig();
+}
+
+TEST(ModelManagement, RepromoteConfigKey) {
+    std::string filename = "test_repromote_config.txt";
+    std::ofstream file(filename);
+    file << "model_repromote_seconds=30m\n";
+    file.close();
+
+    g_config = getDefaultConfig();
+    EXPECT_EQ(g_config.modelRepromoteSeconds, 900);
+    EXPECT_TRUE(loadConfig(filename));
+    EXPECT_EQ(g_config.modelRepromoteSeconds, 1800);
+
+    g_config = getDefaultConfig();
+    std::remove(filename.c_str());
+}
+
 // ============================================================================
 // Rate Limit Detection Tests
 // ============================================================================
@@ -492,6 +601,68 @@ TEST(RateLimitDetection, NoFalsePositives) {
     EXPECT_FALSE(isModelExhausted("The rate of change is high"));
 }
 
+TEST(RateLimitDetection, ExhaustedRunNeedsFailureAndStderr) {
+    EXPECT_TRUE(classifyExhaustedRun(1, "Error: RESOURCE_EXHAUSTED").exhausted());
+    EXPECT_TRUE(classifyExhaustedRun(137, "Error code: 429").exhausted());
+    // A successful run that printed a quota warning still succeeded
+    EXPECT_FALSE(classifyExhaustedRun(0, "Quota exceeded, retrying with backoff").exhausted());
+    EXPECT_FALSE(classifyExhaustedRun(1, "TypeError: cannot read properties of undefined").exhausted());
+    EXPECT_FALSE(classifyExhaustedRun(1, "").exhausted());
+}
+
+TEST(RateLimitDetection, ParsesRetryDelays) {
+    EXPECT_EQ(parseRetryAfterSeconds(R"({"@type": "type.googleapis.com/google.rpc.RetryInfo", "retryDelay": "37s"})"), 37);
+    EXPECT_EQ(parseRetryAfterSeconds("Please retry in 12.4s."), 13);
+    EXPECT_EQ(parseRetryAfterSeconds("Too many requests, try again in 1m30s"), 90);
+    EXPECT_EQ(parseRetryAfterSeconds("Retry-After: 20"), 20);
+    EXPECT_EQ(parseRetryAfterSeconds("Your quota will reset after 2h5m."), 7500);
+    EXPECT_EQ(parseRetryAfterSeconds("retry after 500ms"), 1);
+    EXPECT_EQ(parseRetryAfterSeconds("try again in 2 minutes"), 120);
+    EXPECT_EQ(parseRetryAfterSeconds("Error code: 429"), -1);
+    EXPECT_EQ(parseRetryAfterSeconds("Please retry in a moment"), -1);
+}
+
+TEST(RateLimitDetection, ClassifiesExhaustion) {
+    // Only models on the list are recognized by name
+    g_config.models = {"gemini-2.5-pro", "gemini-2.5-flash"};
+    configureModelRouting();
+
+    ExhaustionInfo info = classifyExhaustion(
+        "Error: 429 RESOURCE_EXHAUSTED: Quota exceeded for metric generate_content_requests_per_minute, "
+        "model: gemini-2.5-pro. Please retry in 41.2s.");
+    EXPECT_TRUE(info.exhausted());
+    EXPECT_EQ(info.kind, ExhaustionKind::RateLimit);
+    EXPECT_EQ(info.retryAfterSeconds, 42);
+    EXPECT_EQ(info.model, "gemini-2.5-pro");
+
+    info = classifyExhaustion("Quota exceeded: GenerateRequestsPerDayPerProjectPerModel for gemini-2.5-flash");
+    EXPECT_EQ(info.kind, ExhaustionKind::DailyQuota);
+    EXPECT_EQ(info.retryAfterSeconds, -1);
+    EXPECT_EQ(info.model, "gemini-2.5-flash");
+
+    // A file name that merely starts like a model is not one
+    info = classifyExhaustion(
+        "Attempt 3 failed with status 429. Retrying with backoff...\n"
+        "Error when talking to Gemini API Full report available at: "
+        "/tmp/gemini-client-error-Turn.run-sendMessageStream-2025-10-16T10-30-00-123Z.json");
+    EXPECT_TRUE(info.exhausted());
+    EXPECT_EQ(info.model, "");
+    info = classifyExhaustion("Full report available at: /tmp/gemini-client-error-x.json\n"
+                              "Quota exceeded for model gemini-2.5-flash.");
+    EXPECT_EQ(info.model, "gemini-2.5-flash");
+
+    info = classifyExhaustion("TypeError: cannot read properties of undefined");
+    EXPECT_FALSE(info.exhausted());
+    EXPECT_EQ(info.kind, ExhaustionKind::None);
+
+    // A successful run is never exhausted, whatever stderr said
+    EXPECT_FALSE(classifyExhaustedRun(0, "rate limit hit, retry in 5s").exhausted());
+    EXPECT_EQ(classifyExhaustedRun(1, "rate limit hit, retry in 5s").retryAfterSeconds, 5);
+
+    g_config = getDefaultConfig();
+    configureModelRouting();
+}
+
 // ============================================================================
 // Output Parsing Tests
 // ============================================================================
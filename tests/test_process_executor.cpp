@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include <ProcessExecutor.h>
+#include <fstream>
+#include <cstdio>
+#include <chrono>
 
 TEST(ProcessExecutorTest, EchoCommand) {
     // Basic test to verify command execution works
@@ -20,3 +23,230 @@ TEST(ProcessExecutorTest, InvalidCommand) {
     // Exit code should be non-zero
     EXPECT_NE(result.first, 0);
 }
+
+#ifndef _WIN32
+TEST(ProcessExecutorTest, ArgvPassedVerbatim) {
+    // Shell metacharacters reach the child untouched because no shell is involved
+    std::vector<std::string> argv = {"printf", "%s|%s", "a b; $HOME", "`x` \"q\""};
+    ProcessResult result = ProcessExecutor::execute(argv);
+
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output, "a b; $HOME|`x` \"q\"");
+}
+
+TEST(ProcessExecutorTest, ArgvCapturesLargeOutput) {
+    // Several MB, well past the pipe buffer and the initial capture buffer
+    ProcessOptions options;
+    options.echoOutput = false;
+    std::vector<std::string> argv = {"sh", "-c", "yes 0123456789abcdef | head -c 6000000"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_EQ(result.exitCode, 0);
+    ASSERT_EQ(result.output.size(), 6000000u);
+    EXPECT_EQ(result.output.substr(0, 17), "0123456789abcdef\n");
+    // 6000000 = 352941 full lines + "012"
+    EXPECT_EQ(result.output.substr(5999980), "0123456789abcdef\n012");
+}
+
+TEST(ProcessExecutorTest, ArgvNoEcho) {
+    ProcessOptions options;
+    options.echoOutput = false;
+    std::vector<std::string> argv = {"printf", "quiet"};
+
+    testing::internal::CaptureStdout();
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+    std::string echoed = testing::internal::GetCapturedStdout();
+
+    EXPECT_EQ(result.output, "quiet");
+    EXPECT_TRUE(echoed.empty());
+}
+
+TEST(ProcessExecutorTest, ArgvExitCode) {
+    std::vector<std::string> argv = {"sh", "-c", "exit 3"};
+    EXPECT_EQ(ProcessExecutor::execute(argv).exitCode, 3);
+}
+
+TEST(ProcessExecutorTest, ArgvNotFound) {
+    std::vector<std::string> argv = {"nonexistent_command_12345"};
+    EXPECT_EQ(ProcessExecutor::execute(argv).exitCode, 127);
+}
+
+TEST(ProcessExecutorTest, ArgvCapturesStderr) {
+    std::vector<std::string> argv = {"sh", "-c", "echo out; echo err 1>&2"};
+    ProcessResult result = ProcessExecutor::execute(argv);
+
+    EXPECT_NE(result.output.find("out"), std::string::npos);
+    EXPECT_NE(result.output.find("err"), std::string::npos);
+    EXPECT_TRUE(result.errorOutput.empty());
+}
+
+TEST(ProcessExecutorTest, ArgvSeparateStderr) {
+    ProcessOptions options;
+    options.echoOutput = false;
+    options.mergeStderr = false;
+    std::vector<std::string> argv = {"sh", "-c", "echo out; echo err 1>&2; echo more; exit 3"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_EQ(result.exitCode, 3);
+    EXPECT_EQ(result.output, "out\nmore\n");
+    EXPECT_EQ(result.errorOutput, "err\n");
+}
+
+TEST(ProcessExecutorTest, ArgvSeparateStderrLargeOnBothPipes) {
+    // Both pipes overflow their kernel buffers; neither may stall the other
+    ProcessOptions options;
+    options.echoOutput = false;
+    options.mergeStderr = false;
+    std::vector<std::string> argv = {"sh", "-c", "head -c 300000 /dev/zero >&2; head -c 300000 /dev/zero; head -c 300000 /dev/zero >&2"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_EQ(result.output.size(), 300000u);
+    EXPECT_EQ(result.errorOutput.size(), 600000u);
+}
+
+TEST(ProcessExecutorTest, ArgvWorkingDirectory) {
+    ProcessOptions options;
+    options.workingDir = "/";
+    std::vector<std::string> argv = {"pwd"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output, "/\n");
+}
+
+TEST(ProcessExecutorTest, ArgvEnvironment) {
+    ProcessOptions options;
+    options.environment = {"GEMSTACK_TEST_VALUE=42", "PATH=/usr/bin:/bin"};
+    std::vector<std::string> argv = {"sh", "-c", "printf %s \"$GEMSTACK_TEST_VALUE\""};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output, "42");
+}
+
+TEST(ProcessExecutorTest, ArgvStdinFile) {
+    std::string path = "process_executor_stdin.tmp";
+    {
+        std::ofstream file(path);
+        file << "from stdin";
+    }
+
+    ProcessOptions options;
+    options.stdinFile = path;
+    std::vector<std::string> argv = {"cat"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+    std::remove(path.c_str());
+
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output, "from stdin");
+}
+
+TEST(ProcessExecutorTest, ArgvStdinData) {
+    ProcessOptions options;
+    options.stdinData = "piped prompt";
+    options.stdinFile = "ignored_when_stdin_data_is_set.tmp";
+    std::vector<std::string> argv = {"cat"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output, "piped prompt");
+}
+
+TEST(ProcessExecutorTest, ArgvEmptyStdinDataClosesInput) {
+    // cat only exits once its stdin reaches EOF
+    ProcessOptions options;
+    options.stdinData = "";
+    std::vector<std::string> argv = {"cat"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_TRUE(result.output.empty());
+}
+
+TEST(ProcessExecutorTest, ArgvLargeStdinDataDoesNotDeadlock) {
+    // Far larger than both pipe buffers: cat blocks on output until we read it
+    ProcessOptions options;
+    options.echoOutput = false;
+    options.stdinData = std::string(8 * 1024 * 1024, 'x');
+    std::vector<std::string> argv = {"cat"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output.size(), options.stdinData->size());
+    EXPECT_EQ(result.output, *options.stdinData);
+}
+
+TEST(ProcessExecutorTest, ArgvChildIgnoringStdinData) {
+    // The child exits without reading; the broken pipe must not take us down
+    ProcessOptions options;
+    options.stdinData = std::string(1024 * 1024, 'x');
+    std::vector<std::string> argv = {"sh", "-c", "printf done"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output, "done");
+}
+
+TEST(ProcessExecutorTest, LineObserverSeesEachLine) {
+    std::vector<std::string> lines;
+    ProcessOptions options;
+    options.echoOutput = false;
+    options.lineObserver = [&lines](const std::string& line) {
+        lines.push_back(line);
+        return true;
+    };
+    std::vector<std::string> argv = {"printf", "one\ntwo\r\n\nthree"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    std::vector<std::string> expected = {"one", "two", "", "three"};
+    EXPECT_EQ(lines, expected);
+    EXPECT_FALSE(result.stoppedByObserver);
+    EXPECT_EQ(result.exitCode, 0);
+}
+
+TEST(ProcessExecutorTest, LineObserverStopsChild) {
+    ProcessOptions options;
+    options.echoOutput = false;
+    options.newProcessGroup = true;
+    options.lineObserver = [](const std::string& line) {
+        return line.find("RESOURCE_EXHAUSTED") == std::string::npos;
+    };
+    std::vector<std::string> argv = {"sh", "-c", "echo working; echo 'Error: RESOURCE_EXHAUSTED'; sleep 30; echo never"};
+
+    auto start = std::chrono::steady_clock::now();
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_TRUE(result.stoppedByObserver);
+    EXPECT_EQ(result.exitCode, 128 + 9);
+    EXPECT_NE(result.output.find("RESOURCE_EXHAUSTED"), std::string::npos);
+    EXPECT_EQ(result.output.find("never"), std::string::npos);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(ProcessExecutorTest, ErrorLineObserverSeesOnlyStderr) {
+    std::vector<std::string> outLines;
+    std::vector<std::string> errorLines;
+    ProcessOptions options;
+    options.echoOutput = false;
+    options.mergeStderr = false;
+    options.newProcessGroup = true;
+    options.lineObserver = [&outLines](const std::string& line) {
+        outLines.push_back(line);
+        return true;
+    };
+    options.errorLineObserver = [&errorLines](const std::string& line) {
+        errorLines.push_back(line);
+        return line.find("429") == std::string::npos;
+    };
+    // The answer talking about 429s is not an error; the one on stderr is
+    std::vector<std::string> argv = {"sh", "-c", "echo 'HTTP 429 means slow down'; echo 'Error code: 429' >&2; sleep 30"};
+
+    auto start = std::chrono::steady_clock::now();
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_TRUE(result.stoppedByObserver);
+    EXPECT_EQ(outLines, (std::vector<std::string>{"HTTP 429 means slow down"}));
+    EXPECT_EQ(errorLines, (std::vector<std::string>{"Error code: 429"}));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+#endif
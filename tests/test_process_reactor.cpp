@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+#include <ProcessReactor.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+static ProcessOptions quietOptions() {
+    ProcessOptions options;
+    options.echoOutput = false;
+    return options;
+}
+
+TEST(ProcessReactorTest, StartAndWait) {
+    ProcessReactor reactor;
+    std::vector<std::string> argv = {"sh", "-c", "printf hello; exit 4"};
+    ProcessHandle handle = reactor.start(argv, quietOptions());
+
+    EXPECT_TRUE(handle.valid());
+    EXPECT_NE(handle.id(), 0u);
+
+    ProcessResult result = handle.wait();
+    EXPECT_EQ(result.exitCode, 4);
+    EXPECT_EQ(result.output, "hello");
+    EXPECT_FALSE(result.cancelled);
+    EXPECT_TRUE(handle.finished());
+    EXPECT_EQ(reactor.activeCount(), 0u);
+}
+
+TEST(ProcessReactorTest, LaunchFailureIsReportedFromReactorThread) {
+    ProcessReactor reactor;
+    std::atomic<bool> called{false};
+    std::atomic<bool> onCallerThread{false};
+    std::thread::id caller = std::this_thread::get_id();
+    std::vector<std::string> argv = {"nonexistent_command_12345"};
+    ProcessHandle handle = reactor.start(argv, quietOptions(), [&](const ProcessResult& result) {
+        called = true;
+        onCallerThread = std::this_thread::get_id() == caller;
+        EXPECT_EQ(result.exitCode, 127);
+    });
+
+    EXPECT_EQ(handle.wait().exitCode, 127);
+    EXPECT_TRUE(called.load());
+    EXPECT_FALSE(onCallerThread.load());
+    EXPECT_FALSE(handle.cancel());
+    EXPECT_EQ(reactor.activeCount(), 0u);
+}
+
+TEST(ProcessReactorTest, CompletionCallbackRunsBeforeFutureIsReady) {
+    ProcessReactor reactor;
+    std::atomic<int> callbackExitCode{-100};
+    std::vector<std::string> argv = {"sh", "-c", "exit 7"};
+    ProcessHandle handle = reactor.start(argv, quietOptions(), [&](const ProcessResult& result) {
+        callbackExitCode = result.exitCode;
+    });
+
+    EXPECT_EQ(handle.wait().exitCode, 7);
+    EXPECT_EQ(callbackExitCode.load(), 7);
+}
+
+TEST(ProcessReactorTest, ManyConcurrentChildren) {
+    ProcessReactor reactor;
+    std::vector<ProcessHandle> handles;
+    for (int i = 0; i < 32; i++) {
+        std::vector<std::string> argv = {"sh", "-c", "sleep 0.2; printf " + std::to_string(i)};
+        handles.push_back(reactor.start(argv, quietOptions()));
+    }
+    EXPECT_EQ(reactor.activeCount(), 32u);
+
+    // All children sleep concurrently, so this takes ~0.2s rather than 32 * 0.2s
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 32; i++) {
+        ProcessResult result = handles[i].wait();
+        EXPECT_EQ(result.exitCode, 0);
+        EXPECT_EQ(result.output, std::to_string(i));
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_LT(elapsed, std::chrono::seconds(3));
+}
+
+TEST(ProcessReactorTest, StdinDataAndLargeOutput) {
+    ProcessReactor reactor;
+    ProcessOptions options = quietOptions();
+    options.stdinData = std::string(4 * 1024 * 1024, 'z');
+    std::vector<std::string> argv = {"cat"};
+    ProcessResult result = reactor.start(argv, options).wait();
+
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output, *options.stdinData);
+}
+
+TEST(ProcessReactorTest, CancelKillsChild) {
+    ProcessReactor reactor;
+    std::vector<std::string> argv = {"sleep", "30"};
+    ProcessHandle handle = reactor.start(argv, quietOptions());
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(handle.cancel());
+    ProcessResult result = handle.wait();
+
+    EXPECT_TRUE(result.cancelled);
+    EXPECT_EQ(result.exitCode, 128 + 9);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    EXPECT_FALSE(handle.cancel());  // Already finished
+}
+
+TEST(ProcessReactorTest, DestructorKillsRunningChildren) {
+    ProcessHandle handle;
+    {
+        ProcessReactor reactor;
+        std::vector<std::string> argv = {"sleep", "30"};
+        handle = reactor.start(argv, quietOptions());
+    }
+    ASSERT_TRUE(handle.finished());
+    EXPECT_TRUE(handle.wait().cancelled);
+}
+
+TEST(ProcessReactorTest, LineObserverStopsChild) {
+    ProcessReactor reactor;
+    ProcessOptions options = quietOptions();
+    options.newProcessGroup = true;
+    std::vector<std::string> seen;
+    options.lineObserver = [&seen](const std::string& line) {
+        seen.push_back(line);
+        return line != "429 Too Many Requests";
+    };
+    std::vector<std::string> argv = {"sh", "-c", "echo start; echo '429 Too Many Requests'; sleep 30"};
+
+    auto start = std::chrono::steady_clock::now();
+    ProcessResult result = reactor.start(argv, options).wait();
+
+    EXPECT_TRUE(result.stoppedByObserver);
+    EXPECT_EQ(seen, (std::vector<std::string>{"start", "429 Too Many Requests"}));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(ProcessReactorTest, SeparateStderr) {
+    ProcessReactor reactor;
+    ProcessOptions options = quietOptions();
+    options.mergeStderr = false;
+    std::vector<std::string> errorLines;
+    options.errorLineObserver = [&errorLines](const std::string& line) {
+        errorLines.push_back(line);
+        return true;
+    };
+    std::vector<std::string> argv = {"sh", "-c", "echo out; echo err >&2; head -c 200000 /dev/zero >&2; echo done"};
+    ProcessResult result = reactor.start(argv, options).wait();
+
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output, "out\ndone\n");
+    EXPECT_EQ(result.errorOutput.size(), 200004u);
+    EXPECT_EQ(result.errorOutput.substr(0, 4), "err\n");
+    ASSERT_FALSE(errorLines.empty());
+    EXPECT_EQ(errorLines[0], "err");
+}
+
+TEST(ProcessReactorTest, EchoIsBatchedButComplete) {
+    ProcessReactor reactor;
+    ProcessOptions options;
+    options.mergeStderr = false;
+    std::ostringstream console;
+    std::ostringstream errorConsole;
+    std::streambuf* savedOut = std::cout.rdbuf(console.rdbuf());
+    std::streambuf* savedErr = std::cerr.rdbuf(errorConsole.rdbuf());
+    std::vector<std::string> argv = {"sh", "-c", "for i in 1 2 3 4 5; do echo line $i; done; echo oops >&2; printf tail"};
+    ProcessResult result = reactor.start(argv, options).wait();
+    std::cout.rdbuf(savedOut);
+    std::cerr.rdbuf(savedErr);
+
+    // Whatever is still pending when the child exits reaches the console too
+    EXPECT_EQ(console.str(), result.output);
+    EXPECT_EQ(console.str(), "line 1\nline 2\nline 3\nline 4\nline 5\ntail");
+    EXPECT_EQ(errorConsole.str(), "oops\n");
+}
+
+TEST(ProcessReactorTest, HeldInputIsReleasedLater) {
+    ProcessReactor reactor;
+    ProcessOptions options = quietOptions();
+    options.holdInput = true;
+    std::vector<std::string> argv = {"cat"};
+    ProcessHandle handle = reactor.start(argv, options);
+
+    // cat is up and blocked on its stdin until the input is released
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(handle.finished());
+
+    EXPECT_TRUE(handle.release("hello"));
+    ProcessResult result = handle.wait();
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output, "hello");
+    EXPECT_FALSE(handle.release("again"));
+}
+
+TEST(ProcessReactorTest, HeldChildTimeoutStartsAtRelease) {
+    ProcessReactor reactor;
+    ProcessOptions options = quietOptions();
+    options.holdInput = true;
+    options.newProcessGroup = true;
+    options.timeout = std::chrono::milliseconds(300);
+    std::vector<std::string> argv = {"sh", "-c", "cat; printf done"};
+    ProcessHandle handle = reactor.start(argv, options);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_FALSE(handle.finished());
+
+    EXPECT_TRUE(handle.release("x"));
+    ProcessResult result = handle.wait();
+    EXPECT_FALSE(result.timedOut);
+    EXPECT_EQ(result.output, "xdone");
+}
+
+TEST(ProcessReactorTest, ReleaseFailsForFinishedOrUnheldChildren) {
+    ProcessReactor reactor;
+    ProcessOptions options = quietOptions();
+    options.holdInput = true;
+    std::vector<std::string> exits = {"true"};
+    ProcessHandle held = reactor.start(exits, options);
+    held.wait();
+    EXPECT_FALSE(held.release("late"));
+
+    std::vector<std::string> sleeps = {"sleep", "30"};
+    ProcessHandle running = reactor.start(sleeps, quietOptions());
+    EXPECT_FALSE(running.release("x"));
+    EXPECT_TRUE(running.cancel());
+
+    ProcessHandle cancelled = reactor.start({"cat"}, options);
+    EXPECT_TRUE(cancelled.cancel());
+    EXPECT_FALSE(cancelled.release("x"));
+    EXPECT_TRUE(cancelled.wait().cancelled);
+}
+#endif
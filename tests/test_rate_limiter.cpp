@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+#include <RateLimiter.h>
+#include <GemStackCore.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+// A clock the test moves by hand
+class FakeClock {
+public:
+    ModelRateLimiter::ClockFunction function() {
+        return [this]() { return now; };
+    }
+
+    TokenBucket::Clock::time_point now = TokenBucket::Clock::time_point() + 1h;
+};
+
+static RateLimit rateLimit(double requestsPerMinute, int burst) {
+    RateLimit limit;
+    limit.requestsPerMinute = requestsPerMinute;
+    limit.burst = burst;
+    return limit;
+}
+
+TEST(TokenBucketTest, BurstThenSteadyRate) {
+    FakeClock clock;
+    TokenBucket bucket(rateLimit(6, 3), clock.now);  // One token every 10s
+
+    EXPECT_EQ(bucket.reserve(clock.now), 0ms);
+    EXPECT_EQ(bucket.reserve(clock.now), 0ms);
+    EXPECT_EQ(bucket.reserve(clock.now), 0ms);
+    EXPECT_EQ(bucket.reserve(clock.now), 10000ms);
+    // Reservations queue behind each other
+    EXPECT_EQ(bucket.reserve(clock.now), 20000ms);
+}
+
+TEST(TokenBucketTest, IdleTimeCountsTowardTheBudget) {
+    FakeClock clock;
+    TokenBucket bucket(rateLimit(6, 2), clock.now);
+    bucket.reserve(clock.now);
+    bucket.reserve(clock.now);
+    EXPECT_DOUBLE_EQ(bucket.available(clock.now), 0);
+
+    // A 15s prompt earns one and a half tokens back
+    clock.now += 15s;
+    EXPECT_EQ(bucket.reserve(clock.now), 0ms);
+    EXPECT_EQ(bucket.reserve(clock.now), 5000ms);
+
+    // A long idle spell refills only up to the burst
+    clock.now += 1h;
+    EXPECT_DOUBLE_EQ(bucket.available(clock.now), 2);
+}
+
+TEST(ModelRateLimiterTest, UnlimitedByDefault) {
+    FakeClock clock;
+    ModelRateLimiter limiter(clock.function());
+    EXPECT_FALSE(limiter.enabled());
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(limiter.reserve("gemini-2.5-pro"), 0ms);
+    }
+}
+
+TEST(ModelRateLimiterTest, BucketsArePerModel) {
+    FakeClock clock;
+    ModelRateLimiter limiter(clock.function());
+    limiter.configure(rateLimit(60, 1));
+    EXPECT_TRUE(limiter.enabled());
+
+    EXPECT_EQ(limiter.reserve("gemini-2.5-pro"), 0ms);
+    EXPECT_EQ(limiter.reserve("gemini-2.5-pro"), 1000ms);
+    // Falling back to another model doesn't wait on the first one's budget
+    EXPECT_EQ(limiter.reserve("gemini-2.5-flash"), 0ms);
+}
+
+TEST(ModelRateLimiterTest, PerModelOverrides) {
+    FakeClock clock;
+    ModelRateLimiter limiter(clock.function());
+    limiter.configure(rateLimit(0, 2), {{"gemini-2.5-pro", rateLimit(2, 0)}, {"gemini-2.5-flash", rateLimit(0, 5)}});
+    EXPECT_TRUE(limiter.enabled());
+
+    RateLimit pro = limiter.limitFor("gemini-2.5-pro");
+    EXPECT_DOUBLE_EQ(pro.requestsPerMinute, 2);
+    EXPECT_EQ(pro.burst, 2);  // Inherited
+    EXPECT_DOUBLE_EQ(limiter.limitFor("gemini-2.5-flash").requestsPerMinute, 0);
+
+    EXPECT_EQ(limiter.reserve("gemini-2.5-pro"), 0ms);
+    EXPECT_EQ(limiter.reserve("gemini-2.5-pro"), 0ms);
+    EXPECT_EQ(limiter.reserve("gemini-2.5-pro"), 30000ms);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(limiter.reserve("gemini-2.5-flash"), 0ms);
+    }
+}
+
+class ModelBudgetTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        g_config = getDefaultConfig();
+        configureRateLimits();
+        sleepCalls.clear();
+        setCooldownSleeper([](int seconds) { sleepCalls.push_back(seconds); });
+    }
+
+    void TearDown() override {
+        g_config = getDefaultConfig();
+        configureRateLimits();
+        resetCooldownSleeper();
+    }
+
+    static std::vector<int> sleepCalls;
+};
+
+std::vector<int> ModelBudgetTest::sleepCalls;
+
+TEST_F(ModelBudgetTest, NoWaitWithoutLimit) {
+    EXPECT_FALSE(isRateLimitEnabled());
+    EXPECT_FALSE(waitForModelBudget("gemini-2.5-pro"));
+    EXPECT_FALSE(waitForModelBudget("gemini-2.5-pro"));
+    EXPECT_TRUE(sleepCalls.empty());
+}
+
+TEST_F(ModelBudgetTest, WaitsThroughInjectedSleeper) {
+    g_config.requestsPerMinute = 6;
+    g_config.rateLimitBurst = 2;
+    configureRateLimits();
+    EXPECT_TRUE(isRateLimitEnabled());
+
+    EXPECT_FALSE(waitForModelBudget("gemini-2.5-pro"));
+    EXPECT_FALSE(waitForModelBudget("gemini-2.5-pro"));
+    EXPECT_TRUE(waitForModelBudget("gemini-2.5-pro"));
+    ASSERT_EQ(sleepCalls.size(), 1u);
+    EXPECT_EQ(sleepCalls[0], 10);
+}
+
+TEST_F(ModelBudgetTest, CliRateOverridesConfig) {
+    g_config.requestsPerMinute = 6;
+    configureRateLimits(30.0);
+
+    waitForModelBudget("gemini-2.5-pro");
+    waitForModelBudget("gemini-2.5-pro");
+    ASSERT_EQ(sleepCalls.size(), 1u);
+    EXPECT_EQ(sleepCalls[0], 2);
+}
+
+TEST_F(ModelBudgetTest, ConfigKeys) {
+    std::string filename = "test_rate_limit_config.txt";
+    std::ofstream file(filename);
+    file << "requests_per_minute=10\n";
+    file << "rateLimitBurst=3\n";
+    file << "requestsPerMinute.gemini-2.5-pro=2\n";
+    file << "rate_limit_burst.gemini-2.5-pro=1\n";
+    file.close();
+
+    EXPECT_DOUBLE_EQ(g_config.requestsPerMinute, 0);
+    EXPECT_EQ(g_config.rateLimitBurst, 1);
+
+    EXPECT_TRUE(loadConfig(filename));
+    EXPECT_DOUBLE_EQ(g_config.requestsPerMinute, 10);
+    EXPECT_EQ(g_config.rateLimitBurst, 3);
+    ASSERT_EQ(g_config.modelRateLimits.count("gemini-2.5-pro"), 1u);
+    EXPECT_DOUBLE_EQ(g_config.modelRateLimits["gemini-2.5-pro"].requestsPerMinute, 2);
+    EXPECT_EQ(g_config.modelRateLimits["gemini-2.5-pro"].burst, 1);
+
+    std::remove(filename.c_str());
+}
+
+TEST(RateLimitBackoffTest, DoublesUpToTheCap) {
+    // Without jitter each delay is half the window
+    EXPECT_EQ(rateLimitBackoffSeconds(0, 10, 300, 0.0), 5);
+    EXPECT_EQ(rateLimitBackoffSeconds(1, 10, 300, 0.0), 10);
+    EXPECT_EQ(rateLimitBackoffSeconds(2, 10, 300, 0.0), 20);
+    EXPECT_EQ(rateLimitBackoffSeconds(10, 10, 300, 0.0), 150);
+    EXPECT_EQ(rateLimitBackoffSeconds(1000, 10, 300, 0.0), 150);
+}
+
+TEST(RateLimitBackoffTest, JitterSpreadsTheUpperHalf) {
+    EXPECT_EQ(rateLimitBackoffSeconds(2, 10, 300, 0.5), 30);
+    EXPECT_EQ(rateLimitBackoffSeconds(2, 10, 300, 0.999), 40);
+    EXPECT_EQ(rateLimitBackoffSeconds(10, 10, 300, 0.999), 300);
+    // Never zero, even for a one-second base
+    EXPECT_EQ(rateLimitBackoffSeconds(0, 1, 1, 0.0), 1);
+}
+
+TEST_F(ModelBudgetTest, BackoffUsesInjectedSleeper) {
+    g_config.rateLimitBackoffSeconds = 4;
+    g_config.rateLimitBackoffMaxSeconds = 16;
+    for (int attempt = 0; attempt < 4; attempt++) {
+        int waited = performRateLimitBackoff(attempt);
+        ASSERT_FALSE(sleepCalls.empty());
+        EXPECT_EQ(waited, sleepCalls.back());
+    }
+    ASSERT_EQ(sleepCalls.size(), 4u);
+    EXPECT_GE(sleepCalls[0], 2);
+    EXPECT_LE(sleepCalls[0], 4);
+    EXPECT_GE(sleepCalls[1], 4);
+    EXPECT_LE(sleepCalls[1], 8);
+    EXPECT_GE(sleepCalls[3], 8);
+    EXPECT_LE(sleepCalls[3], 16);
+}
+
+TEST_F(ModelBudgetTest, BackoffConfigKeys) {
+    std::string filename = "test_backoff_config.txt";
+    std::ofstream file(filename);
+    file << "rate_limit_retries=0\n";
+    file << "rateLimitBackoffSeconds=3\n";
+    file << "rate_limit_backoff_max_seconds=60\n";
+    file.close();
+
+    EXPECT_EQ(g_config.rateLimitRetries, 2);
+    EXPECT_EQ(g_config.rateLimitBackoffSeconds, 10);
+    EXPECT_EQ(g_config.rateLimitBackoffMaxSeconds, 300);
+
+    EXPECT_TRUE(loadConfig(filename));
+    EXPECT_EQ(g_config.rateLimitRetries, 0);
+    EXPECT_EQ(g_config.rateLimitBackoffSeconds, 3);
+    EXPECT_EQ(g_config.rateLimitBackoffMaxSeconds, 60);
+
+    std::remove(filename.c_str());
+}
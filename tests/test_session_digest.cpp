@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include <SessionDigest.h>
+#include <filesystem>
+#include <string>
+
+static std::string entry(int i, bool success = true) {
+    return "[2026-01-24 10:" + std::to_string(10 + i % 50) + ":00] " + (success ? "[SUCCESS] " : "[FAILED] ") +
+           "Prompt number " + std::to_string(i) + (success ? "" : " | Notes: Exit code: 1") + "\n";
+}
+
+static std::string makeLog(int entries) {
+    std::string log;
+    for (int i = 0; i < entries; i++) {
+        log += entry(i);
+    }
+    return log;
+}
+
+TEST(SessionDigestTest, SplitsEntriesAndKeepsContinuations) {
+    std::string log = entry(1) + "Decided to use Vite\n  because CRA is deprecated\n\n" + entry(2);
+    auto entries = splitSessionEntries(log);
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[1], "Decided to use Vite\n  because CRA is deprecated\n\n");
+
+    std::string joined;
+    for (const auto& e : entries) {
+        joined += e;
+    }
+    EXPECT_EQ(joined, log);
+}
+
+TEST(SessionDigestTest, CompactsEntries) {
+    EXPECT_EQ(compactSessionEntry(entry(3)), "+ Prompt number 3");
+    EXPECT_EQ(compactSessionEntry(entry(4, false)), "! Prompt number 4 | Notes: Exit code: 1");
+    EXPECT_EQ(compactSessionEntry("Decided to use Vite\n  because CRA is deprecated\n"),
+              "* Decided to use Vite because CRA is deprecated");
+    std::string line = compactSessionEntry(std::string(500, 'x'), 40);
+    EXPECT_EQ(line.size(), 40u);
+    EXPECT_EQ(line.substr(37), "...");
+}
+
+TEST(SessionDigestTest, ShortLogIsSentVerbatim) {
+    SessionDigest digest;
+    std::string log = makeLog(5);
+    BoundedSessionLog bounded = boundSessionLog(log, 20, digest);
+    EXPECT_EQ(bounded.digest, "");
+    EXPECT_EQ(bounded.recent, log);
+    EXPECT_FALSE(bounded.digestChanged);
+}
+
+TEST(SessionDigestTest, OlderEntriesAreFolded) {
+    SessionDigest digest;
+    std::string log = makeLog(30);
+    log += entry(30, false);
+    BoundedSessionLog bounded = boundSessionLog(log, 10, digest);
+
+    EXPECT_EQ(digest.foldedEntries(), 21u);
+    EXPECT_EQ(splitSessionEntries(bounded.recent).size(), 10u);
+    EXPECT_EQ(log.substr(0, digest.foldedBytes()) + bounded.recent, log);
+    EXPECT_NE(bounded.digest.find("(21 succeeded, 0 failed, 0 notes)"), std::string::npos);
+    EXPECT_NE(bounded.digest.find("+ Prompt number 0\n"), std::string::npos);
+    EXPECT_LT(bounded.keptBytes(), bounded.logBytes);
+}
+
+TEST(SessionDigestTest, FoldsIncrementally) {
+    SessionDigest digest;
+    std::string log = makeLog(15);
+    boundSessionLog(log, 10, digest);
+    EXPECT_EQ(digest.foldedEntries(), 5u);
+
+    BoundedSessionLog unchanged = boundSessionLog(log, 10, digest);
+    EXPECT_FALSE(unchanged.digestChanged);
+
+    log += entry(15, false) + "Remember to update the README\n";
+    BoundedSessionLog bounded = boundSessionLog(log, 10, digest);
+    EXPECT_TRUE(bounded.digestChanged);
+    EXPECT_EQ(digest.foldedEntries(), 7u);
+    EXPECT_EQ(splitSessionEntries(bounded.recent).size(), 10u);
+}
+
+TEST(SessionDigestTest, DigestStaysWithinBudget) {
+    SessionDigest digest(200);
+    std::string log = makeLog(200);
+    BoundedSessionLog bounded = boundSessionLog(log, 5, digest);
+    EXPECT_EQ(digest.foldedEntries(), 195u);
+    EXPECT_LT(bounded.digest.size(), 400u);
+    EXPECT_NE(bounded.digest.find("(195 succeeded"), std::string::npos);
+    EXPECT_NE(bounded.digest.find("oldest entries omitted"), std::string::npos);
+    // The newest folded entry survives the trimming
+    EXPECT_NE(bounded.digest.find("+ Prompt number 194\n"), std::string::npos);
+}
+
+TEST(SessionDigestTest, ClearedOrEditedLogRebuildsDigest) {
+    SessionDigest digest;
+    boundSessionLog(makeLog(30), 10, digest);
+    EXPECT_EQ(digest.foldedEntries(), 20u);
+
+    // clearSessionLog() and a fresh start
+    std::string fresh = makeLog(3);
+    BoundedSessionLog bounded = boundSessionLog(fresh, 10, digest);
+    EXPECT_TRUE(bounded.digestChanged);
+    EXPECT_EQ(digest.foldedEntries(), 0u);
+    EXPECT_EQ(bounded.recent, fresh);
+
+    // An older entry edited by hand
+    std::string log = makeLog(30);
+    boundSessionLog(log, 10, digest);
+    log.replace(log.find("Prompt number 2\n"), 15, "Prompt number X");
+    boundSessionLog(log, 10, digest);
+    EXPECT_EQ(digest.foldedEntries(), 20u);
+    EXPECT_NE(digest.render().find("+ Prompt number X"), std::string::npos);
+    EXPECT_EQ(digest.render().find("+ Prompt number 2\n"), std::string::npos);
+}
+
+TEST(SessionDigestTest, UnchangedPrefixIsTrusted) {
+    SessionDigest digest;
+    std::string log = makeLog(30);
+    boundSessionLog(log, 10, digest);
+    EXPECT_EQ(digest.foldedEntries(), 20u);
+
+    // Without verification the folded bytes are not looked at again, only the new ones
+    std::string edited = log;
+    edited.replace(edited.find("Prompt number 2\n"), 15, "Prompt number X");
+    BoundedSessionLog trusted = boundSessionLog(edited + entry(30), 10, digest, false);
+    EXPECT_EQ(digest.foldedEntries(), 21u);
+    EXPECT_NE(trusted.digest.find("+ Prompt number 2\n"), std::string::npos);
+    EXPECT_EQ(splitSessionEntries(trusted.recent).size(), 10u);
+
+    // Verifying notices the edit and rebuilds
+    BoundedSessionLog verified = boundSessionLog(edited + entry(30), 10, digest, true);
+    EXPECT_TRUE(verified.digestChanged);
+    EXPECT_NE(verified.digest.find("+ Prompt number X"), std::string::npos);
+
+    // A log shorter than the digest is never trusted
+    BoundedSessionLog shorter = boundSessionLog(makeLog(3), 10, digest, false);
+    EXPECT_EQ(digest.foldedEntries(), 0u);
+    EXPECT_EQ(shorter.recent, makeLog(3));
+}
+
+TEST(SessionDigestTest, SavedDigestIsReused) {
+    std::string path = (std::filesystem::temp_directory_path() / "gemstack_session_digest_test.txt").string();
+    std::string log = makeLog(25);
+
+    SessionDigest digest;
+    BoundedSessionLog first = boundSessionLog(log, 10, digest);
+    ASSERT_TRUE(digest.save(path));
+
+    SessionDigest loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_TRUE(loaded.covers(log));
+    BoundedSessionLog second = boundSessionLog(log, 10, loaded);
+    EXPECT_FALSE(second.digestChanged);
+    EXPECT_EQ(second.digest, first.digest);
+    EXPECT_EQ(second.recent, first.recent);
+
+    // A digest of some other log is thrown away
+    EXPECT_FALSE(loaded.covers(makeLog(3)));
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <SessionLogCache.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+class SessionLogCacheTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        path = (std::filesystem::temp_directory_path() / "gemstack_session_log_cache_test.txt").string();
+        std::filesystem::remove(path);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path);
+    }
+
+    void append(const std::string& text) {
+        std::ofstream file(path, std::ios::app | std::ios::binary);
+        file << text;
+    }
+
+    void overwrite(const std::string& text) {
+        std::ofstream file(path, std::ios::trunc | std::ios::binary);
+        file << text;
+    }
+};
+
+TEST_F(SessionLogCacheTest, MissingFileIsEmpty) {
+    SessionLogCache cache(path);
+    EXPECT_EQ(cache.contents(), "");
+    EXPECT_EQ(cache.bytesRead(), 0u);
+}
+
+TEST_F(SessionLogCacheTest, ReadsOnlyAppendedBytes) {
+    SessionLogCache cache(path);
+    std::string first = "[2026-01-24 10:30:00] [SUCCESS] Initialize React project\n";
+    append(first);
+    EXPECT_EQ(cache.contents(), first);
+    EXPECT_EQ(cache.bytesRead(), first.size());
+
+    // Nothing new: only the check bytes are read
+    uint64_t before = cache.bytesRead();
+    EXPECT_EQ(cache.contents(), first);
+    EXPECT_LE(cache.bytesRead() - before, SessionLogCache::CHECK_BYTES);
+
+    // A note appended by the agent itself
+    std::string note = "Decided to use Vite instead of CRA\n";
+    append(note);
+    before = cache.bytesRead();
+    EXPECT_EQ(cache.contents(), first + note);
+    EXPECT_LE(cache.bytesRead() - before, note.size() + SessionLogCache::CHECK_BYTES);
+    EXPECT_EQ(cache.fullReads(), 1);
+}
+
+TEST_F(SessionLogCacheTest, LongLogIsNotReread) {
+    SessionLogCache cache(path);
+    std::string line = "[2026-01-24 10:30:00] [SUCCESS] Another completed prompt with some notes\n";
+    std::string expected;
+    for (int i = 0; i < 200; i++) {
+        append(line);
+        expected += line;
+        ASSERT_EQ(cache.contents(), expected);
+    }
+    // Linear in the log size rather than quadratic
+    EXPECT_LE(cache.bytesRead(), expected.size() + 200 * SessionLogCache::CHECK_BYTES);
+}
+
+TEST_F(SessionLogCacheTest, TruncationIsDetected) {
+    SessionLogCache cache(path);
+    append("old entry one\nold entry two\n");
+    EXPECT_EQ(cache.contents(), "old entry one\nold entry two\n");
+
+    overwrite("");
+    EXPECT_EQ(cache.contents(), "");
+
+    // Cleared and then written past the old length
+    append("a fresh session that is longer than before\n");
+    EXPECT_EQ(cache.contents(), "a fresh session that is longer than before\n");
+}
+
+TEST_F(SessionLogCacheTest, RewrittenFileIsReloaded) {
+    SessionLogCache cache(path);
+    append("[SUCCESS] Step one\n");
+    EXPECT_EQ(cache.contents(), "[SUCCESS] Step one\n");
+
+    // Edited in place to the same length plus more
+    overwrite("[FAILED]  Step one\n[SUCCESS] Step two\n");
+    EXPECT_EQ(cache.contents(), "[FAILED]  Step one\n[SUCCESS] Step two\n");
+    EXPECT_EQ(cache.fullReads(), 2);
+}
+
+TEST_F(SessionLogCacheTest, InvalidateForcesFullRead) {
+    SessionLogCache cache(path);
+    append("entry\n");
+    EXPECT_EQ(cache.contents(), "entry\n");
+    cache.invalidate();
+    EXPECT_EQ(cache.contents(), "entry\n");
+    EXPECT_EQ(cache.fullReads(), 2);
+}
+
+TEST_F(SessionLogCacheTest, GenerationChangesOnlyWhenContentsAreDropped) {
+    SessionLogCache cache(path);
+    uint64_t first = 0;
+    uint64_t generation = 0;
+    append("entry one\n");
+    cache.contents(first);
+    append("entry two\n");
+    EXPECT_EQ(cache.contents(generation), "entry one\nentry two\n");
+    EXPECT_EQ(generation, first);
+
+    overwrite("entry 1\nentry two\nentry three\n");
+    cache.contents(generation);
+    EXPECT_NE(generation, first);
+
+    uint64_t rewritten = generation;
+    cache.invalidate();
+    cache.contents(generation);
+    EXPECT_NE(generation, rewritten);
+}
+
+TEST_F(SessionLogCacheTest, FileRemovedAndRecreated) {
+    SessionLogCache cache(path);
+    append("first run\n");
+    EXPECT_EQ(cache.contents(), "first run\n");
+    std::filesystem::remove(path);
+    EXPECT_EQ(cache.contents(), "");
+    append("second run\n");
+    EXPECT_EQ(cache.contents(), "second run\n");
+}
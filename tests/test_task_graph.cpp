@@ -0,0 +1,377 @@
+#include <gtest/gtest.h>
+#include <TaskGraph.h>
+#include <GemStackCore.h>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+static TaskSpec makeTask(const std::string& command, const std::string& id = "",
+                         const std::vector<std::string>& after = {}, int block = 0,
+                         const std::string& blockId = "") {
+    TaskSpec spec;
+    spec.command = command;
+    spec.id = id;
+    spec.after = after;
+    spec.block = block;
+    spec.blockId = blockId;
+    return spec;
+}
+
+// Acquire the next ready task without blocking forever in a failing test
+static std::optional<size_t> acquireIfReady(TaskGraph& graph) {
+    for (size_t i = 0; i < graph.size(); i++) {
+        if (graph.state(i) == TaskState::Ready) {
+            return graph.acquire();
+        }
+    }
+    return std::nullopt;
+}
+
+// ============================================================================
+// Scheduling Tests
+// ============================================================================
+
+TEST(TaskGraph, IndependentTasksAreAllReady) {
+    TaskGraph graph;
+    graph.addTasks({makeTask("prompt \"A\""), makeTask("prompt \"B\"")});
+
+    EXPECT_EQ(graph.state(0), TaskState::Ready);
+    EXPECT_EQ(graph.state(1), TaskState::Ready);
+
+    // Lowest index first keeps file order for a single worker
+    EXPECT_EQ(graph.acquire(), 0u);
+    EXPECT_EQ(graph.acquire(), 1u);
+}
+
+TEST(TaskGraph, AfterWaitsForLabelledTask) {
+    TaskGraph graph;
+    graph.addTasks({
+        makeTask("prompt \"Consumer\"", "", {"setup"}),
+        makeTask("prompt \"Setup\"", "setup")
+    });
+
+    // Forward references are allowed
+    EXPECT_EQ(graph.state(0), TaskState::Pending);
+    EXPECT_EQ(graph.state(1), TaskState::Ready);
+
+    auto first = acquireIfReady(graph);
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(*first, 1u);
+
+    graph.complete(1, true);
+    EXPECT_EQ(graph.state(0), TaskState::Ready);
+}
+
+TEST(TaskGraph, PromptsInBlockRunInOrder) {
+    TaskGraph graph;
+    graph.addTasks({
+        makeTask("prompt \"A1\"", "", {}, 1),
+        makeTask("prompt \"A2\"", "", {}, 1),
+        makeTask("prompt \"B1\"", "", {}, 2)
+    });
+
+    // Second prompt in block 1 waits for the first; block 2 is independent
+    EXPECT_EQ(graph.state(0), TaskState::Ready);
+    EXPECT_EQ(graph.state(1), TaskState::Pending);
+    EXPECT_EQ(graph.state(2), TaskState::Ready);
+    EXPECT_EQ(graph.dependencies(1), std::vector<size_t>{0});
+}
+
+TEST(TaskGraph, AfterBlockWaitsForWholeBlock) {
+    TaskGraph graph;
+    graph.addTasks({
+        makeTask("prompt \"A1\"", "", {}, 1, "backend"),
+        makeTask("prompt \"A2\"", "", {}, 1, "backend"),
+        makeTask("prompt \"B1\"", "", {"backend"}, 2, "frontend")
+    });
+
+    // Depending on a block means depending on its last prompt
+    EXPECT_EQ(graph.dependencies(2), std::vector<size_t>{1});
+
+    graph.acquire();
+    graph.complete(0, true);
+    EXPECT_EQ(graph.state(2), TaskState::Pending);
+
+    graph.acquire();
+    graph.complete(1, true);
+    EXPECT_EQ(graph.state(2), TaskState::Ready);
+}
+
+TEST(TaskGraph, FailureSkipsDownstream) {
+    TaskGraph graph;
+    graph.addTasks({
+        makeTask("prompt \"Root\"", "root"),
+        makeTask("prompt \"Child\"", "child", {"root"}),
+        makeTask("prompt \"Grandchild\"", "", {"child"}),
+        makeTask("prompt \"Unrelated\"")
+    });
+
+    ASSERT_EQ(graph.acquire(), 0u);
+    std::vector<size_t> skipped = graph.complete(0, false);
+
+    EXPECT_EQ(graph.state(0), TaskState::Failed);
+    EXPECT_EQ(graph.state(1), TaskState::Skipped);
+    EXPECT_EQ(graph.state(2), TaskState::Skipped);
+    EXPECT_EQ(graph.state(3), TaskState::Ready);
+    EXPECT_EQ(skipped.size(), 2u);
+    EXPECT_EQ(graph.remaining(), 1u);
+}
+
+TEST(TaskGraph, CycleIsSkipped) {
+    TaskGraph graph;
+    graph.addTasks({
+        makeTask("prompt \"A\"", "a", {"b"}),
+        makeTask("prompt \"B\"", "b", {"a"}),
+        makeTask("prompt \"C\"")
+    });
+
+    EXPECT_EQ(graph.state(0), TaskState::Skipped);
+    EXPECT_EQ(graph.state(1), TaskState::Skipped);
+    EXPECT_EQ(graph.state(2), TaskState::Ready);
+}
+
+TEST(TaskGraph, UnknownDependencyIsIgnored) {
+    TaskGraph graph;
+    graph.addTasks({makeTask("prompt \"A\"", "", {"missing"})});
+    EXPECT_EQ(graph.state(0), TaskState::Ready);
+}
+
+TEST(TaskGraph, AcquireReturnsNulloptWhenClosedAndDrained) {
+    TaskGraph graph;
+    size_t index = graph.addTask("--version");
+    ASSERT_EQ(graph.acquire(), index);
+    graph.complete(index, true);
+
+    graph.close();
+    EXPECT_FALSE(graph.acquire().has_value());
+    EXPECT_EQ(graph.remaining(), 0u);
+}
+
+TEST(TaskGraph, ParkedTaskWaitsWhileOthersRun) {
+    TaskGraph graph;
+    size_t first = graph.addTask("prompt \"A\"");
+    size_t second = graph.addTask("prompt \"B\"");
+    ASSERT_EQ(graph.acquire(), first);
+
+    // Rate limited with a retry delay: hand it back and take other work
+    graph.park(first, std::chrono::steady_clock::now() + std::chrono::milliseconds(200));
+    EXPECT_EQ(graph.parkCount(first), 1);
+    EXPECT_EQ(graph.state(first), TaskState::Ready);
+    EXPECT_EQ(graph.remaining(), 2u);
+    ASSERT_EQ(graph.acquire(), second);
+    graph.complete(second, true);
+
+    // Still parked, so not done; acquire() waits for its time
+    EXPECT_EQ(graph.remaining(), 1u);
+    auto start = std::chrono::steady_clock::now();
+    graph.close();
+    ASSERT_EQ(graph.acquire(), first);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+    graph.complete(first, true);
+    EXPECT_FALSE(graph.acquire().has_value());
+}
+
+TEST(TaskGraph, ParkedTaskKeepsDependentsWaiting) {
+    TaskGraph graph;
+    graph.addTasks({
+        makeTask("prompt \"Setup\"", "setup"),
+        makeTask("prompt \"Build\"", "", {"setup"})
+    });
+    ASSERT_EQ(graph.acquire(), 0u);
+    graph.park(0, std::chrono::steady_clock::now());
+    EXPECT_EQ(graph.state(1), TaskState::Pending);
+    ASSERT_EQ(graph.acquire(), 0u);
+    graph.complete(0, true);
+    EXPECT_EQ(graph.acquire(), 1u);
+}
+
+TEST(TaskGraph, WaitUntilIdleWakesOnCompletion) {
+    TaskGraph graph;
+    size_t index = graph.addTask("prompt \"A\"");
+    ASSERT_EQ(graph.acquire(), index);
+
+    std::thread worker([&graph, index]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        graph.complete(index, true);
+    });
+    graph.waitUntilIdle();
+    EXPECT_EQ(graph.state(index), TaskState::Succeeded);
+    worker.join();
+}
+
+TEST(TaskGraph, CancelPendingSkipsUnstartedWork) {
+    TaskGraph graph;
+    graph.addTasks({
+        makeTask("prompt \"Setup\"", "setup"),
+        makeTask("prompt \"Build\"", "", {"setup"}),
+        makeTask("prompt \"Docs\"")
+    });
+    size_t parked = graph.addTask("prompt \"Parked\"");
+    ASSERT_EQ(graph.acquire(), 0u);
+    ASSERT_EQ(graph.acquire(), 2u);
+    ASSERT_EQ(graph.acquire(), parked);
+    graph.park(parked, std::chrono::steady_clock::now() + std::chrono::hours(1));
+
+    // The running tasks finish; the pending, ready and parked ones never start
+    EXPECT_EQ(graph.cancelPending(), 2u);
+    EXPECT_EQ(graph.state(1), TaskState::Skipped);
+    EXPECT_EQ(graph.state(parked), TaskState::Skipped);
+    EXPECT_EQ(graph.state(0), TaskState::Running);
+    graph.complete(0, true);
+    graph.complete(2, true);
+    EXPECT_FALSE(graph.acquire().has_value());
+    EXPECT_EQ(graph.remaining(), 0u);
+}
+
+TEST(TaskGraph, BlockOutcome) {
+    TaskGraph graph;
+    graph.addTasks({
+        makeTask("prompt \"A1\"", "", {}, 1),
+        makeTask("prompt \"A2\"", "", {}, 1)
+    });
+    EXPECT_EQ(graph.blocks(), std::vector<int>{1});
+    EXPECT_FALSE(graph.blockOutcome(1).has_value());
+
+    graph.acquire();
+    graph.complete(0, true);
+    EXPECT_FALSE(graph.blockOutcome(1).has_value());
+
+    graph.acquire();
+    graph.complete(1, true);
+    ASSERT_TRUE(graph.blockOutcome(1).has_value());
+    EXPECT_TRUE(*graph.blockOutcome(1));
+}
+
+TEST(TaskGraph, HeldBlockDependentsWaitForRelease) {
+    TaskGraph graph;
+    graph.addTasks({
+        makeTask("prompt \"A1\"", "", {}, 1, "a"),
+        makeTask("prompt \"A2\"", "", {}, 1, "a"),
+        makeTask("prompt \"B1\"", "", {"a"}, 2, "b"),
+        makeTask("prompt \"After A\"", "", {"a"})
+    });
+    graph.holdBlockDependents(true);
+
+    graph.acquire();
+    graph.complete(0, true);
+    // The next prompt in the same block is not held
+    EXPECT_EQ(graph.state(1), TaskState::Ready);
+    graph.acquire();
+    graph.complete(1, true);
+
+    // Block A is finished but not merged yet
+    EXPECT_EQ(graph.state(2), TaskState::Pending);
+    EXPECT_EQ(graph.state(3), TaskState::Pending);
+
+    EXPECT_TRUE(graph.releaseBlock(1, true).empty());
+    EXPECT_EQ(graph.state(2), TaskState::Ready);
+    EXPECT_EQ(graph.state(3), TaskState::Ready);
+}
+
+TEST(TaskGraph, UnmergedBlockSkipsHeldDependents) {
+    TaskGraph graph;
+    graph.addTasks({
+        makeTask("prompt \"A1\"", "", {}, 1, "a"),
+        makeTask("prompt \"B1\"", "", {"a"}, 2, "b"),
+        makeTask("prompt \"B2\"", "", {}, 2, "b")
+    });
+    graph.holdBlockDependents(true);
+    graph.close();
+
+    graph.acquire();
+    graph.complete(0, true);
+
+    // Workers keep waiting while a finished block may still release work
+    std::optional<size_t> next;
+    std::thread worker([&graph, &next]() { next = graph.acquire(); });
+    std::vector<size_t> skipped = graph.releaseBlock(1, false);
+    worker.join();
+    EXPECT_FALSE(next.has_value());
+    EXPECT_EQ(skipped, (std::vector<size_t>{1, 2}));
+    EXPECT_EQ(graph.state(1), TaskState::Skipped);
+    EXPECT_EQ(graph.state(2), TaskState::Skipped);
+}
+
+TEST(TaskGraph, BlockOrderPutsUpstreamBlocksFirst) {
+    TaskGraph graph;
+    graph.addTasks({
+        makeTask("prompt \"B1\"", "", {"a"}, 1, "b"),
+        makeTask("prompt \"Glue\"", "glue", {"c"}),
+        makeTask("prompt \"A1\"", "", {"glue"}, 2, "a"),
+        makeTask("prompt \"C1\"", "", {}, 3, "c")
+    });
+    // B waits for A, which waits for C through a top-level prompt
+    EXPECT_EQ(graph.blocks(), (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(graph.blockOrder(), (std::vector<int>{3, 2, 1}));
+}
+
+TEST(TaskGraph, ParseLabelList) {
+    EXPECT_EQ(parseLabelList("setup, schema"), (std::vector<std::string>{"setup", "schema"}));
+    EXPECT_EQ(parseLabelList("  one  "), std::vector<std::string>{"one"});
+    EXPECT_TRUE(parseLabelList("").empty());
+}
+
+// ============================================================================
+// Queue File Directive Tests
+// ============================================================================
+
+TEST(TaskDirectives, IdAndAfterAttachToNextPrompt) {
+    std::string filename = "test_task_labels.txt";
+    std::ofstream file(filename);
+    file << "GemStackSTART\n";
+    file << "id \"setup\"\n";
+    file << "prompt \"Create project\"\n";
+    file << "after \"setup\"\n";
+    file << "prompt \"Add tests\"\n";
+    file << "GemStackEND";
+    file.close();
+
+    std::vector<TaskSpec> tasks;
+    EXPECT_TRUE(loadTasksFromFile(filename, tasks));
+    ASSERT_EQ(tasks.size(), 2u);
+    EXPECT_EQ(tasks[0].id, "setup");
+    EXPECT_TRUE(tasks[0].after.empty());
+    EXPECT_TRUE(tasks[1].id.empty());
+    EXPECT_EQ(tasks[1].after, std::vector<std::string>{"setup"});
+    EXPECT_EQ(tasks[1].command, "prompt \"Add tests\"");
+
+    std::remove(filename.c_str());
+}
+
+TEST(TaskDirectives, PromptBlockLabels) {
+    std::string filename = "test_block_labels.txt";
+    std::ofstream file(filename);
+    file << "GemStackSTART\n";
+    file << "PromptBlockSTART id \"backend\"\n";
+    file << "prompt \"API\"\n";
+    file << "PromptBlockEND\n";
+    file << "PromptBlockSTART id \"frontend\" after \"backend\"\n";
+    file << "prompt \"UI\"\n";
+    file << "prompt \"Styling\"\n";
+    file << "PromptBlockEND\n";
+    file << "GemStackEND";
+    file.close();
+
+    std::vector<TaskSpec> tasks;
+    EXPECT_TRUE(loadTasksFromFile(filename, tasks));
+    ASSERT_EQ(tasks.size(), 3u);
+    EXPECT_EQ(tasks[0].blockId, "backend");
+    EXPECT_EQ(tasks[0].block, 1);
+    EXPECT_EQ(tasks[1].blockId, "frontend");
+    EXPECT_EQ(tasks[1].block, 2);
+    // Block dependencies gate only the first prompt; the rest follow in block order
+    EXPECT_EQ(tasks[1].after, std::vector<std::string>{"backend"});
+    EXPECT_TRUE(tasks[2].after.empty());
+
+    TaskGraph graph;
+    graph.addTasks(tasks);
+    EXPECT_EQ(graph.state(0), TaskState::Ready);
+    EXPECT_EQ(graph.state(1), TaskState::Pending);
+    EXPECT_EQ(graph.state(2), TaskState::Pending);
+
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <GemStackCore.h>
+#include <TaskGraph.h>
+#include <ProcessExecutor.h>
+#include <ProcessReactor.h>
+#include <fstream>
+#include <cstdio>
+#include <chrono>
+
+// ============================================================================
+// Parsing Tests
+// ============================================================================
+
+TEST(TimeoutParsing, DurationSeconds) {
+    EXPECT_EQ(parseDurationSeconds("90"), 90);
+    EXPECT_EQ(parseDurationSeconds("90s"), 90);
+    EXPECT_EQ(parseDurationSeconds("15m"), 900);
+    EXPECT_EQ(parseDurationSeconds("2h"), 7200);
+    EXPECT_EQ(parseDurationSeconds(" 0 "), 0);
+}
+
+TEST(TimeoutParsing, InvalidDuration) {
+    EXPECT_EQ(parseDurationSeconds(""), -1);
+    EXPECT_EQ(parseDurationSeconds("m"), -1);
+    EXPECT_EQ(parseDurationSeconds("-5"), -1);
+    EXPECT_EQ(parseDurationSeconds("ten"), -1);
+    EXPECT_EQ(parseDurationSeconds("5d"), -1);
+    EXPECT_EQ(parseDurationSeconds("99999999999"), -1);
+}
+
+TEST(TimeoutParsing, DirectivesApplyToNextPromptOnly) {
+    std::string filename = "test_timeout_directives.txt";
+    std::ofstream file(filename);
+    file << "GemStackSTART\n";
+    file << "timeout \"10m\"\n";
+    file << "idletimeout \"90\"\n";
+    file << "prompt \"Long refactor\"\n";
+    file << "prompt \"Quick fix\"\n";
+    file << "timeout \"0\"\n";
+    file << "prompt \"Unlimited\"\n";
+    file << "GemStackEND";
+    file.close();
+
+    std::vector<TaskSpec> tasks;
+    EXPECT_TRUE(loadTasksFromFile(filename, tasks));
+    ASSERT_EQ(tasks.size(), 3u);
+    EXPECT_EQ(tasks[0].timeoutSeconds, 600);
+    EXPECT_EQ(tasks[0].idleTimeoutSeconds, 90);
+    EXPECT_EQ(tasks[1].timeoutSeconds, -1);
+    EXPECT_EQ(tasks[1].idleTimeoutSeconds, -1);
+    EXPECT_EQ(tasks[2].timeoutSeconds, 0);
+
+    std::remove(filename.c_str());
+}
+
+TEST(TimeoutParsing, ConfigKeys) {
+    std::string filename = "test_timeout_config.txt";
+    std::ofstream file(filename);
+    file << "promptTimeoutSeconds=30m\n";
+    file << "prompt_idle_timeout_seconds=120\n";
+    file << "timeoutRetries=2\n";
+    file.close();
+
+    g_config = getDefaultConfig();
+    EXPECT_EQ(g_config.promptTimeoutSeconds, 0);
+    EXPECT_EQ(g_config.promptIdleTimeoutSeconds, 0);
+    EXPECT_EQ(g_config.timeoutRetries, 0);
+
+    EXPECT_TRUE(loadConfig(filename));
+    EXPECT_EQ(g_config.promptTimeoutSeconds, 1800);
+    EXPECT_EQ(g_config.promptIdleTimeoutSeconds, 120);
+    EXPECT_EQ(g_config.timeoutRetries, 2);
+
+    g_config = getDefaultConfig();
+    std::remove(filename.c_str());
+}
+
+// ============================================================================
+// Enforcement Tests
+// ============================================================================
+
+#ifndef _WIN32
+using Clock = std::chrono::steady_clock;
+
+static ProcessOptions limitedOptions() {
+    ProcessOptions options;
+    options.echoOutput = false;
+    options.newProcessGroup = true;
+    options.killGracePeriod = std::chrono::milliseconds(200);
+    return options;
+}
+
+TEST(TimeoutEnforcement, WallClockKillsProcessGroup) {
+    // The backgrounded sleep holds the output pipe; only a group kill lets us see EOF
+    ProcessOptions options = limitedOptions();
+    options.timeout = std::chrono::milliseconds(300);
+    std::vector<std::string> argv = {"sh", "-c", "sleep 30 & sleep 30"};
+
+    auto start = Clock::now();
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_TRUE(result.timedOut);
+    EXPECT_FALSE(result.idleTimedOut);
+    EXPECT_EQ(result.exitCode, 128 + 15);
+    EXPECT_LT(Clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(TimeoutEnforcement, IdleTimeout) {
+    ProcessOptions options = limitedOptions();
+    options.idleTimeout = std::chrono::milliseconds(300);
+    std::vector<std::string> argv = {"sh", "-c", "printf started; sleep 30"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_TRUE(result.timedOut);
+    EXPECT_TRUE(result.idleTimedOut);
+    EXPECT_EQ(result.output, "started");
+}
+
+TEST(TimeoutEnforcement, OutputResetsIdleTimer) {
+    ProcessOptions options = limitedOptions();
+    options.idleTimeout = std::chrono::milliseconds(500);
+    std::vector<std::string> argv = {"sh", "-c", "for i in 1 2 3 4 5 6; do printf x; sleep 0.15; done"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_FALSE(result.timedOut);
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output, "xxxxxx");
+}
+
+TEST(TimeoutEnforcement, EscalatesToSigkill) {
+    // SIG_IGN is inherited, so the whole group shrugs off SIGTERM
+    ProcessOptions options = limitedOptions();
+    options.timeout = std::chrono::milliseconds(200);
+    std::vector<std::string> argv = {"sh", "-c", "trap '' TERM; sleep 30"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_TRUE(result.timedOut);
+    EXPECT_EQ(result.exitCode, 128 + 9);
+}
+
+TEST(TimeoutEnforcement, FastChildIsUnaffected) {
+    ProcessOptions options = limitedOptions();
+    options.timeout = std::chrono::seconds(10);
+    options.idleTimeout = std::chrono::seconds(10);
+    std::vector<std::string> argv = {"printf", "done"};
+    ProcessResult result = ProcessExecutor::execute(argv, options);
+
+    EXPECT_FALSE(result.timedOut);
+    EXPECT_EQ(result.exitCode, 0);
+    EXPECT_EQ(result.output, "done");
+}
+
+TEST(TimeoutEnforcement, ReactorTimeout) {
+    ProcessReactor reactor;
+    ProcessOptions options = limitedOptions();
+    options.timeout = std::chrono::milliseconds(300);
+
+    std::vector<std::string> slow = {"sh", "-c", "sleep 30 & sleep 30"};
+    std::vector<std::string> fast = {"sh", "-c", "sleep 0.1; printf ok"};
+    ProcessHandle slowHandle = reactor.start(slow, options);
+    ProcessHandle fastHandle = reactor.start(fast, options);
+
+    auto start = Clock::now();
+    ProcessResult fastResult = fastHandle.wait();
+    ProcessResult slowResult = slowHandle.wait();
+
+    EXPECT_FALSE(fastResult.timedOut);
+    EXPECT_EQ(fastResult.output, "ok");
+    EXPECT_TRUE(slowResult.timedOut);
+    EXPECT_LT(Clock::now() - start, std::chrono::seconds(5));
+}
+#endif
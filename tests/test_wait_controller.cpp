@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <WaitController.h>
+#include <GemStackCore.h>
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST(WaitControllerTest, ShortWaitElapses) {
+    WaitController waits;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(waits.waitFor(30ms), WaitOutcome::Elapsed);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 30ms);
+}
+
+TEST(WaitControllerTest, CancelEndsWaitAtOnce) {
+    WaitController waits;
+    std::thread stopper([&waits]() {
+        std::this_thread::sleep_for(50ms);
+        waits.cancel();
+    });
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(waits.waitFor(60s), WaitOutcome::Cancelled);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 10s);
+    stopper.join();
+
+    // Later waits don't block at all until reset
+    EXPECT_TRUE(waits.cancelled());
+    EXPECT_EQ(waits.waitFor(60s, true), WaitOutcome::Cancelled);
+    waits.reset();
+    EXPECT_FALSE(waits.cancelled());
+    EXPECT_EQ(waits.waitFor(1ms), WaitOutcome::Elapsed);
+}
+
+TEST(WaitControllerTest, WakeEndsOnlyInterruptibleWaits) {
+    WaitController waits;
+    WaitOutcome idle = WaitOutcome::Elapsed;
+    std::thread cooldown([&waits, &idle]() { idle = waits.waitFor(60s, true); });
+    std::this_thread::sleep_for(50ms);
+
+    auto start = std::chrono::steady_clock::now();
+    waits.wake();
+    cooldown.join();
+    EXPECT_EQ(idle, WaitOutcome::Woken);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 10s);
+
+    // A quota wait runs its course; a wake before it started doesn't count either
+    std::thread waker([&waits]() {
+        std::this_thread::sleep_for(10ms);
+        waits.wake();
+    });
+    start = std::chrono::steady_clock::now();
+    EXPECT_EQ(waits.waitFor(100ms), WaitOutcome::Elapsed);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 100ms);
+    waker.join();
+}
+
+class ShutdownTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        g_config = getDefaultConfig();
+        resetCooldownSleeper();
+        applyCooldownCliOverrides(std::nullopt, std::nullopt);
+        resetShutdown();
+    }
+
+    void TearDown() override {
+        g_config = getDefaultConfig();
+        applyCooldownCliOverrides(std::nullopt, std::nullopt);
+        configureRateLimits();
+        resetShutdown();
+    }
+};
+
+TEST_F(ShutdownTest, QueuedWorkCutsCooldownShort) {
+    applyCooldownCliOverrides(true, 60);
+    std::thread typed([]() {
+        std::this_thread::sleep_for(50ms);
+        wakeIdleWaits();
+    });
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(performCooldown());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 10s);
+    typed.join();
+}
+
+TEST_F(ShutdownTest, ShutdownEndsRateLimitWaitsAndSkipsCooldown) {
+    g_config.requestsPerMinute = 1;  // One request a minute: the second waits 60 seconds
+    configureRateLimits();
+    EXPECT_FALSE(waitForModelBudget("gemini-2.5-pro"));
+
+    std::thread stopper([]() {
+        std::this_thread::sleep_for(50ms);
+        requestShutdown();
+    });
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(waitForModelBudget("gemini-2.5-pro"));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 10s);
+    stopper.join();
+    EXPECT_TRUE(isShutdownRequested());
+
+    applyCooldownCliOverrides(true, 60);
+    EXPECT_FALSE(performCooldown());
+}
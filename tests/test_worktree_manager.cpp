@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include <WorktreeManager.h>
+#include <GitAutoCommit.h>
+#include <TaskGraph.h>
+#include <filesystem>
+#include <fstream>
+#include <cstdlib>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// ============================================================================
+// Test Fixture - throwaway repository with one commit
+// ============================================================================
+
+class WorktreeManagerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+#ifdef _WIN32
+        if (system("git --version >nul 2>&1") != 0) {
+#else
+        if (system("git --version >/dev/null 2>&1") != 0) {
+#endif
+            GTEST_SKIP() << "git not available";
+        }
+
+        repoDir = (fs::temp_directory_path() / ("gemstack_worktree_test_" + std::to_string(counter++))).string();
+        fs::remove_all(repoDir);
+        fs::create_directories(repoDir);
+
+        git("init -q");
+        git("config user.email test@example.com");
+        git("config user.name GemStackTest");
+        writeFile(repoDir + "/shared.txt", "base\n");
+        git("add -A");
+        git("commit -q -m initial");
+    }
+
+    void TearDown() override {
+        if (!repoDir.empty()) {
+            std::error_code ec;
+            fs::remove_all(repoDir, ec);
+        }
+    }
+
+    int git(const std::string& args, const std::string& dir = "") {
+        std::string command = GitAutoCommit::gitCommand(args, dir.empty() ? repoDir : dir);
+#ifdef _WIN32
+        command += " >nul 2>&1";
+#else
+        command += " >/dev/null 2>&1";
+#endif
+        return system(command.c_str());
+    }
+
+    static void writeFile(const std::string& path, const std::string& content) {
+        std::ofstream file(path, std::ios::trunc);
+        file << content;
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream file(path);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    std::string repoDir;
+    static int counter;
+};
+
+int WorktreeManagerTest::counter = 0;
+
+// ============================================================================
+// Isolation and Merge Tests
+// ============================================================================
+
+TEST_F(WorktreeManagerTest, EachBlockGetsItsOwnWorktree) {
+    WorktreeManager manager(repoDir);
+    ASSERT_TRUE(manager.initialize());
+
+    auto first = manager.acquire(1, "backend");
+    auto second = manager.acquire(2);
+    ASSERT_TRUE(first.has_value());
+    ASSERT_TRUE(second.has_value());
+    EXPECT_NE(*first, *second);
+    EXPECT_TRUE(fs::exists(*first + "/shared.txt"));
+
+    // Acquiring again returns the same worktree
+    EXPECT_EQ(manager.acquire(1, "backend"), first);
+}
+
+TEST_F(WorktreeManagerTest, MergesInBlockOrder) {
+    WorktreeManager manager(repoDir);
+    ASSERT_TRUE(manager.initialize());
+    manager.setBlocks({1, 2});
+
+    std::string first = *manager.acquire(1);
+    std::string second = *manager.acquire(2);
+    writeFile(first + "/one.txt", "one\n");
+    writeFile(second + "/two.txt", "two\n");
+
+    // Block 2 finishing first must wait for block 1
+    EXPECT_TRUE(manager.finishBlock(2, true).empty());
+    EXPECT_FALSE(fs::exists(repoDir + "/two.txt"));
+
+    auto results = manager.finishBlock(1, true);
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].block, 1);
+    EXPECT_EQ(results[1].block, 2);
+    EXPECT_TRUE(results[0].merged);
+    EXPECT_TRUE(results[1].merged);
+    EXPECT_TRUE(fs::exists(repoDir + "/one.txt"));
+    EXPECT_TRUE(fs::exists(repoDir + "/two.txt"));
+}
+
+TEST_F(WorktreeManagerTest, ReportsConflicts) {
+    WorktreeManager manager(repoDir);
+    ASSERT_TRUE(manager.initialize());
+    manager.setBlocks({1, 2});
+
+    std::string first = *manager.acquire(1);
+    std::string second = *manager.acquire(2);
+    writeFile(first + "/shared.txt", "from block one\n");
+    writeFile(second + "/shared.txt", "from block two\n");
+
+    manager.finishBlock(1, true);
+    auto results = manager.finishBlock(2, true);
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_TRUE(results[0].conflict);
+    EXPECT_FALSE(results[0].merged);
+
+    // Main checkout keeps block 1's version; block 2's branch is kept for manual resolution
+    EXPECT_EQ(readFile(repoDir + "/shared.txt"), "from block one\n");
+    EXPECT_EQ(git("rev-parse --verify --quiet refs/heads/" + results[0].branch), 0);
+}
+
+TEST_F(WorktreeManagerTest, FailedBlockIsNotMerged) {
+    WorktreeManager manager(repoDir);
+    ASSERT_TRUE(manager.initialize());
+
+    std::string path = *manager.acquire(1);
+    writeFile(path + "/partial.txt", "partial\n");
+
+    auto results = manager.finishBlock(1, false);
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_FALSE(results[0].merged);
+    EXPECT_FALSE(fs::exists(repoDir + "/partial.txt"));
+}
+
+TEST_F(WorktreeManagerTest, RebaseStrategy) {
+    WorktreeManager manager(repoDir, WorktreeMergeStrategy::Rebase);
+    ASSERT_TRUE(manager.initialize());
+    manager.setBlocks({1, 2});
+
+    std::string first = *manager.acquire(1);
+    std::string second = *manager.acquire(2);
+    writeFile(first + "/one.txt", "one\n");
+    writeFile(second + "/two.txt", "two\n");
+
+    manager.finishBlock(1, true);
+    auto results = manager.finishBlock(2, true);
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_TRUE(results[0].merged);
+    EXPECT_TRUE(fs::exists(repoDir + "/one.txt"));
+    EXPECT_TRUE(fs::exists(repoDir + "/two.txt"));
+}
+
+TEST_F(WorktreeManagerTest, DependentBlockStartsFromMergedUpstream) {
+    // Block 1 (B) is 'after' block 2 (A)
+    TaskGraph graph;
+    TaskSpec blockB;
+    blockB.command = "prompt \"B\"";
+    blockB.block = 1;
+    blockB.blockId = "b";
+    blockB.after = {"a"};
+    TaskSpec blockA;
+    blockA.command = "prompt \"A\"";
+    blockA.block = 2;
+    blockA.blockId = "a";
+    graph.addTasks({blockB, blockA});
+    graph.holdBlockDependents(true);
+
+    WorktreeManager manager(repoDir);
+    ASSERT_TRUE(manager.initialize());
+    manager.setBlocks(graph.blockOrder());
+
+    // A runs and commits in its worktree
+    ASSERT_EQ(graph.acquire(), std::optional<size_t>(1));
+    std::string first = *manager.acquire(2, "a");
+    writeFile(first + "/a.txt", "from block a\n");
+    git("add -A", first);
+    git("commit -q -m block-a", first);
+    git("tag block-a-done", first);
+    graph.complete(1, true);
+
+    // B is held until A has merged
+    EXPECT_EQ(graph.state(0), TaskState::Pending);
+    auto results = manager.finishBlock(2, true);
+    ASSERT_EQ(results.size(), 1u);
+    ASSERT_TRUE(results[0].merged);
+    graph.releaseBlock(2, true);
+    ASSERT_EQ(graph.state(0), TaskState::Ready);
+
+    ASSERT_EQ(graph.acquire(), std::optional<size_t>(0));
+    std::string second = *manager.acquire(1, "b");
+    EXPECT_EQ(readFile(second + "/a.txt"), "from block a\n");
+    EXPECT_EQ(git("merge-base --is-ancestor block-a-done HEAD", second), 0);
+}
+
+TEST(WorktreeMergeStrategyParsing, ParsesValues) {
+    EXPECT_EQ(parseWorktreeMergeStrategy("rebase"), WorktreeMergeStrategy::Rebase);
+    EXPECT_EQ(parseWorktreeMergeStrategy("merge"), WorktreeMergeStrategy::Merge);
+    EXPECT_EQ(parseWorktreeMergeStrategy("unknown"), WorktreeMergeStrategy::Merge);
+}